@@ -3,26 +3,59 @@
 #include "cmsis_os.h"
 
 #include "motors_driver.h"
-#include "base_board_interrupts_config.h"
+#include "hr_timer.h"
+#include "slab.h"
+#include "orientation_link.h"
+#include "tdma.h"
 
 #include "wireless_cc2500.h"
 #include <stdio.h>
+#ifdef BENCHMARK
+#include "benchmark.h"
+#endif
+#if (defined(OS_MONITOR) && (OS_MONITOR != 0)) || (defined(OS_TELEMETRY) && (OS_TELEMETRY != 0))
+#include "thread_monitor.h"
+
+osThreadDef(monitor_thread, osPriorityLow, 1, MONITOR_STACK_SIZE);
+#endif
 
-#define MOTOR_MOVE_SIGNAL 0x01
 #define WIRELESS_SIGNAL 	0x02
 
-#define MOTOR_MESSAGE_QUEUE_SIZE 1000
-#define INTERPOLATOR_MESSAGE_QUEUE_SIZE 1000
+#define MOTOR_PERIOD 5	//in ms, the kernel releases one motor step per period
+
+#define WIRELESS_POLL_PERIOD 10000 //in us
+#define WIRELESS_MIN_PACKET (1 + 1 + LINK_DELTA_SIZE + 2)	//length byte, address byte, smallest payload and 2 status bytes in the RX FIFO
+#define WIRELESS_MAX_PAYLOAD 10	//PKTLEN, the radio drops longer packets
+#define WIRELESS_SERVO_SETS 1	//servo sets on this board, driven by the remote boards in the first TDMA slots
+#define WIRELESS_MCSM1 0x3f	//the radio returns to RX after sending telemetry or a beacon
+#define WIRELESS_SEARCH_POLLS 150	//polls (1.5 s, three remote keepalives) without a packet before trying the next radio profile
+#define WIRELESS_WOR_POLLS (CC2500_WOR_AWAKE * 1000 / WIRELESS_POLL_PERIOD)	//polls without a packet before going back to wake-on-radio
+
+//Messages come from the shared slab allocator: both queues plus one motor batch must fit in SLAB_BLOCKS_4,
+//so a full queue blocks the sender before an allocation can fail
+#define MOTOR_MESSAGE_QUEUE_SIZE 56
+#define INTERPOLATOR_MESSAGE_QUEUE_SIZE 16
+#define MOTOR_MESSAGE_BATCH_SIZE 16	//interpolated steps sent with one osMessagePutN
 
-int motorPeriod = BASEBOARD_TIM2_PERIOD;
+int motorPeriod = MOTOR_PERIOD * 1000; //in us
+
+//Telemetry for the remote board (orientation_link.h), byte writes so no locking is needed
+static volatile int8_t commandedRoll = 0;
+static volatile int8_t commandedPitch = 0;
+static volatile uint8_t motorDropped = 0;
+static volatile uint8_t interpolatorDropped = 0;
+static volatile uint8_t lost = 0;
+
+#if TDMA_ENABLE != 0
+//The beacons are the only timing of the remote boards: the base board has to listen all the time
+typedef char tdma_without_wake_on_radio[(CC2500_WOR_PERIOD == 0)? 1: -1];
+#endif
 
 typedef struct {                               
 	int8_t rollAngle;
 	int8_t pitchAngle;
 } Motor_message;
 
-osPoolDef(motor_pool, MOTOR_MESSAGE_QUEUE_SIZE, Motor_message);                    // Define memory pool queue size 16 for now
-osPoolId motor_pool;
 osMessageQDef(motor_message_box, MOTOR_MESSAGE_QUEUE_SIZE, Motor_message);   //queue size 16 arbitrarily for now (queue should theoretically never get full)
 osMessageQId motor_message_box;
 
@@ -33,8 +66,6 @@ typedef struct {
 	int8_t realtime; //is it realtime mode or not
 } Interpolator_message;
 
-osPoolDef(interpolator_pool, INTERPOLATOR_MESSAGE_QUEUE_SIZE, Interpolator_message);                    // Define memory pool queue size 16 for now
-osPoolId interpolator_pool;
 osMessageQDef(interpolator_message_box, INTERPOLATOR_MESSAGE_QUEUE_SIZE, Interpolator_message);   //queue size 16 arbitrarily for now (queue should theoretically never get full)
 osMessageQId interpolator_message_box;
 
@@ -48,13 +79,63 @@ osThreadDef(wireless_thread, osPriorityNormal, 1, 0);
 
 osThreadId tid_motor, tid_interpolator, tid_wireless;
 
-void TIM2_IRQHandler(void);
-void read_wireless_message(Interpolator_message *m);
-void wireless_timer_callback(void const *arg);
+int read_wireless_packet(uint8_t *packet, int8_t *numBytes);
+
+/*!
+ Rebuild a keypad waypoint or a realtime position from a packet payload. Returns 0 on success, -1 if the
+ payload was dropped (corrupted, or a delta after a lost packet).
+ @param[in,out] link The realtime stream of the sender
+ @param[in] payload The payload, after the address byte
+ @param[in] length The payload length
+ @param[out] message Receives the message
+ */
+int decode_wireless_message(Link_decoder *link, const uint8_t *payload, int length, Interpolator_message *message);
+
+/*!
+ Send a message to the interpolator thread, dropped if message memory ran out
+ @param[in] message The message
+ */
+void forward_wireless_message(const Interpolator_message *message);
+
+/*!
+ Answer a telemetry request. Blocks the wireless thread for LINK_TELEMETRY_DELAY frames.
+ @param[in] address The address of the remote board that asked
+ */
+void send_telemetry(uint8_t address);
+
+void wireless_timer_callback(void *arg);
 
+#if TDMA_ENABLE != 0
+/*!
+ Be the TDMA master (tdma.h): beacon every superframe, give slots to the remote boards and read their
+ packets. Does not return.
+ */
+void wireless_tdma(void);
+#endif
 
-osTimerDef (wireless_timer, wireless_timer_callback); 
-osTimerId wireless_timer_id;
+#if CC2500_WOR_PERIOD != 0
+/*!
+ Stop polling and leave the radio in wake-on-radio until a packet arrives. Returns 1 if woken by a packet,
+ 0 if nothing came for WIRELESS_SEARCH_POLLS poll periods, -1 if the radio did not go idle to sleep. The radio
+ is in continuous RX on return unless it did not go idle again to wake up.
+ */
+int wireless_sleep(void);
+
+/*!
+ ISR for external 10 to 15: end of a packet received in wake-on-radio
+ */
+void EXTI15_10_IRQHandler(void);
+#endif
+
+#ifdef BENCHMARK
+/*!
+ Time the base board hot functions and print the JSON report. Runs before the kernel threads start.
+ */
+void run_benchmarks(void);
+#endif
+
+
+HR_timer wireless_timer;
 
 /*!
  @brief Program entry point
@@ -64,25 +145,42 @@ int main (void)
 	init_motors();
 	move_to_angles(0, 0);
 	
+#ifdef BENCHMARK
+	run_benchmarks();
+#endif
+	
 	osDelay(3000);
 
-	baseboard_tim2_interrupt_config();
+	hr_timer_init();
 	
-	wireless_timer_id = osTimerCreate (osTimer(wireless_timer), osTimerPeriodic, NULL);
-	osTimerStart(wireless_timer_id, 10);
-	
-	//initialize OS pools
-	motor_pool = osPoolCreate(osPool(motor_pool));                 // create memory pool
+	//initialize message memory and queues
+	slab_init();
   motor_message_box = osMessageCreate(osMessageQ(motor_message_box), NULL);  // create msg queue
 	
-	interpolator_pool = osPoolCreate(osPool(interpolator_pool));                 // create memory pool
   interpolator_message_box = osMessageCreate(osMessageQ(interpolator_message_box), NULL);  // create msg queue
 	
+	//poll the radio from the microsecond timer service; with TDMA the wireless thread times each superframe
+	hr_timer_create(&wireless_timer, wireless_timer_callback, NULL);
+	
 	//start threads
 	tid_motor = osThreadCreate(osThread(motor_thread), NULL);
 	tid_interpolator = osThreadCreate(osThread(interpolator_thread), NULL);
 	tid_wireless = osThreadCreate(osThread(wireless_thread), NULL);
 	
+#if TDMA_ENABLE == 0
+	hr_timer_start(&wireless_timer, WIRELESS_POLL_PERIOD, WIRELESS_POLL_PERIOD);
+#endif
+	
+#if (defined(OS_MONITOR) && (OS_MONITOR != 0)) || (defined(OS_TELEMETRY) && (OS_TELEMETRY != 0))
+	monitor_add(osThreadGetId(), "main");
+	monitor_add(tid_motor, "motor");
+	monitor_add(tid_interpolator, "interpolator");
+	monitor_add(tid_wireless, "wireless");
+	monitor_add_queue(motor_message_box, "motor");
+	monitor_add_queue(interpolator_message_box, "interpolator");
+	osThreadCreate(osThread(monitor_thread), NULL);
+#endif
+	
 	// The below doesn't really need to be in a loop
 	while(1){
 		osDelay(osWaitForever);
@@ -95,11 +193,16 @@ void motor_thread(const void* arg)
 	Motor_message  *motor_m;
   osEvent event;
 	
+	//motor steps are released by the kernel, above the other threads so their jitter stays within a tick
+	osThreadSetPeriod(osThreadGetId(), MOTOR_PERIOD, MOTOR_PERIOD);
+	osThreadRateMonotonic(osPriorityAboveNormal);
+	
 	while(1)
 	{
-		osSignalWait(MOTOR_MOVE_SIGNAL, osWaitForever); //wait until it is time to move motor
+		osThreadWaitPeriod(); //wait until it is time to move motor, misses are counted by the kernel
 		
-		event = osMessageGet(motor_message_box, osWaitForever);  // wait for message
+		//never block inside a job: with no step queued the motors simply hold their position
+		event = osMessageGet(motor_message_box, 0);
 		
     if (event.status == osEventMessage)
 		{
@@ -107,8 +210,10 @@ void motor_thread(const void* arg)
 			
 			//move motors according to message received
 			move_to_angles(-motor_m->rollAngle, motor_m->pitchAngle);
+			commandedRoll = motor_m->rollAngle;
+			commandedPitch = motor_m->pitchAngle;
 			
-      osPoolFree(motor_pool, motor_m);                  // free memory allocated for message
+      slab_free(motor_m);                  // free memory allocated for message
     }
 	}
 }
@@ -120,6 +225,8 @@ void interpolator_thread(const void* arg)
 	Motor_message *motor_m;
 	osEvent event;
 	
+	uint32_t batch[MOTOR_MESSAGE_BATCH_SIZE];
+	int batchSize = 0;
 	int numMotorMessages;
 	int i;
 	
@@ -145,14 +252,21 @@ void interpolator_thread(const void* arg)
 			//If real time mode, ignore delta t and forward message to motor thread
 			if (interpolator_m->realtime)
 			{
-				motor_m = osPoolAlloc(motor_pool);                     // Allocate memory for the message
-				motor_m->rollAngle = interpolator_m->rollAngle;
-				motor_m->pitchAngle = interpolator_m->pitchAngle;
+				motor_m = slab_alloc(sizeof(Motor_message));                     // Allocate memory for the message
+				if (motor_m != NULL)
+				{
+					motor_m->rollAngle = interpolator_m->rollAngle;
+					motor_m->pitchAngle = interpolator_m->pitchAngle;
+					
+					osMessagePut(motor_message_box, (uint32_t)motor_m, osWaitForever);  // Send Message
+				}
+				else
+				{
+					motorDropped++;
+				}
 				
 				prevRollAngle = rollAngle;
 				prevPitchAngle = pitchAngle;
-				
-				osMessagePut(motor_message_box, (uint32_t)motor_m, osWaitForever);  // Send Message
 			}
 			//else if keypad mode interpolate
 			else
@@ -170,26 +284,49 @@ void interpolator_thread(const void* arg)
 					rollAngle = ceil(rollAngleStart + i*rollAngleIncrement);
 					pitchAngle = ceil(pitchAngleStart + i*pitchAngleIncrement);
 					
-					motor_m = osPoolAlloc(motor_pool);                     // Allocate memory for the message
+					motor_m = slab_alloc(sizeof(Motor_message));                     // Allocate memory for the message
+					if (motor_m == NULL)
+					{
+						motorDropped += numMotorMessages - i;
+						break; //out of message memory, skip the rest of the interpolation
+					}
 					motor_m->rollAngle = rollAngle;
 					motor_m->pitchAngle = pitchAngle;
 					
 					prevRollAngle = rollAngle;
 					prevPitchAngle = pitchAngle;
 					
+					//Send the steps in batches, one kernel entry per batch
+					batch[batchSize++] = (uint32_t)motor_m;
+					if (batchSize == MOTOR_MESSAGE_BATCH_SIZE)
+					{
+						osMessagePutN(motor_message_box, batch, batchSize, osWaitForever);
+						batchSize = 0;
+					}
+				}
+				if (batchSize != 0)
+				{
+					osMessagePutN(motor_message_box, batch, batchSize, osWaitForever);
+					batchSize = 0;
+				}
+				motor_m = slab_alloc(sizeof(Motor_message));                     // Allocate memory for the message
+				if (motor_m != NULL)
+				{
+					motor_m->rollAngle = interpolator_m->rollAngle;
+					motor_m->pitchAngle = interpolator_m->pitchAngle;
+					
 					osMessagePut(motor_message_box, (uint32_t)motor_m, osWaitForever);  // Send Message
 				}
-				motor_m = osPoolAlloc(motor_pool);                     // Allocate memory for the message
-				motor_m->rollAngle = interpolator_m->rollAngle;
-				motor_m->pitchAngle = interpolator_m->pitchAngle;
+				else
+				{
+					motorDropped++;
+				}
 				
 				prevRollAngle = rollAngle;
 				prevPitchAngle = pitchAngle;
-				
-				osMessagePut(motor_message_box, (uint32_t)motor_m, osWaitForever);  // Send Message
 			}
 			
-      osPoolFree(interpolator_pool, interpolator_m);                  // free memory allocated for message
+      slab_free(interpolator_m);                  // free memory allocated for message
     }
 	}
 }
@@ -197,74 +334,392 @@ void interpolator_thread(const void* arg)
 //Wireless thread: responsible for receiving instructions from other board
 void wireless_thread(const void* arg)
 {
-	Interpolator_message *interpolator_m;
+	Interpolator_message message;
+	uint8_t packet[WIRELESS_MAX_PAYLOAD];
+	Link_decoder link;
+	int length;
+	int silent = 0;
+#if CC2500_WOR_PERIOD != 0
+	int woken;
+#endif
 	int8_t numBytes;
 	int8_t state;
 	
+	int8_t mcsm1 = WIRELESS_MCSM1;
+	
 	//initialize wireless
 	CC2500_Init();
-	CC2500_CmdStrobe(SRX);
+	CC2500_Write_Reg(&mcsm1, MCSM1_WRITE_SINGLE, 1);
+#if TDMA_ENABLE != 0
+	wireless_tdma();
+#endif
+	CC2500_Enter(SRX);
+	link_decoder_init(&link);
 	
 	while(1)
 	{
+#if CC2500_WOR_PERIOD != 0
+		//Nothing heard while awake: sleep, and look for the remote board if it stays silent
+		if (silent >= WIRELESS_WOR_POLLS && silent < WIRELESS_SEARCH_POLLS)
+		{
+			woken = wireless_sleep();
+			silent = (woken == 0)? WIRELESS_SEARCH_POLLS: 0;
+			if (woken < 0)
+			{
+				osSignalWait(WIRELESS_SIGNAL, osWaitForever);	//the radio would not sleep: poll for another WIRELESS_WOR_POLLS
+			}
+		}
+		else
+		{
+			osSignalWait(WIRELESS_SIGNAL, osWaitForever);
+		}
+#else
 		osSignalWait(WIRELESS_SIGNAL, osWaitForever);
+#endif
 		
 		//wait for wireless receive
 		CC2500_Read_Reg(&numBytes, RXBYTES, 1);
-		numBytes = numBytes & 0x7f;
 		CC2500_Read_Reg(&state, MARCSTATE, 1);
-		printf("State: %x, numBytes: %d\n", state, numBytes);
+		printf("State: %x, numBytes: %d\n", state, numBytes & 0x7f);
 		
-		//printf("State: %x\n", state);
-		//osDelay(1);
-		if(numBytes > 7)
+		//RX FIFO overflow: the radio stopped receiving, flush and listen again
+		if (numBytes & 0x80)
 		{
-			int8_t junk;
-			
-			CC2500_ReadFIFO(&junk, FIFO_READ_BURST_ADDRESS, numBytes);
+			CC2500_CmdStrobe(SFRX);
+			CC2500_Enter(SRX);
+			continue;
 		}
-		else if (numBytes == 7)
+		
+		//Nothing heard for a while: the remote board may have switched profile without us, look for it
+		if (silent >= WIRELESS_SEARCH_POLLS)
 		{
-			interpolator_m = osPoolAlloc(interpolator_pool);                     // Allocate memory for the message
-			read_wireless_message(interpolator_m);
+			//A radio that did not go idle keeps its profile, try again on the next poll
+			silent = (CC2500_SetProfile((CC2500_Rate)((CC2500_GetProfile() + 1) % CC2500_PROFILE_COUNT)) == 0)?
+				0: WIRELESS_SEARCH_POLLS;
+			CC2500_Enter(SRX);
+			continue;
+		}
+		silent++;
 		
-			printf("to interp: roll: %d pitch: %d delta_t: %d realtime: %d\n", interpolator_m->rollAngle, interpolator_m->pitchAngle, interpolator_m->delta_t, interpolator_m->realtime);
+		//printf("State: %x\n", state);
+		//osDelay(1);
+		//The remote board sends keypad programs in bursts: read every complete packet
+		while (numBytes >= WIRELESS_MIN_PACKET)
+		{
+			length = read_wireless_packet(packet, &numBytes);
+			if (length < 0)
+			{
+				//Not one of our packets, nothing after it can be parsed: drop the FIFO
+				CC2500_CmdStrobe(SIDLE);
+				CC2500_CmdStrobe(SFRX);
+				CC2500_Enter(SRX);
+				break;
+			}
+			if (length == 0)
+			{
+				lost++;
+				continue;	//failed its CRC
+			}
+			silent = 0;
 			
-			osMessagePut(interpolator_message_box, (uint32_t)interpolator_m, osWaitForever);  // Send Message
-		}		
+			//packet[0] is the address of the sender, there is only one remote board
+			if (length == 1 + LINK_CONTROL_SIZE && packet[1] == LINK_CONTROL)
+			{
+				//Profile switch: the remote board follows once its copies are on the air
+				if (packet[2] == LINK_SET_PROFILE && packet[3] < CC2500_PROFILE_COUNT && packet[3] != CC2500_GetProfile())
+				{
+					//Otherwise the search finds the remote board on its new profile
+					if (CC2500_SetProfile((CC2500_Rate)packet[3]) != 0)
+					{
+						printf("Radio did not go idle for profile %d\n", packet[3]);
+					}
+					CC2500_Enter(SRX);
+					break;	//the FIFO was flushed
+				}
+				if (packet[2] == LINK_REQUEST_TELEMETRY)
+				{
+					send_telemetry(packet[0]);
+				}
+#if CC2500_WOR_PERIOD != 0
+				//An idle keepalive woke us for nothing: sleep again instead of staying awake CC2500_WOR_AWAKE
+				if (packet[2] == LINK_KEEPALIVE && packet[3] == LINK_IDLE)
+				{
+					silent = WIRELESS_WOR_POLLS;
+				}
+#endif
+				continue;	//keepalive, or another copy
+			}
+			if (decode_wireless_message(&link, packet + 1, length - 1, &message) == 0)
+			{
+				forward_wireless_message(&message);
+			}
+			else
+			{
+				lost++;
+			}
+		}
+	}
+}
+
+int decode_wireless_message(Link_decoder *link, const uint8_t *payload, int length, Interpolator_message *message)
+{
+	if (length == sizeof(Interpolator_message) && payload[3] == 0)
+	{
+		//Keypad waypoint, sent as is
+		*message = *(const Interpolator_message *)payload;
+		return 0;
+	}
+	if (link_decode(link, payload, length, &message->rollAngle, &message->pitchAngle) == 0)
+	{
+		//Realtime position rebuilt from a full message or a delta
+		message->delta_t = 0;
+		message->realtime = 1;
+		return 0;
 	}
+	return -1;
+}
+
+void forward_wireless_message(const Interpolator_message *message)
+{
+	Interpolator_message *interpolator_m;
+	
+	interpolator_m = slab_alloc(sizeof(Interpolator_message));                     // Allocate memory for the message
+	if (interpolator_m == NULL)
+	{
+		interpolatorDropped++;
+		return;	//Out of message memory: drop it
+	}
+	*interpolator_m = *message;
+	
+	printf("to interp: roll: %d pitch: %d delta_t: %d realtime: %d\n", interpolator_m->rollAngle, interpolator_m->pitchAngle, interpolator_m->delta_t, interpolator_m->realtime);
+	
+	osMessagePut(interpolator_message_box, (uint32_t)interpolator_m, osWaitForever);  // Send Message
 }
 
-// Timer 2 interrupt for motor movement
-void TIM2_IRQHandler() {
-    osSignalSet(tid_motor, MOTOR_MOVE_SIGNAL);
-    TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
+void send_telemetry(uint8_t address)
+{
+	Link_telemetry t;
+	uint8_t packet[1 + 1 + LINK_TELEMETRY_SIZE];
+	uint32_t motorQueue = osMessageCount(motor_message_box);
+	uint32_t interpolatorQueue = osMessageCount(interpolator_message_box);
+	
+	t.rollAngle = commandedRoll;
+	t.pitchAngle = commandedPitch;
+	t.motorQueue = (motorQueue > 255)? 255: motorQueue;
+	t.interpolatorQueue = (interpolatorQueue > 255)? 255: interpolatorQueue;
+	t.motorDropped = motorDropped;
+	t.interpolatorDropped = interpolatorDropped;
+	t.lost = lost;
+	
+	packet[0] = 1 + LINK_TELEMETRY_SIZE;
+	packet[1] = address;
+	link_telemetry_encode(&t, packet + 2);
+	
+	//The remote board listens once its request is on the air; the radio returns to RX after the answer
+	osDelay(LINK_TELEMETRY_DELAY * (CC2500_Profiles[CC2500_GetProfile()].frameTime / 1000 + 1) + 1);
+	CC2500_WriteFIFO((int8_t *)packet, FIFO_WRITE_BURST_ADDRESS, sizeof(packet));
+	CC2500_Enter(STX);
+}
+
+#if TDMA_ENABLE != 0
+void wireless_tdma()
+{
+	Tdma_master master;
+	Link_decoder links[TDMA_SLOTS];
+	Interpolator_message message;
+	uint8_t packet[WIRELESS_MAX_PAYLOAD];
+	uint8_t beacon[1 + 1 + TDMA_BEACON_SIZE];
+	uint32_t superframe;
+	int8_t numBytes;
+	int length;
+	int slot;
+	int i;
+	
+	//Receive from every remote board; WIRELESS_MCSM1 goes back to RX after each beacon so no slot is missed
+	CC2500_SetAddress(TDMA_BROADCAST, CC2500_ADR_CHK_NONE);
+	CC2500_Enter(SRX);
+	
+	tdma_master_init(&master, tdma_slot_time(CC2500_Profiles[CC2500_GetProfile()].frameTime));
+	superframe = tdma_superframe_time(master.beacon.slotTime);
+	for (i = 0; i < TDMA_SLOTS; i++)
+	{
+		link_decoder_init(&links[i]);
+	}
+	
+	//A late beacon delays the whole superframe; above the motor thread it is rarely late
+	osThreadSetPriority(osThreadGetId(), osPriorityHigh);
+	
+	while(1)
+	{
+		//Every slot of the last superframe is over: read what the remote boards sent
+		CC2500_Read_Reg(&numBytes, RXBYTES, 1);
+		if (numBytes & 0x80)
+		{
+			CC2500_CmdStrobe(SFRX);
+			CC2500_Enter(SRX);
+			numBytes = 0;
+		}
+		while (numBytes >= WIRELESS_MIN_PACKET)
+		{
+			length = read_wireless_packet(packet, &numBytes);
+			if (length < 0)
+			{
+				CC2500_CmdStrobe(SIDLE);
+				CC2500_CmdStrobe(SFRX);
+				CC2500_Enter(SRX);
+				break;
+			}
+			if (length == 0)
+			{
+				lost++;
+				continue;
+			}
+			
+			//packet[0] is the address of the sender
+			slot = tdma_master_heard(&master, packet[0]);
+			if (length == 1 + LINK_CONTROL_SIZE && packet[1] == LINK_CONTROL)
+			{
+				//Join request: a new owner starts its stream with a full message
+				if (packet[2] == LINK_JOIN && slot < 0 && (slot = tdma_master_join(&master, packet[0])) >= 0)
+				{
+					link_decoder_init(&links[slot]);
+					printf("remote %d joined slot %d\n", packet[0], slot);
+				}
+				continue;	//keepalive; profile switches and telemetry are not served with TDMA
+			}
+			if (slot < 0 || decode_wireless_message(&links[slot], packet + 1, length - 1, &message) != 0)
+			{
+				continue;	//not the owner of a slot, or dropped
+			}
+			
+			if (slot < WIRELESS_SERVO_SETS)
+			{
+				forward_wireless_message(&message);
+			}
+		}
+		
+		tdma_master_next(&master);
+		length = tdma_beacon_encode(&master.beacon, beacon + 2);
+		beacon[0] = 1 + length;
+		beacon[1] = TDMA_BROADCAST;
+		CC2500_WriteFIFO((int8_t *)beacon, FIFO_WRITE_BURST_ADDRESS, 2 + length);
+		CC2500_Enter(STX);
+		
+		//The remote boards time their slots from the end of this beacon
+		hr_timer_start(&wireless_timer, superframe, 0);
+		osSignalWait(WIRELESS_SIGNAL, osWaitForever);
+	}
 }
+#endif
 
-//Read wireless message from wireless chip
-void read_wireless_message(Interpolator_message *m)
+/* Read one packet from the RX FIFO into packet, numBytes is the FIFO level and is updated.
+ * Returns the payload length, 0 if the packet failed its CRC, -1 if the FIFO can't be parsed. */
+int read_wireless_packet(uint8_t *packet, int8_t *numBytes)
 {
 	int8_t packetSize;
-	int8_t junk;
+	int8_t status[2];
+	int tries;
+	//Two frames of air time in msec: the longest payload takes a little more than a full message
+	int limit = 2 + 2 * CC2500_Profiles[CC2500_GetProfile()].frameTime / 1000;
 	
 	CC2500_ReadFIFO(&packetSize, FIFO_READ_ADDRESS, 1);
-	//osDelay(1);
-	//CC2500_CmdStrobe(SRX);
-	//osDelay(1);
-	
-	CC2500_ReadFIFO((int8_t*)m, FIFO_READ_BURST_ADDRESS, sizeof(Interpolator_message));		
-	//osDelay(1);
-	//CC2500_CmdStrobe(SRX);
-	//osDelay(1);
-	
-	CC2500_ReadFIFO(&junk, FIFO_READ_BURST_ADDRESS, 2);
-	//osDelay(1);
-	//CC2500_CmdStrobe(SRX);
-	//osDelay(1);
+	if (packetSize <= 0 || packetSize > WIRELESS_MAX_PAYLOAD)
+	{
+		return -1;
+	}
+	
+	//Payloads differ in length, so the rest of this packet may still be on the air
+	for (tries = 0; (*numBytes & 0x7f) < 1 + packetSize + 2; tries++)
+	{
+		if (tries == limit)
+		{
+			return -1;
+		}
+		osDelay(1);
+		CC2500_Read_Reg(numBytes, RXBYTES, 1);
+	}
+	
+	CC2500_ReadFIFO((int8_t*)packet, FIFO_READ_BURST_ADDRESS, packetSize);
+	CC2500_ReadFIFO(status, FIFO_READ_BURST_ADDRESS, 2);
+	*numBytes = (*numBytes & 0x7f) - (1 + packetSize + 2);
+	
+	//Second status byte: CRC OK in bit 7
+	return (status[1] & 0x80)? packetSize: 0;
 }
 
-void wireless_timer_callback(void const *arg)
+// Runs in the TIM5 interrupt (hr_timer.c)
+void wireless_timer_callback(void *arg)
 {
 	osSignalSet(tid_wireless, WIRELESS_SIGNAL);
 }
 
+#if CC2500_WOR_PERIOD != 0
+int wireless_sleep()
+{
+	osEvent event;
+	
+	//With OS_TICKLESS the CPU stays in WFI unless another thread has work
+	hr_timer_stop(&wireless_timer);
+	osSignalClear(tid_wireless, WIRELESS_SIGNAL);
+	if (CC2500_WakeOnRadio(CC2500_WOR_PERIOD) != 0)
+	{
+		CC2500_Enter(SRX);
+		hr_timer_start(&wireless_timer, WIRELESS_POLL_PERIOD, WIRELESS_POLL_PERIOD);
+		return -1;
+	}
+	
+	event = osSignalWait(WIRELESS_SIGNAL, WIRELESS_SEARCH_POLLS * WIRELESS_POLL_PERIOD / 1000);
+	
+	if (CC2500_WakeUp() != 0)
+	{
+		printf("Radio did not go idle to leave wake-on-radio\n");
+	}
+	hr_timer_start(&wireless_timer, WIRELESS_POLL_PERIOD, WIRELESS_POLL_PERIOD);
+	return event.status == osEventSignal;
+}
+
+void EXTI15_10_IRQHandler()
+{
+	if (EXTI_GetITStatus(CC2500_SPI_INT0_EXTI_LINE) != RESET)
+	{
+		CC2500_PacketInterruptCmd(DISABLE);
+		osSignalSet(tid_wireless, WIRELESS_SIGNAL);
+	}
+	EXTI_ClearITPendingBit(CC2500_SPI_INT0_EXTI_LINE);
+}
+#endif
+
+
+#ifdef BENCHMARK
+void run_benchmarks()
+{
+	static Benchmark_report report;
+	uint8_t packet[WIRELESS_MAX_PAYLOAD];
+	uint8_t delta[LINK_DELTA_SIZE] = {0, 0x78};
+	Link_decoder link;
+	int8_t numBytes, roll, pitch;
+	int angle = -90;
+	
+	benchmark_init(&report, "base_board");
+	benchmark_run_common(&report);
+	benchmark_run_scheduler(&report, 32);
+	
+	BENCHMARK_RUN(&report, "roll_move_to_angle", angle = (angle >= 90)? -90: angle + 1, roll_move_to_angle(angle));
+	roll_move_to_angle(0);
+	
+	//Frame decode is the SPI FIFO read; the FIFO is empty so flush the underflow after each call
+	CC2500_Init();
+	BENCHMARK_RUN(&report, "read_wireless_packet", (CC2500_CmdStrobe(SFRX), numBytes = 127), read_wireless_packet(packet, &numBytes));
+	//IDLE to RX with the cached calibration: synthesizer settling only
+	BENCHMARK_RUN(&report, "rx_turnaround", CC2500_Enter(SIDLE), CC2500_Enter(SRX));
+	CC2500_CmdStrobe(SIDLE);
+	CC2500_CmdStrobe(SFRX);
+	
+	//Rebuild a position from a one degree roll delta
+	link_decoder_init(&link);
+	link.synced = 1;
+	BENCHMARK_RUN(&report, "link_decode", delta[0] = link.sequence, link_decode(&link, delta, LINK_DELTA_SIZE, &roll, &pitch));
+	
+	benchmark_print_json(&report);
+}
+#endif
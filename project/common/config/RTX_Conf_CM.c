@@ -87,6 +87,34 @@
  #define OS_STKCHECK    1
 #endif
 
+// <q>Thread run time and stack usage monitor
+// ==========================================
+// <i> Accumulates CPU cycles per thread on every thread switch and paints
+// <i> thread stacks to measure the stack high-water mark (osThreadGetInfo).
+// <i> Note that additional code reduces the Kernel performance.
+#ifndef OS_MONITOR
+ #define OS_MONITOR     0
+#endif
+
+//   <o>Number of pools and message queues with usage counters <0-64>
+//   <i> Tracks occupancy, peak occupancy, failures and blocked time of
+//   <i> the first pools and message queues created (osPoolGetStats,
+//   <i> osMessageGetStats). 0 disables the counters.
+//   <i> Default: 0
+#ifndef OS_TELEMETRY
+ #define OS_TELEMETRY   0
+#endif
+
+// <q>Constant time ready list
+// ===========================
+// <i> Keeps a FIFO tail per priority level and a bitmap of the non-empty
+// <i> levels, so a thread is made ready in constant time however many are
+// <i> ready. The kernel sources read it as well: set it in the project defines.
+// <i> Default: Disabled
+#ifndef OS_RDYBITMAP
+ #define OS_RDYBITMAP   0
+#endif
+
 // <q>Run in privileged mode
 // =========================
 // <i> Runs all Threads in privileged mode.
@@ -113,6 +141,15 @@
  #define OS_TICK        1000
 #endif
 
+//   <q>Tickless idle
+//   <i> Stops the periodic tick while the idle thread runs: SysTick is
+//   <i> reprogrammed to the next thread delay or timer expiry and the
+//   <i> CPU sleeps in WFI. Requires a kernel library built with this option.
+//   <i> Default: Disabled
+#ifndef OS_TICKLESS
+ #define OS_TICKLESS    0
+#endif
+
 // </h>
 
 // <h>System Configuration
@@ -128,6 +165,7 @@
 
 //   <o>Round-Robin Timeout [ticks] <1-1000>
 //   <i> Defines how long a thread will execute before a thread switch.
+//   <i> Threads defined with osThreadDefQuantum use their own time slice.
 //   <i> Default: 5
 #ifndef OS_ROBINTOUT
  #define OS_ROBINTOUT   5
@@ -203,6 +241,87 @@
  *      Global Functions
  *---------------------------------------------------------------------------*/
 
+/*--------------------------- os_idle_sleep ---------------------------------*/
+
+#if (OS_TICKLESS != 0)
+#ifndef BENCHMARK_HOST                          /* host/tickless_sim.c mocks SysTick */
+#include "stm32f4xx.h"
+#endif
+
+/* Longest sleep the 24-bit SysTick counter can time in one period */
+#define OS_IDLE_MAXSLEEP  (0x1000000 / (OS_TRV + 1))
+/* Cycles before a tick boundary too close to be timed after an early     */
+/* wake-up: the tick interrupt stays off until os_resume has run.          */
+#define OS_IDLE_MARGIN    ((OS_TRV + 1) / 16)
+
+volatile uint32_t os_idle_wakeups;              /* Number of tickless sleeps  */
+volatile uint32_t os_idle_ticks;                /* Ticks spent in those sleeps */
+
+static void os_idle_sleep (void) {
+  /* Sleep until the next thread delay or timer expires, or until any other */
+  /* interrupt, and tell the kernel how many ticks have elapsed.            */
+  uint32_t sleep, elapsed, remain, val;
+
+  sleep = os_suspend ();
+  if (sleep > OS_IDLE_MAXSLEEP) {
+    sleep = OS_IDLE_MAXSLEEP;
+  }
+  if (sleep <= 1) {
+    /* Next tick is due anyway, keep the periodic tick. */
+    os_resume (0);
+    __WFI ();
+    return;
+  }
+
+  __disable_irq ();
+
+  /* Time the rest of this tick plus sleep-1 full ticks. */
+  remain = SysTick->VAL;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+  SysTick->LOAD = (sleep - 1) * (OS_TRV + 1) + remain - 1;
+  SysTick->VAL  = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk |
+                  SysTick_CTRL_ENABLE_Msk;
+
+  __WFI ();
+
+  if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+    /* Slept the whole time, the kernel handles the expiry in os_resume. */
+    elapsed = sleep;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+    SCB->ICSR     = SCB_ICSR_PENDSTCLR_Msk;
+    SysTick->LOAD = OS_TRV;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+  }
+  else {
+    /* Woken early: count the tick boundaries passed, finish the current  */
+    /* tick with a short period and then return to the normal period.     */
+    val = SysTick->VAL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+    elapsed = (sleep - 1) - val / (OS_TRV + 1);
+    remain  = val % (OS_TRV + 1);
+    if (remain < OS_IDLE_MARGIN) {
+      /* Its interrupt would be lost: count that tick now. */
+      elapsed++;
+      remain += OS_TRV + 1;
+    }
+    SysTick->LOAD = (remain > 1) ? remain - 1 : 1;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = OS_TRV;
+  }
+
+  /* Tick interrupt is enabled again by the kernel in os_resume. */
+  __enable_irq ();
+
+  os_idle_wakeups++;
+  os_idle_ticks += elapsed;
+  os_resume (elapsed);
+}
+#endif
+
+
 /*--------------------------- os_idle_demon ---------------------------------*/
 
 void os_idle_demon (void) {
@@ -211,6 +330,9 @@ void os_idle_demon (void) {
 
   for (;;) {
   /* HERE: include optional user code to be executed when no thread runs.*/
+#if (OS_TICKLESS != 0)
+    os_idle_sleep ();
+#endif
   }
 }
 
@@ -230,7 +352,9 @@ void os_error (uint32_t err_code) {
  *      RTX Configuration Functions
  *---------------------------------------------------------------------------*/
 
+#ifndef BENCHMARK_HOST
 #include "RTX_CM_lib.h"
+#endif
 
 /*----------------------------------------------------------------------------
  * end of file
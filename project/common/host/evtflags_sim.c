@@ -0,0 +1,573 @@
+/*!
+ @file evtflags_sim.c
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief Host test of the kernel event flag groups (rt_EvtFlags.c and the lists of rt_List.c, compiled
+ unchanged) behind osEventFlagsSet/Clear/Wait. The task switch, block and dispatch of rt_Task.c and the
+ post service loop of rt_pop_req are reduced to what the flags use. Threads of several priorities wait on
+ one group for AND or OR combinations, with and without osFlagsNoClear and with a time-out, while threads
+ and interrupts set and clear flags and the tick runs. A scripted run checks that one set wakes every
+ waiter on the flag with a single dispatch and that a clear only follows the wakeup pass; a random run
+ checks every step against a model of the API: the flags of the group, which threads still wait, the flags
+ returned to each, and that the highest priority ready thread runs. An interrupt set must leave the group
+ untouched until the post service. Exits with 1 on a failed check. Add -DOS_RDYBITMAP=1 for the bitmap
+ ready list.
+ gcc -std=gnu99 -O2 -DBENCHMARK_HOST -I../rtx_cmsis evtflags_sim.c ../rtx_cmsis/rt_EvtFlags.c ../rtx_cmsis/rt_List.c -o evtflags_sim
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_System.h"
+#include "rt_EvtFlags.h"
+#include "rt_List.h"
+#include "rt_Task.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SIM_THREADS 6	/*!< Threads using the group, the idle thread comes on top */
+#define SIM_STEPS 2000000	/*!< Steps of the random run */
+#define SIM_PSQ 16	/*!< Entries of the post service queue (OS_FIFOSZ) */
+#define SIM_FLAGS 0x003F	/*!< Flags used, few enough that waits are often met */
+#define SIM_MAX_TIMEOUT 20	/*!< Longest time-out in ticks */
+#define SIM_MAX_ISR_SETS 3	/*!< Interrupt sets queued before one post service */
+
+/**
+* A structure to represent one thread and what the model expects of it
+*/
+typedef struct {
+	struct OS_TCB tcb;	/**< the kernel control block */
+	U32 ret;	/**< the value its last wait returned */
+	int active;	/**< model: created, the idle thread always is */
+	int waiting;	/**< model: blocked on the group */
+	U16 flags;	/**< model: the flags waited for */
+	U32 options;	/**< model: FLG_WAIT_ALL and FLG_NO_CLEAR */
+	int remain;	/**< model: ticks to the time-out, -1 for none */
+	U32 expect;	/**< model: the value the wait returns */
+} Sim_thread;
+
+/**
+* What the random run went through
+*/
+typedef struct {
+	long waits;	/**< waits started */
+	long met;	/**< of which met at once */
+	long polls;	/**< of which unmet with no time-out */
+	long woken;	/**< waits ended by a set */
+	long isrWoken;	/**< of which by an interrupt set */
+	long timeouts;	/**< waits ended by the time-out */
+	long passes;	/**< sets that woke several threads */
+	int mostWoken;	/**< most threads woken by one set */
+} Sim_stats;
+
+// The kernel, as rt_System.c and rt_Task.c keep it
+struct OS_TSK os_tsk;
+U16 os_time;
+U32 os_fifo[2 + 4 * SIM_PSQ];	//room for the queue with 64 bit pointers
+static int errors;
+
+void os_error(U32 err_code)
+{
+	errors++;
+}
+
+//rt_dec_dly reports the end of mailbox waits, nothing here waits on one
+void rt_mbx_woken(P_TCB p_TCB, U32 timeout)
+{
+}
+
+static Sim_thread threads[SIM_THREADS + 1];
+static struct OS_FCB group;
+static U16 modelFlags;
+static int modelPrio;	//the priority the model expects to run
+static long dispatches;
+static long pushRequests;
+
+static Sim_thread *sim_thread(P_TCB p)
+{
+	return (Sim_thread *)p;
+}
+
+//rt_ret_val: the value in R0 of the stacked frame
+void rt_ret_val(P_TCB p_TCB, U32 v0)
+{
+	sim_thread(p_TCB)->ret = v0;
+}
+
+//rt_psh_req: PendSV is pended, run_post_service stands in for it
+void rt_psh_req(void)
+{
+	pushRequests++;
+}
+
+static void switch_to(P_TCB p)
+{
+	os_tsk.run = p;
+	p->state = RUNNING;
+}
+
+//rt_block
+void rt_block(U16 timeout, U8 block_state)
+{
+	if (timeout)
+	{
+		if (timeout < 0xffff)
+		{
+			rt_put_dly(os_tsk.run, timeout);
+		}
+		os_tsk.run->state = block_state;
+		switch_to(rt_get_first(&os_rdy));
+	}
+}
+
+//rt_dispatch_rdy, counted: one per set that woke a thread
+void rt_dispatch_rdy(void)
+{
+	P_TCB next;
+
+	dispatches++;
+	if ((os_rdy.p_lnk != NULL) && (os_rdy.p_lnk->prio > os_tsk.run->prio))
+	{
+		next = rt_get_first(&os_rdy);
+		if ((os_rdy.p_lnk != NULL) && (os_rdy.p_lnk->prio > os_tsk.run->prio))
+		{
+			rt_put_prio(&os_rdy, os_tsk.run);
+		}
+		else
+		{
+			rt_put_rdy_first(os_tsk.run);
+		}
+		os_tsk.run->state = READY;
+		switch_to(next);
+	}
+}
+
+//rt_pop_req with flag groups only in the queue
+static void run_post_service(void)
+{
+	U32 idx;
+
+	os_tsk.run->state = READY;
+	rt_put_rdy_first(os_tsk.run);
+	idx = os_psq->last;
+	while (os_psq->count)
+	{
+		rt_flg_psh((P_FCB)os_psq->q[idx].id, (U16)os_psq->q[idx].arg);
+		if (++idx == os_psq->size)
+		{
+			idx = 0;
+		}
+		os_psq->count--;
+	}
+	os_psq->last = idx;
+	switch_to(rt_get_first(&os_rdy));
+}
+
+//rt_systick: the delay list, then the highest priority ready thread runs
+static void tick(void)
+{
+	os_tsk.run->state = READY;
+	rt_put_rdy_first(os_tsk.run);
+	os_time++;
+	rt_dec_dly();
+	switch_to(rt_get_first(&os_rdy));
+}
+
+static void sim_init(void)
+{
+	static const U8 prios[SIM_THREADS + 1] = {3, 4, 4, 4, 5, 6, 1};
+	int i;
+
+	os_rdy.cb_type = HCB;
+	os_rdy.p_lnk = NULL;
+#ifdef __RDY_BITMAP
+	os_rdy_map = 0;
+#endif
+	os_dly.cb_type = HCB;
+	os_dly.p_dlnk = NULL;
+	os_dly.p_blnk = NULL;
+	os_dly.delta_time = 0;
+	os_psq->first = 0;
+	os_psq->last = 0;
+	os_psq->count = 0;
+	os_psq->size = SIM_PSQ;
+	for (i = 0; i <= SIM_THREADS; i++)
+	{
+		threads[i].tcb.cb_type = TCB;
+		threads[i].tcb.prio = prios[i];
+		threads[i].tcb.state = INACTIVE;
+		threads[i].tcb.p_lnk = NULL;
+		threads[i].tcb.p_rlnk = NULL;
+		threads[i].tcb.p_dlnk = NULL;
+		threads[i].tcb.p_blnk = NULL;
+		threads[i].ret = 0;
+		threads[i].active = (i == SIM_THREADS);
+		threads[i].waiting = 0;
+		threads[i].expect = 0;
+	}
+	switch_to(&threads[SIM_THREADS].tcb);	//the idle thread, which never waits
+	group.cb_type = 0;
+	rt_flg_init(&group, 0);
+	modelFlags = 0;
+	modelPrio = threads[SIM_THREADS].tcb.prio;
+	dispatches = 0;
+	pushRequests = 0;
+	errors = 0;
+}
+
+// ==== The model of the API ====
+
+//The highest priority of the threads that do not wait
+static int ready_prio(void)
+{
+	int prio = 0;
+	int i;
+
+	for (i = 0; i <= SIM_THREADS; i++)
+	{
+		if (threads[i].active && !threads[i].waiting && threads[i].tcb.prio > prio)
+		{
+			prio = threads[i].tcb.prio;
+		}
+	}
+	return prio;
+}
+
+static U16 model_match(U16 flags, U16 waitFlags, U32 options)
+{
+	if (options & FLG_WAIT_ALL)
+	{
+		return ((flags & waitFlags) == waitFlags)? waitFlags: 0;
+	}
+	return flags & waitFlags;
+}
+
+//osEventFlagsSet: every waiter is matched against the flags as set, the matched flags are cleared afterwards
+static int model_set(U16 flags)
+{
+	U16 clear = 0;
+	U16 match;
+	int woken = 0;
+	int i;
+
+	modelFlags |= flags;
+	for (i = 0; i < SIM_THREADS; i++)
+	{
+		match = threads[i].waiting? model_match(modelFlags, threads[i].flags, threads[i].options): 0;
+		if (match != 0)
+		{
+			threads[i].waiting = 0;
+			threads[i].expect = match;
+			clear |= (threads[i].options & FLG_NO_CLEAR)? 0: match;
+			modelPrio = (threads[i].tcb.prio > modelPrio)? threads[i].tcb.prio: modelPrio;
+			woken++;
+		}
+	}
+	modelFlags &= ~clear;
+	return woken;
+}
+
+static int model_tick(void)
+{
+	int expired = 0;
+	int i;
+
+	for (i = 0; i < SIM_THREADS; i++)
+	{
+		if (threads[i].waiting && threads[i].remain > 0 && --threads[i].remain == 0)
+		{
+			threads[i].waiting = 0;
+			threads[i].expect = 0;
+			expired++;
+		}
+	}
+	return expired;
+}
+
+//Kernel against model; prints what differs
+static int check(const char *step)
+{
+	P_TCB p;
+	P_TCB previous = (P_TCB)&group;
+	int linked = 1;
+	int waiters = 0;
+	int listed = 0;
+	int i;
+	int ok = (errors == 0);
+
+	if (group.flags != modelFlags)
+	{
+		printf("%s: flags 0x%04X, expected 0x%04X\n", step, group.flags, modelFlags);
+		ok = 0;
+	}
+	for (i = 0; i < SIM_THREADS; i++)
+	{
+		int blocked = (threads[i].tcb.state == WAIT_FLG_OR || threads[i].tcb.state == WAIT_FLG_AND);
+
+		waiters += threads[i].waiting;
+		if (blocked != threads[i].waiting)
+		{
+			printf("%s: thread %d %s\n", step, i, blocked? "still waits": "does not wait");
+			ok = 0;
+		}
+		else if (!blocked && threads[i].ret != threads[i].expect)
+		{
+			printf("%s: thread %d got 0x%04X, expected 0x%04X\n", step, i, (unsigned)threads[i].ret,
+				(unsigned)threads[i].expect);
+			ok = 0;
+		}
+	}
+	//The wait list is doubly linked from the group
+	for (p = group.p_lnk; p != NULL && listed <= SIM_THREADS; p = p->p_lnk)
+	{
+		linked &= (p->p_rlnk == previous);
+		previous = p;
+		listed++;
+	}
+	if (listed != waiters || !linked)
+	{
+		printf("%s: %d threads on the wait list, %d wait%s\n", step, listed, waiters, linked? "": ", back links broken");
+		ok = 0;
+	}
+	if (os_tsk.run->prio != modelPrio)
+	{
+		printf("%s: priority %d runs, expected %d\n", step, os_tsk.run->prio, modelPrio);
+		ok = 0;
+	}
+	return ok;
+}
+
+// ==== The steps, on the kernel and the model ====
+
+//osThreadCreate, rt_dispatch: the new thread runs if its priority is higher
+static void start(Sim_thread *t)
+{
+	t->active = 1;
+	if (t->tcb.prio > os_tsk.run->prio)
+	{
+		rt_put_rdy_first(os_tsk.run);
+		os_tsk.run->state = READY;
+		switch_to(&t->tcb);
+	}
+	else
+	{
+		t->tcb.state = READY;
+		rt_put_prio(&os_rdy, &t->tcb);
+	}
+	modelPrio = ready_prio();
+}
+
+//The running thread waits, returns 1 if it blocked
+static int wait(U16 flags, U32 options, U16 timeout)
+{
+	Sim_thread *t = sim_thread(os_tsk.run);
+	U16 match = model_match(modelFlags, flags, options);
+
+	t->ret = rt_flg_wait(&group, flags, options, timeout);
+	t->expect = match;
+	modelPrio = t->tcb.prio;
+	if (match != 0)
+	{
+		modelFlags &= (options & FLG_NO_CLEAR)? 0xFFFF: ~match;
+		return 0;
+	}
+	if (timeout == 0)
+	{
+		return 0;
+	}
+	t->waiting = 1;
+	t->flags = flags;
+	t->options = options;
+	t->remain = (timeout == 0xFFFF)? -1: timeout;
+	modelPrio = ready_prio();
+	return 1;
+}
+
+//The running thread sets flags, returns the number of threads woken
+static int set(U16 flags)
+{
+	int woken;
+	U16 after;
+
+	modelPrio = os_tsk.run->prio;
+	woken = model_set(flags);
+	after = rt_flg_set(&group, flags);
+	if (after != modelFlags)
+	{
+		printf("set returned 0x%04X, expected 0x%04X\n", after, modelFlags);
+		errors++;
+	}
+	return woken;
+}
+
+static void clear(U16 flags)
+{
+	U16 before;
+
+	modelPrio = os_tsk.run->prio;
+	before = rt_flg_clr(&group, flags);
+	if (before != modelFlags)
+	{
+		printf("clear returned 0x%04X, expected 0x%04X\n", before, modelFlags);
+		errors++;
+	}
+	modelFlags &= ~flags;
+}
+
+//Scripted cases that show the single pass
+static int run_script(void)
+{
+	long before;
+	int ok = 1;
+	int i;
+
+	//Broadcast: every thread waits for flag 0, one set from the idle thread wakes all of them
+	sim_init();
+	for (i = 0; i < SIM_THREADS; i++)
+	{
+		start(&threads[i]);
+		wait(0x0001, 0, 0xFFFF);
+	}
+	ok &= check("broadcast wait");	//the idle thread is the only one left
+	before = dispatches;
+	ok &= (set(0x0001) == SIM_THREADS);
+	ok &= check("broadcast set");
+	ok &= (dispatches == before + 1 && os_tsk.run == &threads[SIM_THREADS - 1].tcb);
+	printf("broadcast: %d threads woken by one set, %ld dispatch, priority %d runs\n", SIM_THREADS,
+		dispatches - before, os_tsk.run->prio);
+
+	//AND and OR waiters on overlapping flags: both are matched before either clears
+	sim_init();
+	start(&threads[0]);
+	wait(0x0006, FLG_WAIT_ALL, 0xFFFF);
+	start(&threads[1]);
+	wait(0x0004, 0, 0xFFFF);
+	start(&threads[2]);
+	wait(0x0002, 0, 0xFFFF);
+	set(0x0001);
+	ok &= check("and set 0x0001");
+	set(0x0006);
+	ok &= check("and set 0x0006");
+	ok &= (threads[0].ret == 0x0006 && threads[1].ret == 0x0004 && threads[2].ret == 0x0002 && group.flags == 0x0001);
+
+	//Interrupt sets: the group is untouched until the post service, which wakes in the same way
+	sim_init();
+	for (i = 0; i < SIM_THREADS; i++)
+	{
+		start(&threads[i]);
+		wait(0x0008, 0, 0xFFFF);
+	}
+	before = pushRequests;
+	isr_flg_set(&group, 0x0008);
+	ok &= (group.flags == 0 && os_tsk.run == &threads[SIM_THREADS].tcb && pushRequests == before + 1);
+	model_set(0x0008);
+	modelPrio = ready_prio();
+	run_post_service();
+	ok &= check("interrupt set");
+	puts(ok? "scripted cases ok": "scripted cases FAILED");
+	return ok;
+}
+
+static int run_random(void)
+{
+	Sim_stats s = {0, 0, 0, 0, 0, 0, 0, 0};
+	long step;
+	int n, i, woken, op;
+	U16 flags;
+	U32 options;
+	U16 timeout;
+
+	sim_init();
+	for (i = 0; i < SIM_THREADS; i++)
+	{
+		start(&threads[i]);
+	}
+	srand(1);
+	for (step = 0; step < SIM_STEPS; step++)
+	{
+		//The running thread calls the API, the idle thread does not wait
+		flags = (U16)((1 << (rand() % 6)) | ((rand() % 2)? (1 << (rand() % 6)): 0));
+		op = rand() % 16;
+		if (op < 6 && os_tsk.run != &threads[SIM_THREADS].tcb)
+		{
+			options = rand() % 4;
+			n = rand() % 8;
+			timeout = (n == 0)? 0: (n < 4)? 0xFFFF: (U16)(1 + rand() % SIM_MAX_TIMEOUT);
+			s.waits++;
+			if (!wait(flags, options, timeout))
+			{
+				s.met += (sim_thread(os_tsk.run)->expect != 0);
+				s.polls += (sim_thread(os_tsk.run)->expect == 0);
+			}
+		}
+		else if (op < 10)
+		{
+			woken = set(flags);
+			s.woken += woken;
+			s.passes += (woken > 1);
+			s.mostWoken = (woken > s.mostWoken)? woken: s.mostWoken;
+		}
+		else if (op < 12)
+		{
+			//An interrupt, or several before the post service runs
+			n = 1 + rand() % SIM_MAX_ISR_SETS;
+			woken = 0;
+			for (i = 0; i < n; i++)
+			{
+				isr_flg_set(&group, flags);
+				flags = (U16)(1 << (rand() % 6));
+			}
+			if (!check("interrupt set queued"))
+			{
+				printf("at step %ld\n", step);
+				return 0;
+			}
+			for (i = 0; i < n; i++)
+			{
+				U32 idx = (os_psq->last + i) % os_psq->size;
+
+				woken += model_set((U16)os_psq->q[idx].arg);
+			}
+			modelPrio = ready_prio();
+			run_post_service();
+			s.woken += woken;
+			s.isrWoken += woken;
+		}
+		else if (op < 13)
+		{
+			clear(flags & SIM_FLAGS);
+		}
+		else
+		{
+			s.timeouts += model_tick();
+			modelPrio = ready_prio();
+			tick();
+		}
+		if (!check("random run"))
+		{
+			printf("at step %ld\n", step);
+			return 0;
+		}
+	}
+	printf("random run: %ld waits (%ld met at once, %ld polls), %ld woken by a set (%ld by an interrupt), %ld timed out, %ld sets woke several (up to %d)\n",
+		s.waits, s.met, s.polls, s.woken, s.isrWoken, s.timeouts, s.passes, s.mostWoken);
+	return 1;
+}
+
+int main(void)
+{
+	int ok = run_script();
+
+	ok &= run_random();
+	puts(ok? "ok": "FAILED");
+	return ok? 0: 1;
+}
+
+//! @}
@@ -0,0 +1,146 @@
+/*!
+ @file link_sim.c
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief Host test of the realtime roll/pitch stream (orientation_link.c, compiled unchanged) under packet loss.
+ A board held still (the filtered angles jitter by 1 degree) and a board in continuous motion are sampled at
+ 100 Hz and encoded, and the packets are decoded as the base board would. For every packet of the stream in
+ turn, a run drops that one packet: the base board must be back on the transmitted state within
+ LINK_HEARTBEAT samples of the loss and never show a wrong one. A run with random loss prints how long the
+ base board is left stale. Exits with 1 on a failed check.
+ gcc -std=gnu99 -O2 -I../src link_sim.c ../src/orientation_link.c -o link_sim -lm
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#include "orientation_link.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SIM_RATE 100	/*!< Samples per second */
+#define SIM_SAMPLES 3000	/*!< Samples per run, 30 s */
+#define SIM_LOSS 5	/*!< Percent of packets lost in the random loss run */
+
+/**
+* A structure to represent one movement of the board
+*/
+typedef struct {
+	const char *name;	/**< the name printed */
+	double rollAmplitude;	/**< degrees of the roll sine */
+	double rollPeriod;	/**< seconds per roll cycle */
+	double pitchAmplitude;	/**< degrees of the pitch sine */
+	double pitchPeriod;	/**< seconds per pitch cycle */
+} Sim_motion;
+
+/**
+* The outcome of one run
+*/
+typedef struct {
+	int sent;	/**< packets sent */
+	int full;	/**< of which full messages */
+	int bytes;	/**< payload bytes sent */
+	int stale;	/**< longest run of samples the base board was not on the transmitted state */
+	int wrong;	/**< packets decoded to a state the remote board never transmitted */
+} Sim_result;
+
+static void sample(const Sim_motion *m, int n, int8_t *rollAngle, int8_t *pitchAngle)
+{
+	double t = n / (double)SIM_RATE;
+
+	//At rest the filter output still jitters by a degree
+	*rollAngle = (int8_t)lround(m->rollAmplitude * sin(2 * M_PI * t / m->rollPeriod)) + rand() % 2;
+	*pitchAngle = (int8_t)lround(m->pitchAmplitude * sin(2 * M_PI * t / m->pitchPeriod)) + rand() % 2;
+}
+
+//drop: the index of the one packet lost, -1 for none; loss: percent of packets lost at random
+static Sim_result run(const Sim_motion *m, int drop, int loss)
+{
+	Link_encoder e;
+	Link_decoder d;
+	Sim_result r = {0, 0, 0, 0, 0};
+	uint8_t packet[LINK_FULL_SIZE];
+	int8_t rollAngle, pitchAngle, roll, pitch;
+	int length;
+	int stale = 0;
+	int n;
+
+	link_encoder_init(&e);
+	link_decoder_init(&d);
+	srand(1);
+	for (n = 0; n < SIM_SAMPLES; n++)
+	{
+		sample(m, n, &rollAngle, &pitchAngle);
+		length = link_encode(&e, rollAngle, pitchAngle, packet);
+		if (length != 0)
+		{
+			r.full += (length == LINK_FULL_SIZE);
+			r.bytes += length;
+			if (r.sent++ != drop && (loss == 0 || rand() % 100 >= loss) &&
+				link_decode(&d, packet, length, &roll, &pitch) == 0 &&
+				(roll != e.rollAngle || pitch != e.pitchAngle))
+			{
+				r.wrong++;
+			}
+		}
+
+		//The base board is stale while it is not on the state the remote board last transmitted
+		if (d.synced && d.rollAngle == e.rollAngle && d.pitchAngle == e.pitchAngle)
+		{
+			stale = 0;
+		}
+		else if (++stale > r.stale)
+		{
+			r.stale = stale;
+		}
+	}
+	return r;
+}
+
+static int run_motion(const Sim_motion *m)
+{
+	Sim_result clean = run(m, -1, 0);
+	Sim_result lossy = run(m, -1, SIM_LOSS);
+	Sim_result r;
+	int stale = 0;
+	int wrong = 0;
+	int drop;
+
+	//The same samples every run (srand), so the packets of a run are those of the clean one
+	for (drop = 0; drop < clean.sent; drop++)
+	{
+		r = run(m, drop, 0);
+		stale = (r.stale > stale)? r.stale: stale;
+		wrong += r.wrong;
+	}
+	printf("%-10s packets/s %5.1f  full/s %4.1f  bytes/s %6.1f  one lost: stale max %3d samples, wrong %d  %d%% lost: stale max %3d samples, wrong %d\n",
+		m->name, clean.sent * (double)SIM_RATE / SIM_SAMPLES, clean.full * (double)SIM_RATE / SIM_SAMPLES,
+		clean.bytes * (double)SIM_RATE / SIM_SAMPLES, stale, wrong, SIM_LOSS, lossy.stale, lossy.wrong);
+	return stale <= LINK_HEARTBEAT && wrong == 0 && lossy.wrong == 0 && clean.stale == 0;
+}
+
+int main(void)
+{
+	static const Sim_motion motions[] = {
+		{"rest", 0, 1, 0, 1},
+		{"slow", 30, 8, 20, 11},
+		{"moving", 60, 2, 40, 3},
+		{"fast", 80, 0.7, 80, 1.1},
+	};
+	int ok = 1;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(motions) / sizeof(motions[0]); i++)
+	{
+		ok &= run_motion(&motions[i]);
+	}
+	puts(ok? "ok": "FAILED");
+	return ok? 0: 1;
+}
+
+//! @}
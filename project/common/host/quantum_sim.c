@@ -0,0 +1,291 @@
+/*!
+ @file quantum_sim.c
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief Host simulation of the sample jitter of the remote board orientation thread against the round-robin
+ quanta of the threads it shares osPriorityNormal with. The kernel ready list (rt_List.c) and round-robin
+ check (rt_Robin.c) are compiled unchanged and driven by the tick sequence of rt_systick and the wake-up
+ rule of rt_dispatch. The accelerometer data ready interrupt wakes the orientation thread every 10 ms, each
+ sample wakes the wireless thread which polls the radio state for each message (one live, up to
+ REPLAY_MAX_SPEED in a replay), and the keypad thread rewrites the LCD with busy waits. The latency from the interrupt to the orientation thread running is printed per quantum with
+ the preemption and time slice counters of the competing threads.
+ gcc -std=gnu99 -O2 -DBENCHMARK_HOST -I../rtx_cmsis quantum_sim.c ../rtx_cmsis/rt_List.c ../rtx_cmsis/rt_Robin.c -o quantum_sim -lm
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_List.h"
+#include "rt_Task.h"
+#include "rt_Robin.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SIM_SECONDS 60	/*!< Simulated time per configuration */
+#define SIM_TICK 1000	/*!< usec per kernel tick (OS_TICK) */
+#define SIM_ROBINTOUT 5	/*!< OS_ROBINTOUT in RTX_Conf_CM.c, the quantum of threads without their own */
+#define SIM_PRIO_NORMAL 4	/*!< Kernel priority of osPriorityNormal */
+
+#define SAMPLE_PERIOD 10013	/*!< usec between data ready interrupts, the accelerometer clock drifts against the tick */
+#define SAMPLE_WORK 200	/*!< usec to filter a sample and queue its messages */
+#define RADIO_POLL_MIN 300	/*!< Shortest radio state polling per message, usec */
+#define RADIO_POLL_MAX 4000	/*!< Longest radio state polling per message (TX to RX turnaround, slow profile), usec */
+#define LCD_PERIOD 250000	/*!< usec between LCD rewrites, one per telemetry answer */
+#define LCD_WORK 3300	/*!< usec of busy waits to clear the LCD and write a line of telemetry */
+
+#define SIM_LATENCIES 8192	/*!< Latencies kept for the percentile */
+
+/**
+* A structure to represent one thread: the work left before it blocks again
+*/
+typedef struct {
+	struct OS_TCB tcb;	/**< the kernel control block */
+	uint32_t remain;	/**< usec of work left, 0 while blocked */
+} Sim_thread;
+
+/**
+* A structure to represent one configuration of quanta
+*/
+typedef struct {
+	const char *name;	/**< the name printed */
+	int messages;	/**< messages sent per sample */
+	U16 wirelessQuantum;	/**< quantum of the wireless thread in ticks, 0 for OS_ROBINTOUT */
+	U16 keypadQuantum;	/**< quantum of the keypad thread in ticks, 0 for OS_ROBINTOUT */
+} Sim_config;
+
+// The kernel, as rt_System.c and rt_Task.c keep it
+struct OS_TSK os_tsk;
+U16 os_time;
+U32 const os_rrobin = SIM_ROBINTOUT;
+U32 os_fifo[4];
+
+void os_error(U32 err_code)
+{
+}
+
+//rt_dec_dly reports the end of mailbox waits, nothing here waits on one
+void rt_mbx_woken(P_TCB p_TCB, U32 timeout)
+{
+}
+
+static Sim_thread idle;
+static Sim_thread orientation;
+static Sim_thread wireless;
+static Sim_thread keypad;
+
+static uint64_t now;
+static uint64_t sampleTime;
+static int sampleWaiting;
+static uint32_t latencies[SIM_LATENCIES];
+static uint32_t numLatencies;
+static double latencySum;
+static double latencySquares;
+static uint32_t latencyMax;
+
+static Sim_thread *sim_thread(P_TCB p)
+{
+	return (Sim_thread *)p;
+}
+
+//rt_switch_req: a thread still ready when it is switched out was preempted
+static void switch_to(P_TCB p)
+{
+	if (os_tsk.run != p && os_tsk.run->state == READY)
+	{
+		os_tsk.run->preempts++;
+	}
+	os_tsk.run = p;
+	p->state = RUNNING;
+	if (p == &orientation.tcb && sampleWaiting)
+	{
+		uint32_t latency = (uint32_t)(now - sampleTime);
+
+		sampleWaiting = 0;
+		if (numLatencies < SIM_LATENCIES)
+		{
+			latencies[numLatencies] = latency;
+		}
+		else
+		{
+			latencies[rand() % SIM_LATENCIES] = latency;	//a uniform sample of the run is enough for the percentile
+		}
+		numLatencies++;
+		latencySum += latency;
+		latencySquares += (double)latency * latency;
+		latencyMax = (latency > latencyMax)? latency: latencyMax;
+	}
+}
+
+//rt_dispatch: a woken thread of the same priority waits behind the running one
+static void wake(Sim_thread *t, uint32_t work)
+{
+	t->remain += work;
+	if (t->tcb.state != WAIT_MBX)
+	{
+		return;	//already ready or running: the new work is queued for it
+	}
+	if (t->tcb.prio > os_tsk.run->prio)
+	{
+		rt_put_rdy_first(os_tsk.run);
+		os_tsk.run->state = READY;
+		switch_to(&t->tcb);
+	}
+	else
+	{
+		t->tcb.state = READY;
+		rt_put_prio(&os_rdy, &t->tcb);
+	}
+}
+
+//rt_block: the running thread waits again, the first ready one runs
+static void block(void)
+{
+	os_tsk.run->state = WAIT_MBX;
+	switch_to(rt_get_first(&os_rdy));
+}
+
+//rt_systick
+static void tick(void)
+{
+	os_tsk.run->state = READY;
+	rt_put_rdy_first(os_tsk.run);
+	rt_chk_robin();
+	os_time++;
+	switch_to(rt_get_first(&os_rdy));
+}
+
+static void thread_init(Sim_thread *t, U8 prio, U16 quantum)
+{
+	t->tcb.cb_type = TCB;
+	t->tcb.prio = prio;
+	t->tcb.quantum = quantum;
+	t->tcb.preempts = 0;
+	t->tcb.slices = 0;
+	t->tcb.state = WAIT_MBX;
+	t->tcb.p_lnk = NULL;
+	t->tcb.p_rlnk = NULL;
+	t->remain = 0;
+}
+
+static int compare_latency(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void run_config(const Sim_config *c)
+{
+	uint64_t end = (uint64_t)SIM_SECONDS * 1000000;
+	uint64_t nextTick = SIM_TICK;
+	uint64_t nextSample = 137;	//any phase against the tick
+	uint64_t nextLcd = LCD_PERIOD / 2;
+	uint64_t next;
+	Sim_thread *run;
+	uint32_t n;
+	double mean;
+	int i;
+
+	os_rdy.cb_type = HCB;
+	os_rdy.p_lnk = NULL;
+	os_time = 0;
+	thread_init(&idle, 0, 0);
+	thread_init(&orientation, SIM_PRIO_NORMAL, 0);
+	thread_init(&wireless, SIM_PRIO_NORMAL, c->wirelessQuantum);
+	thread_init(&keypad, SIM_PRIO_NORMAL, c->keypadQuantum);
+	idle.tcb.state = RUNNING;
+	idle.remain = 0xFFFFFFFF;
+	os_tsk.run = &idle.tcb;
+	rt_init_robin();
+	now = 0;
+	sampleWaiting = 0;
+	numLatencies = 0;
+	latencySum = latencySquares = 0;
+	latencyMax = 0;
+	srand(1);
+
+	while (now < end)
+	{
+		//Run the current thread up to the next interrupt or until it blocks
+		run = sim_thread(os_tsk.run);
+		next = (nextTick < nextSample)? nextTick: nextSample;
+		next = (nextLcd < next)? nextLcd: next;
+		if (run != &idle && now + run->remain <= next)
+		{
+			now += run->remain;
+			run->remain = 0;
+			if (run == &orientation)
+			{
+				//The sample is queued: the wireless thread polls the radio to send it
+				for (i = 0; i < c->messages; i++)
+				{
+					wake(&wireless, RADIO_POLL_MIN + rand() % (RADIO_POLL_MAX - RADIO_POLL_MIN));
+				}
+			}
+			block();
+			continue;
+		}
+		if (run != &idle)
+		{
+			run->remain -= (uint32_t)(next - now);
+		}
+		now = next;
+
+		if (now == nextSample)
+		{
+			nextSample += SAMPLE_PERIOD;
+			sampleTime = now;
+			sampleWaiting = 1;
+			wake(&orientation, SAMPLE_WORK);
+		}
+		if (now == nextLcd)
+		{
+			nextLcd += LCD_PERIOD;
+			wake(&keypad, LCD_WORK);
+		}
+		if (now == nextTick)
+		{
+			nextTick += SIM_TICK;
+			tick();
+		}
+	}
+
+	n = (numLatencies < SIM_LATENCIES)? numLatencies: SIM_LATENCIES;
+	qsort(latencies, n, sizeof(latencies[0]), compare_latency);
+	mean = latencySum / numLatencies;
+	printf("%-31s latency mean %6.0f  jitter %6.0f  p99 %6u  max %6u usec  wireless preempts/s %5.1f slices/s %5.1f  keypad preempts/s %4.1f\n",
+		c->name, mean, sqrt(latencySquares / numLatencies - mean * mean), (unsigned)latencies[n * 99 / 100],
+		(unsigned)latencyMax, wireless.tcb.preempts / (double)SIM_SECONDS, wireless.tcb.slices / (double)SIM_SECONDS,
+		keypad.tcb.preempts / (double)SIM_SECONDS);
+}
+
+int main(void)
+{
+	static const Sim_config configs[] = {
+		{"live, OS_ROBINTOUT", 1, 0, 0},
+		{"live, wireless 1", 1, 1, 0},
+		{"live, wireless 1 keypad 1", 1, 1, 1},
+		{"replay x8, OS_ROBINTOUT", 8, 0, 0},
+		{"replay x8, wireless 2", 8, 2, 0},
+		{"replay x8, wireless 1", 8, 1, 0},
+		{"replay x8, wireless 1 keypad 1", 8, 1, 1},
+	};
+	unsigned int i;
+
+	for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++)
+	{
+		run_config(&configs[i]);
+	}
+	return 0;
+}
+
+//! @}
@@ -0,0 +1,233 @@
+/*!
+ @file tdma_sim.c
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief Host simulation of the TDMA slots (tdma.c, compiled unchanged) on one shared channel. The base board
+ sends a beacon at the start of every superframe; 1 to 8 remote boards, addresses 1 to 8, always have a
+ message to send and time their packet from the end of the beacon as wireless_tdma does, off by up to
+ SIM_JITTER usec (beacon interrupt and slot timer latency). Packets are intervals on the air: two that
+ overlap are both lost. When more boards than TDMA_SLOTS are on the air, the owner of the first slot is
+ switched off halfway through and the base board has to free its slot for a waiting one. For every radio
+ profile it prints the superframe, the packets per second of each board with a slot and the join collisions,
+ and checks that no data packet ever collides, nothing runs into the next beacon, the join requests of
+ addresses 1 to TDMA_SLOTS never collide, every slot gets an owner and the freed slot is taken again.
+ Exits with 1 on a failed check.
+ gcc -std=gnu99 -O2 -I../src tdma_sim.c ../src/tdma.c -o tdma_sim
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#include "tdma.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SIM_SUPERFRAMES 4000	/*!< Superframes per run */
+#define SIM_MAX_REMOTES 8	/*!< Most remote boards on the air */
+#define SIM_JITTER 40	/*!< Largest timing error of a remote board either way, usec */
+#define SIM_BEACON_DELAY 10	/*!< usec from the start of a superframe to the beacon on the air */
+#define SIM_FULL_BITS 144	/*!< Bits on the air for a full message: preamble, sync, length, address, 4 bytes, CRC */
+#define SIM_BEACON_BITS (SIM_FULL_BITS + 8 * (TDMA_BEACON_SIZE - 4))	/*!< The beacon is longer than a message */
+#define SIM_PROFILES 4
+
+// CC2500_Profiles in wireless_cc2500.c: air time of a full message in usec
+static const char *profileNames[SIM_PROFILES] = {"2.4 KBAUD", "10 KBAUD", "250 KBAUD", "500 KBAUD"};
+static const uint16_t frameTimes[SIM_PROFILES] = {60027, 14411, 576, 288};
+
+/**
+* A structure to represent one packet on the air
+*/
+typedef struct {
+	uint32_t start;	/**< the first usec on the air */
+	uint32_t end;	/**< the usec after the last */
+	uint8_t address;	/**< the sender */
+	uint8_t join;	/**< whether it asks for a slot */
+} Sim_packet;
+
+/**
+* The outcome of one run
+*/
+typedef struct {
+	uint32_t superframe;	/**< the superframe in usec */
+	long delivered[SIM_MAX_REMOTES + 1];	/**< data packets received from each address in the first half */
+	long dataCollisions;	/**< data packets lost to an overlap */
+	long joinCollisions;	/**< join requests lost to an overlap */
+	long firstJoinCollisions;	/**< of which from addresses 1 to TDMA_SLOTS */
+	long overruns;	/**< packets still on the air when the next beacon starts */
+	int joined[SIM_MAX_REMOTES + 1];	/**< the superframe each address got a slot in, -1 if never */
+	int off;	/**< the address switched off halfway, 0 for none */
+	int rejoined;	/**< the superframe a waiting board took the freed slot in, -1 if never */
+} Sim_result;
+
+static int random_jitter(void)
+{
+	return rand() % (2 * SIM_JITTER + 1) - SIM_JITTER;
+}
+
+static int overlaps(const Sim_packet *a, const Sim_packet *b)
+{
+	return a->start < b->end && b->start < a->end;
+}
+
+static void run(int profile, int remotes, Sim_result *r)
+{
+	Tdma_master m;
+	Tdma_beacon b;
+	Sim_packet air[SIM_MAX_REMOTES];
+	uint8_t packet[TDMA_BEACON_SIZE];
+	uint16_t slotTime = tdma_slot_time(frameTimes[profile]);
+	uint32_t beaconTime = (uint32_t)frameTimes[profile] * SIM_BEACON_BITS / SIM_FULL_BITS;
+	uint32_t t = 0;
+	uint32_t beaconEnd;
+	int superframe, address, slot, numAir, i, j, lost;
+
+	r->superframe = tdma_superframe_time(slotTime);
+	r->dataCollisions = r->joinCollisions = r->firstJoinCollisions = r->overruns = 0;
+	r->off = 0;
+	r->rejoined = -1;
+	for (address = 0; address <= SIM_MAX_REMOTES; address++)
+	{
+		r->delivered[address] = 0;
+		r->joined[address] = -1;
+	}
+	srand(profile * SIM_MAX_REMOTES + remotes);
+	tdma_master_init(&m, slotTime);
+
+	for (superframe = 0; superframe < SIM_SUPERFRAMES; superframe++, t += r->superframe)
+	{
+		tdma_master_next(&m);
+		tdma_beacon_encode(&m.beacon, packet);
+		tdma_beacon_decode(&b, packet, TDMA_BEACON_SIZE);
+		beaconEnd = t + SIM_BEACON_DELAY + beaconTime;
+		if (remotes > TDMA_SLOTS && superframe == SIM_SUPERFRAMES / 2)
+		{
+			r->off = b.owners[0];
+		}
+
+		//Every board that may send this superframe: its own slot, or the join slot on its turn
+		numAir = 0;
+		for (address = 1; address <= remotes; address++)
+		{
+			if (address == r->off)
+			{
+				continue;	//switched off
+			}
+			slot = tdma_slot_of(&b, address);
+			if (slot < 0 && !tdma_may_join(&b, address))
+			{
+				continue;
+			}
+			air[numAir].start = beaconEnd + tdma_slot_start(&b, (slot < 0)? TDMA_SLOTS: slot) + random_jitter();
+			air[numAir].end = air[numAir].start + frameTimes[profile];
+			air[numAir].address = address;
+			air[numAir].join = slot < 0;
+			numAir++;
+		}
+
+		//The base board hears the packets nothing overlapped
+		for (i = 0; i < numAir; i++)
+		{
+			lost = 0;
+			for (j = 0; j < numAir; j++)
+			{
+				lost |= (i != j && overlaps(&air[i], &air[j]));
+			}
+			if (air[i].end > t + r->superframe + SIM_BEACON_DELAY)
+			{
+				r->overruns++;
+			}
+			if (lost)
+			{
+				if (air[i].join)
+				{
+					r->joinCollisions++;
+					r->firstJoinCollisions += (air[i].address <= TDMA_SLOTS);
+				}
+				else
+				{
+					r->dataCollisions++;
+				}
+			}
+			else if (air[i].join)
+			{
+				if (tdma_master_join(&m, air[i].address) >= 0 && r->joined[air[i].address] < 0)
+				{
+					r->joined[air[i].address] = superframe;
+					if (superframe >= SIM_SUPERFRAMES / 2 && r->rejoined < 0)
+					{
+						r->rejoined = superframe;
+					}
+				}
+			}
+			else if (tdma_master_heard(&m, air[i].address) >= 0 && superframe < SIM_SUPERFRAMES / 2)
+			{
+				r->delivered[air[i].address]++;
+			}
+		}
+	}
+}
+
+static int run_profile(int profile)
+{
+	static Sim_result r;
+	double seconds;
+	double perRemote;
+	int ok = 1;
+	int served, joinedBy, numJoined, remotes, address;
+
+	for (remotes = 1; remotes <= SIM_MAX_REMOTES; remotes++)
+	{
+		run(profile, remotes, &r);
+		seconds = (double)(SIM_SUPERFRAMES / 2) * r.superframe / 1e6;
+		served = 0;
+		perRemote = 0;
+		joinedBy = 0;
+		numJoined = 0;
+		for (address = 1; address <= remotes; address++)
+		{
+			if (r.delivered[address] > 0)
+			{
+				served++;
+				perRemote += r.delivered[address] / seconds;
+			}
+			if (r.joined[address] >= 0 && r.joined[address] < SIM_SUPERFRAMES / 2)
+			{
+				joinedBy = (r.joined[address] > joinedBy)? r.joined[address]: joinedBy;
+				numJoined++;
+			}
+		}
+		//A slot for every board while there are enough, boards beyond them wait
+		ok &= (numJoined == ((remotes < TDMA_SLOTS)? remotes: TDMA_SLOTS));
+		printf("%-9s remotes %d: superframe %6u usec  %6.1f packets/s per served remote  joined by superframe %4d  join collisions %4ld  data collisions %ld  overruns %ld",
+			profileNames[profile], remotes, (unsigned)r.superframe, served? perRemote / served: 0.0, joinedBy,
+			r.joinCollisions, r.dataCollisions, r.overruns);
+		if (remotes > TDMA_SLOTS)
+		{
+			printf("  slot of %d taken after %d superframes", r.off, r.rejoined - SIM_SUPERFRAMES / 2);
+			ok &= (r.rejoined >= 0);
+		}
+		putchar('\n');
+		//Addresses up to TDMA_SLOTS have join turns of their own
+		ok &= (r.dataCollisions == 0 && r.overruns == 0 && r.firstJoinCollisions == 0);
+	}
+	return ok;
+}
+
+int main(void)
+{
+	int ok = 1;
+	int profile;
+
+	for (profile = 0; profile < SIM_PROFILES; profile++)
+	{
+		ok &= run_profile(profile);
+	}
+	puts(ok? "ok": "FAILED");
+	return ok? 0: 1;
+}
+
+//! @}
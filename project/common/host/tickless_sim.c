@@ -0,0 +1,372 @@
+/*!
+ @file tickless_sim.c
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief Host simulation of the tickless idle thread (os_idle_sleep in RTX_Conf_CM.c with OS_TICKLESS=1).
+ The configuration file is compiled unchanged against a mocked SysTick, cycle by cycle, and a small kernel
+ keeping thread delays on os_suspend/os_resume. For a few board loads it counts the idle wake-ups and
+ checks kernel time against the tick grid of a free running periodic tick: no tick may be lost or counted
+ twice, none counted more than OS_IDLE_MARGIN early, and the grid drift, the cycles lost each time SysTick
+ is restarted after an early wake-up, must stay within a crystal tolerance. Exits with 1 on a failed check.
+ gcc -std=gnu99 -O2 -DBENCHMARK_HOST -I../inc tickless_sim.c -o tickless_sim -lm
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SIM_SECONDS 20	/*!< Simulated time per load */
+#define SIM_ACCESS 2	/*!< Cycles per SysTick register access */
+#define SIM_WORK 20000	/*!< Cycles a thread runs once woken, about 120 usec */
+#define SIM_MAX_DELAYS 4	/*!< Periodic thread delays per load */
+#define SIM_MAX_PPM 30	/*!< Largest grid drift accepted, parts per million */
+
+#define SysTick_CTRL_ENABLE_Msk	0x00000001
+#define SysTick_CTRL_TICKINT_Msk	0x00000002
+#define SysTick_CTRL_CLKSOURCE_Msk	0x00000004
+#define SysTick_CTRL_COUNTFLAG_Msk	0x00010000
+#define SCB_ICSR_PENDSTCLR_Msk	0x02000000
+
+/**
+* A structure to represent the SysTick registers
+*/
+typedef struct {
+	volatile uint32_t CTRL;	/**< control and status */
+	volatile uint32_t LOAD;	/**< reload value */
+	volatile uint32_t VAL;	/**< current value */
+	volatile uint32_t CALIB;	/**< calibration, unused */
+} SysTick_Type;
+
+/**
+* A structure to represent the SCB registers written by os_idle_sleep
+*/
+typedef struct {
+	volatile uint32_t ICSR;	/**< interrupt control and state */
+} SCB_Type;
+
+/**
+* A structure to represent one load: the periodic delays of the threads and an external interrupt
+*/
+typedef struct {
+	const char *name;	/**< the name printed */
+	int numDelays;	/**< the number of periodic delays */
+	uint32_t delays[SIM_MAX_DELAYS];	/**< each thread waits this many ticks after running */
+	uint32_t externalPeriod;	/**< msec between external interrupts, 0 for none */
+	int externalRandom;	/**< 1: exponential intervals with that mean, 0: a fixed rate */
+} Sim_load;
+
+static SysTick_Type *sim_systick(void);
+static void sim_wfi(void);
+static uint32_t sim_disable_irq(void);
+static void sim_enable_irq(void);
+
+static SCB_Type sim_scb;
+
+#define SysTick (sim_systick())
+#define SCB (&sim_scb)
+#define __WFI() sim_wfi()
+#define __disable_irq() sim_disable_irq()
+#define __enable_irq() sim_enable_irq()
+
+#define OS_TICKLESS 1
+#include "../config/RTX_Conf_CM.c"
+
+#define SIM_TICK (OS_TRV + 1)	/*!< Cycles per tick */
+
+// The SysTick counter
+static uint64_t now;
+static uint32_t ctrl;
+static uint32_t load;
+static uint32_t val;
+static SysTick_Type slot;
+static SysTick_Type handed;
+
+// Interrupts
+static int primask;
+static int tickPending;
+static int externalPending;
+static uint64_t nextExternal;
+
+// The kernel
+static const Sim_load *current;
+static uint32_t kernelTime;
+static uint32_t due[SIM_MAX_DELAYS];
+static int savedPending;
+static int ready;
+
+// Results, offsets in cycles from the start of the current kernel tick on the grid
+static uint32_t wakeups;
+static uint32_t tickInterrupts;
+static int64_t minOffset;
+static int64_t drift;
+
+static uint64_t next_external_time(void)
+{
+	double ms = current->externalPeriod;
+
+	if (current->externalRandom)
+	{
+		ms = -ms * log1p(-(rand() + 0.5) / (RAND_MAX + 1.0));
+	}
+	return now + (uint64_t)(ms * SIM_TICK) + 1;
+}
+
+//Kernel time moved: where it is against the grid, then the expired delays wake their threads
+static void service_delays(void)
+{
+	int64_t offset = (int64_t)now - (int64_t)kernelTime * SIM_TICK;
+	int i;
+
+	minOffset = (offset < minOffset)? offset: minOffset;
+	for (i = 0; i < current->numDelays; i++)
+	{
+		if ((int32_t)(kernelTime - due[i]) >= 0)
+		{
+			due[i] = 0xFFFFFFFF;
+			ready = 1;
+		}
+	}
+}
+
+static void run_interrupts(void)
+{
+	if (primask)
+	{
+		return;
+	}
+	if (tickPending)
+	{
+		tickPending = 0;
+		tickInterrupts++;
+		kernelTime++;
+		drift = (int64_t)now - (int64_t)kernelTime * SIM_TICK;	//an interrupt is on the shifted grid
+		service_delays();
+	}
+	if (externalPending)
+	{
+		externalPending = 0;
+		ready = 1;
+	}
+}
+
+//The counter reloads the cycle after it reaches 0: a period of LOAD + 1
+static void sim_advance(uint64_t n)
+{
+	uint64_t step;
+
+	while (n > 0)
+	{
+		step = n;
+		if (current->externalPeriod != 0 && nextExternal - now < step)
+		{
+			step = nextExternal - now;
+		}
+		if (ctrl & SysTick_CTRL_ENABLE_Msk)
+		{
+			if (val == 0)
+			{
+				val = load;
+				step = 1;
+			}
+			else
+			{
+				step = (val < step)? val: step;
+				val -= step;
+				if (val == 0)
+				{
+					ctrl |= SysTick_CTRL_COUNTFLAG_Msk;
+					tickPending |= (ctrl & SysTick_CTRL_TICKINT_Msk) != 0;
+				}
+			}
+		}
+		now += step;
+		n -= step;
+		if (current->externalPeriod != 0 && now >= nextExternal)
+		{
+			externalPending = 1;
+			nextExternal = next_external_time();
+		}
+		run_interrupts();
+	}
+}
+
+//Every access commits the writes to the previous one: a field that changed was written
+static SysTick_Type *sim_systick()
+{
+	if ((slot.CTRL & 7) != (handed.CTRL & 7))
+	{
+		ctrl = (ctrl & SysTick_CTRL_COUNTFLAG_Msk) | (slot.CTRL & 7);
+	}
+	if (slot.LOAD != handed.LOAD)
+	{
+		load = slot.LOAD & 0xFFFFFF;
+	}
+	if (slot.VAL != handed.VAL)
+	{
+		val = 0;
+		ctrl &= ~SysTick_CTRL_COUNTFLAG_Msk;
+	}
+	sim_advance(SIM_ACCESS);
+
+	//Only the check after the sleep reads COUNTFLAG, the VAL write before it clears a stale one
+	slot.CTRL = ctrl;
+	slot.LOAD = load;
+	slot.VAL = val;
+	ctrl &= ~SysTick_CTRL_COUNTFLAG_Msk;
+	handed = slot;
+	return &slot;
+}
+
+static void sim_wfi()
+{
+	uint64_t n;
+
+	sim_systick();
+	wakeups++;
+	while (!tickPending && !externalPending)
+	{
+		n = (current->externalPeriod != 0)? nextExternal - now: (uint64_t)SIM_TICK * 0x10000;
+		if ((ctrl & SysTick_CTRL_ENABLE_Msk) && (ctrl & SysTick_CTRL_TICKINT_Msk) &&
+			((val == 0)? (uint64_t)load + 1: val) < n)
+		{
+			n = (val == 0)? (uint64_t)load + 1: val;
+		}
+		primask++;
+		sim_advance(n);
+		primask--;
+	}
+	run_interrupts();
+}
+
+static uint32_t sim_disable_irq()
+{
+	primask = 1;
+	return 0;
+}
+
+static void sim_enable_irq()
+{
+	sim_systick();
+	if (sim_scb.ICSR & SCB_ICSR_PENDSTCLR_Msk)
+	{
+		tickPending = 0;
+		sim_scb.ICSR = 0;
+	}
+	primask = 0;
+	run_interrupts();
+}
+
+//OS_LOCK: the tick interrupt is off and its pending state saved
+uint32_t os_suspend()
+{
+	uint32_t sleep = 0xFFFF;
+	int i;
+
+	ctrl = (ctrl & SysTick_CTRL_COUNTFLAG_Msk) | 5;
+	savedPending = tickPending;
+	tickPending = 0;
+	for (i = 0; i < current->numDelays; i++)
+	{
+		if (due[i] != 0xFFFFFFFF && due[i] - kernelTime < sleep)
+		{
+			sleep = due[i] - kernelTime;
+		}
+	}
+	return sleep;
+}
+
+//OS_UNLOCK: the tick interrupt is back on with its saved pending state
+void os_resume(uint32_t sleep_time)
+{
+	kernelTime += sleep_time;
+	service_delays();
+	ctrl = (ctrl & SysTick_CTRL_COUNTFLAG_Msk) | 7;
+	tickPending |= savedPending;
+	run_interrupts();
+}
+
+static int run_load(const Sim_load *l)
+{
+	uint64_t end = (uint64_t)SIM_SECONDS * 1000 * SIM_TICK;
+	int64_t lost;
+	double ppm;
+	int i;
+
+	current = l;
+	now = 0;
+	ctrl = 7;
+	load = OS_TRV;
+	val = SIM_TICK;	//ticks on the grid: the counter reaches 0 at every multiple of SIM_TICK
+	slot.CTRL = handed.CTRL = ctrl;
+	slot.LOAD = handed.LOAD = load;
+	slot.VAL = handed.VAL = val;
+	primask = tickPending = externalPending = 0;
+	kernelTime = 0;
+	wakeups = tickInterrupts = 0;
+	os_idle_wakeups = os_idle_ticks = 0;
+	minOffset = drift = 0;
+	srand(1);
+	nextExternal = next_external_time();
+	for (i = 0; i < l->numDelays; i++)
+	{
+		due[i] = l->delays[i];
+	}
+
+	while (now < end)
+	{
+		ready = 0;
+		while (!ready && now < end)
+		{
+			os_idle_sleep();
+		}
+
+		//The woken threads run, then wait again from the current kernel time
+		sim_advance(SIM_WORK);
+		for (i = 0; i < l->numDelays; i++)
+		{
+			if (due[i] == 0xFFFFFFFF)
+			{
+				due[i] = kernelTime + l->delays[i];
+			}
+		}
+	}
+
+	//A few periodic ticks put the last interrupt on the shifted grid: whole ticks off are lost or doubled
+	sim_advance(3 * SIM_TICK);
+	lost = llround(drift / (double)SIM_TICK);
+	ppm = (drift - lost * SIM_TICK) * 1e6 / (double)now;
+	printf("%-22s wakeups/s %7.1f  tick ISRs/s %7.1f  sleeps/s %7.1f  lost %lld  early %lld cycles  drift %.1f ppm\n",
+		l->name, wakeups / (double)SIM_SECONDS, tickInterrupts / (double)SIM_SECONDS,
+		os_idle_wakeups / (double)SIM_SECONDS, (long long)lost, (long long)-minOffset, ppm);
+	return lost == 0 && minOffset >= -(int64_t)OS_IDLE_MARGIN && ppm > -SIM_MAX_PPM && ppm < SIM_MAX_PPM;
+}
+
+int main(void)
+{
+	static const Sim_load loads[] = {
+		{"idle remote", 2, {250, 500}, 0, 0},
+		{"idle base", 1, {500}, 0, 0},
+		{"accelerometer 100 Hz", 2, {250, 500}, 10, 0},
+		{"random interrupts", 3, {7, 250, 500}, 13, 1},
+		{"short delays", 3, {1, 2, 3}, 0, 0},
+	};
+	int ok = 1;
+	unsigned int i;
+
+	printf("periodic tick: %d wakeups/s\n", OS_TICK);
+	for (i = 0; i < sizeof(loads) / sizeof(loads[0]); i++)
+	{
+		ok &= run_load(&loads[i]);
+	}
+	puts(ok? "ok": "FAILED");
+	return ok? 0: 1;
+}
+
+//! @}
@@ -0,0 +1,157 @@
+/*!
+ @file waypoint_fuzz.c
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief Host fuzz test of the keypad waypoint parser (remote_board/waypoint_program.c), compiled unchanged.
+ Random key streams, half of them biased towards well formed waypoints so programs fill up, are fed one
+ key at a time. After every key the program must hold at most WAYPOINT_PROGRAM_SIZE waypoints, its count
+ must follow the results (+1 on PARSER_WAYPOINT, 0 on PARSER_CANCEL, unchanged otherwise) and every
+ waypoint must have its angles within +/- WAYPOINT_MAX_ANGLE and its time within WAYPOINT_MIN_TIME to
+ WAYPOINT_MAX_TIME. Exits with 1 on the first failed check, printing the seed and the keys fed so far.
+ gcc -std=gnu99 -O2 -I../../remote_board waypoint_fuzz.c ../../remote_board/waypoint_program.c -o waypoint_fuzz
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#include "waypoint_program.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FUZZ_STREAMS 20000	/*!< Key streams fed, each to a fresh parser and program */
+#define FUZZ_KEYS 2000	/*!< Keys per stream */
+
+static const char keypad[] = "0123456789ABCD*#";
+
+static char history[FUZZ_KEYS];
+
+//Any byte, mostly keypad keys
+static char random_key(void)
+{
+	if (rand() % 32 == 0)
+	{
+		return (char)(rand() % 256);
+	}
+	return keypad[rand() % (sizeof(keypad) - 1)];
+}
+
+//A waypoint that is usually valid: sign, digits and separators, with a random key now and then
+static char waypoint_key(int *step)
+{
+	static const char form[] = "#99D*99DNNA";
+	char c = form[*step % (sizeof(form) - 1)];
+
+	(*step)++;
+	if (rand() % 16 == 0)
+	{
+		return random_key();
+	}
+	if (c == '#' || c == '*')
+	{
+		return (rand() % 2)? '#': '*';
+	}
+	if (c == '9' || c == 'N')
+	{
+		return '0' + rand() % 10;
+	}
+	return c;
+}
+
+static int check_program(const Waypoint_program *p, int expected)
+{
+	int i;
+
+	if (p->count < 0 || p->count > WAYPOINT_PROGRAM_SIZE || p->count != expected)
+	{
+		printf("count %d, expected %d\n", p->count, expected);
+		return 0;
+	}
+	for (i = 0; i < p->count; i++)
+	{
+		const Waypoint *w = &p->waypoints[i];
+
+		if (w->rollAngle < -WAYPOINT_MAX_ANGLE || w->rollAngle > WAYPOINT_MAX_ANGLE ||
+			w->pitchAngle < -WAYPOINT_MAX_ANGLE || w->pitchAngle > WAYPOINT_MAX_ANGLE ||
+			w->delta_t < WAYPOINT_MIN_TIME || w->delta_t > WAYPOINT_MAX_TIME)
+		{
+			printf("waypoint %d: roll %d pitch %d time %d\n", i, w->rollAngle, w->pitchAngle, w->delta_t);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int run_stream(unsigned int seed, int structured, unsigned long results[])
+{
+	Waypoint_parser parser;
+	Waypoint_program program;
+	Parser_result r;
+	int expected = 0;
+	int step = 0;
+	int ok;
+	int i;
+
+	srand(seed);
+	waypoint_parser_reset(&parser);
+	waypoint_program_clear(&program);
+	for (i = 0; i < FUZZ_KEYS; i++)
+	{
+		history[i] = structured? waypoint_key(&step): random_key();
+		r = waypoint_parser_feed(&parser, &program, history[i]);
+		results[r]++;
+		if (r == PARSER_WAYPOINT)
+		{
+			expected++;
+		}
+		else if (r == PARSER_CANCEL)
+		{
+			expected = 0;
+		}
+		ok = check_program(&program, expected);
+		if (ok && r == PARSER_FULL && program.count != WAYPOINT_PROGRAM_SIZE)
+		{
+			printf("PARSER_FULL with %d waypoints\n", program.count);
+			ok = 0;
+		}
+		if (!ok)
+		{
+			printf("seed %u, keys: ", seed);
+			for (step = 0; step <= i; step++)
+			{
+				putchar((history[step] >= ' ' && history[step] <= '~')? history[step]: '?');
+			}
+			putchar('\n');
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int main(void)
+{
+	static const char *names[] = {"rejected", "key", "waypoint", "full", "send", "cancel", "save", "replay"};
+	unsigned long results[PARSER_REPLAY + 1] = {0};
+	unsigned int seed;
+	int i;
+
+	for (seed = 1; seed <= FUZZ_STREAMS; seed++)
+	{
+		if (!run_stream(seed, seed % 2, results))
+		{
+			puts("FAILED");
+			return 1;
+		}
+	}
+	for (i = 0; i <= PARSER_REPLAY; i++)
+	{
+		printf("%s %lu  ", names[i], results[i]);
+	}
+	puts("\nok");
+	return 0;
+}
+
+//! @}
@@ -50,7 +50,7 @@
 #define _declare_box(pool,size,cnt)  uint32_t pool[(((size)+3)/4)*(cnt) + 3]
 #define _declare_box8(pool,size,cnt) uint64_t pool[(((size)+7)/8)*(cnt) + 2]
 
-#define OS_TCB_SIZE     48
+#define OS_TCB_SIZE     76
 #define OS_TMR_SIZE     8
 
 #if defined (__CC_ARM) && !defined (__MICROLIB)
@@ -98,6 +98,8 @@ uint32_t const os_stackinfo  = (OS_STKCHECK<<24)| (OS_PRIV_CNT<<16) | (OS_STKSIZ
 uint32_t const os_rrobin     = (OS_ROBIN << 16) | OS_ROBINTOUT;
 uint32_t const os_trv        = OS_TRV;
 uint8_t  const os_flags      = OS_RUNPRIV;
+uint8_t  const os_monitor    = OS_MONITOR;
+uint8_t  const os_telemetry_cnt = OS_TELEMETRY;
 
 /* Export following defines to uVision debugger. */
 __USED uint32_t const os_clockrate = OS_TICK;
@@ -126,6 +128,20 @@ uint8_t  const os_fifo_size = OS_FIFOSZ;
 /* An array of Active task pointers. */
 void *os_active_TCB[OS_TASK_CNT];
 
+/* Thread run time in cycles (+idle demon at index 0). */
+#if (OS_MONITOR != 0)
+uint32_t os_mon_cycles[OS_TASK_CNT+1];
+#else
+uint32_t os_mon_cycles[1];
+#endif
+
+/* Pool and message queue usage counters (object ID + osObjectStats). */
+#if (OS_TELEMETRY != 0)
+uint32_t os_telemetry[OS_TELEMETRY*7];
+#else
+uint32_t os_telemetry[1];
+#endif
+
 /* User Timers Resources */
 #if (OS_TIMERS != 0)
 extern void osTimerThread (void const *argument);
@@ -167,6 +183,12 @@ uint16_t const mp_tmr_size = 0;
  void rt_stk_check  (void) {;}
 #endif
 
+#if OS_MONITOR == 0
+ void rt_mon_init      (void) {;}
+ void rt_mon_task_init (void *p_TCB) {;}
+ void rt_mon_switch    (void *p_new) {;}
+#endif
+
 
 /*----------------------------------------------------------------------------
  *      Standard Library multithreading interface
@@ -113,6 +113,7 @@ used throughout the whole project.
 #define osFeature_MessageQ     1       ///< Message Queues:  1=available, 0=not available
 #define osFeature_Signals      16      ///< maximum number of Signal Flags available per thread
 #define osFeature_Semaphore    8       ///< maximum count for SemaphoreInit function
+#define osFeature_EventFlags   16      ///< maximum number of flags per event flag group, 0=not available
 #define osFeature_Wait         0       ///< osWait function: 1=available, 0=not available
 
 #if defined (__CC_ARM)
@@ -203,6 +204,10 @@ typedef struct os_mutex_cb *osMutexId;
 /// \note CAN BE CHANGED: \b os_semaphore_cb is implementation specific in every CMSIS-RTOS.
 typedef struct os_semaphore_cb *osSemaphoreId;
 
+/// Event Flags ID identifies the event flag group (pointer to an event flags control block).
+/// \note CAN BE CHANGED: \b os_evtflags_cb is implementation specific in every CMSIS-RTOS.
+typedef struct os_evtflags_cb *osEventFlagsId;
+
 /// Pool ID identifies the memory pool (pointer to a memory pool control block).
 /// \note CAN BE CHANGED: \b os_pool_cb is implementation specific in every CMSIS-RTOS.
 typedef struct os_pool_cb *osPoolId;
@@ -223,6 +228,7 @@ typedef const struct os_thread_def  {
   osPriority             tpriority;    ///< initial thread priority
   uint32_t               instances;    ///< maximum number of instances of that thread function
   uint32_t               stacksize;    ///< stack size requirements in bytes; 0 is default stack size
+  uint32_t                 quantum;    ///< round-robin time slice in ticks; 0 is OS_ROBINTOUT (RTX extension)
 } osThreadDef_t;
 
 /// Timer Definition structure contains timer parameters.
@@ -244,6 +250,12 @@ typedef const struct os_semaphore_def  {
   void                  *semaphore;    ///< pointer to internal data
 } osSemaphoreDef_t;
 
+/// Event Flags Definition structure contains setup information for an event flag group.
+/// \note CAN BE CHANGED: \b os_evtflags_def is implementation specific in every CMSIS-RTOS.
+typedef const struct os_evtflags_def  {
+  void                   *evtflags;    ///< pointer to internal data
+} osEventFlagsDef_t;
+
 /// Definition structure for memory block allocation
 /// \note CAN BE CHANGED: \b os_pool_def is implementation specific in every CMSIS-RTOS.
 typedef const struct os_pool_def  {
@@ -283,6 +295,28 @@ typedef struct  {
   } def;                               ///< event definition
 } osEvent;
 
+/// Thread run time and stack usage reported by \ref osThreadGetInfo.
+/// \note RTX extension: cycles and stack usage require OS_MONITOR in RTX_Conf_CM.c, the counters are always kept.
+typedef struct  {
+  uint32_t                  cycles;    ///< CPU cycles consumed (wraps, use differences)
+  uint32_t              stack_size;    ///< stack size in bytes
+  uint32_t              stack_used;    ///< stack high-water mark in bytes
+  uint32_t                preempts;    ///< times switched out while still ready to run, osThreadYield excluded
+  uint32_t                  slices;    ///< round-robin time slices used up (subset of preempts)
+  uint32_t                  misses;    ///< deadline misses of a periodic thread, see \ref osThreadSetPeriod
+} osThreadInfo;
+
+/// Memory pool or message queue usage reported by \ref osPoolGetStats and \ref osMessageGetStats.
+/// \note RTX extension: requires OS_TELEMETRY in RTX_Conf_CM.c.
+typedef struct  {
+  uint32_t                capacity;    ///< number of blocks or messages
+  uint32_t                   count;    ///< blocks allocated or messages queued now
+  uint32_t                    peak;    ///< highest count since creation
+  uint32_t                failures;    ///< allocations from an empty pool, puts that found the queue full or timed out
+  uint32_t                put_wait;    ///< ticks spent blocked in \ref osMessagePut
+  uint32_t                get_wait;    ///< ticks spent blocked in \ref osMessageGet
+} osObjectStats;
+
 
 //  ==== Kernel Control Functions ====
 
@@ -298,6 +332,14 @@ osStatus osKernelStart (osThreadDef_t *thread_def, void *argument);
 /// \return 0 RTOS is not started, 1 RTOS is started.
 int32_t osKernelRunning(void);
 
+/// Suspend the scheduler for tickless idle (RTX specific, call from os_idle_demon only).
+/// \return number of ticks until the next thread delay or timer expires, 0xFFFF if none.
+uint32_t os_suspend (void);
+
+/// Resume the scheduler after tickless idle (RTX specific, call from os_idle_demon only).
+/// \param[in]     sleep_time    number of ticks that elapsed while suspended.
+void os_resume (uint32_t sleep_time);
+
 
 //  ==== Thread Management ====
 
@@ -317,6 +359,22 @@ osThreadDef_t os_thread_def_##name = \
 { (name), (priority), (instances), (stacksz)  };
 #endif
 
+/// Create a Thread Definition with its own round-robin time slice.
+/// \param         name         name of the thread function.
+/// \param         priority     initial priority of the thread function.
+/// \param         instances    number of possible thread instances.
+/// \param         stacksz      stack size (in bytes) requirements for the thread function.
+/// \param         quantum      ticks the thread runs before an equal priority thread gets the CPU; 0 is OS_ROBINTOUT.
+/// \note RTX extension: the quantum only applies when OS_ROBIN is enabled in RTX_Conf_CM.c.
+#if defined (osObjectsExternal)  // object is external
+#define osThreadDefQuantum(name, priority, instances, stacksz, quantum)  \
+extern osThreadDef_t os_thread_def_##name;
+#else                            // define the object
+#define osThreadDefQuantum(name, priority, instances, stacksz, quantum)  \
+osThreadDef_t os_thread_def_##name = \
+{ (name), (priority), (instances), (stacksz), (quantum)  };
+#endif
+
 /// Access a Thread defintion.
 /// \param         name          name of the thread definition object.
 /// \note CAN BE CHANGED: The parameter to \b osThread shall be consistent but the 
@@ -361,6 +419,37 @@ osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority);
 /// \note MUST REMAIN UNCHANGED: \b osThreadGetPriority shall be consistent in every CMSIS-RTOS.
 osPriority osThreadGetPriority (osThreadId thread_id);
 
+/// Get run time and stack usage of an active thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId, NULL for the idle thread.
+/// \param[out]    info          run time and stack usage of the thread.
+/// \return status code that indicates the execution status of the function.
+/// \note RTX extension: cycles and stack usage read 0 when OS_MONITOR is disabled.
+osStatus osThreadGetInfo (osThreadId thread_id, osThreadInfo *info);
+
+/// Make an active thread periodic: the kernel releases one job every period, the thread runs it and calls
+/// \ref osThreadWaitPeriod. The current job counts as released now.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId.
+/// \param[in]     period        release period in millisec, 0 to make the thread aperiodic again.
+/// \param[in]     deadline      time in millisec after a release by which the job has to end, 0 for the period.
+/// \return status code that indicates the execution status of the function.
+/// \note RTX extension: the period must be shorter than 32768 ticks and the deadline at most the period.
+osStatus osThreadSetPeriod (osThreadId thread_id, uint32_t period, uint32_t deadline);
+
+/// End the current job of the running periodic thread and wait for the release of the next one.
+/// A job that ends after its deadline is a miss. Releases that pass while a job overruns are skipped and
+/// also count as misses, so a late thread catches up instead of running jobs back to back.
+/// \return deadline misses of this job (normally 0), or -1 if the thread is not periodic.
+/// \note RTX extension.
+int32_t osThreadWaitPeriod (void);
+
+/// Assign rate monotonic priorities to all periodic threads: the longest period gets \a priority and each
+/// shorter period one level more, up to \ref osPriorityHigh. Threads with equal periods share a level.
+/// Call again after changing periods.
+/// \param[in]     priority      priority of the periodic thread with the longest period.
+/// \return status code that indicates the execution status of the function.
+/// \note RTX extension.
+osStatus osThreadRateMonotonic (osPriority priority);
+
 
 
 //  ==== Generic Wait Functions ====
@@ -543,6 +632,66 @@ int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec);
 osStatus osSemaphoreRelease (osSemaphoreId semaphore_id);
 
 #endif     // Semaphore available
+
+
+//  ==== Event Flags Management Functions ====
+
+#if (defined (osFeature_EventFlags)  &&  (osFeature_EventFlags != 0))     // Event Flags available
+
+/// Wait options for \ref osEventFlagsWait, can be combined.
+#define osFlagsWaitAny         0x00    ///< wait for any of the flags (default)
+#define osFlagsWaitAll         0x01    ///< wait for all of the flags
+#define osFlagsNoClear         0x02    ///< do not clear the flags that satisfied the wait
+
+/// Define an Event Flags object.
+/// \param         name          name of the event flags object.
+#if defined (osObjectsExternal)  // object is external
+#define osEventFlagsDef(name)  \
+extern osEventFlagsDef_t os_evtflags_def_##name;
+#else                            // define the object
+#define osEventFlagsDef(name)  \
+uint32_t os_evtflags_cb_##name[2]; \
+osEventFlagsDef_t os_evtflags_def_##name = { (os_evtflags_cb_##name) };
+#endif
+
+/// Access an Event Flags definition.
+/// \param         name          name of the event flags object.
+#define osEventFlags(name)  \
+&os_evtflags_def_##name
+
+/// Create and Initialize an Event Flags object. All flags start cleared.
+/// \param[in]     evtflags_def  event flags definition referenced with \ref osEventFlags.
+/// \return event flags ID for reference by other functions or NULL in case of error.
+osEventFlagsId osEventFlagsCreate (osEventFlagsDef_t *evtflags_def);
+
+/// Set the specified Event Flags and wake every thread whose wait is satisfied, in one pass.
+/// \param[in]     evtflags_id   event flags object referenced with \ref osEventFlags.
+/// \param[in]     flags         specifies the flags that shall be set.
+/// \return flags after setting (the matched flags of woken threads are cleared) or 0x80000000 in case of incorrect parameters.
+/// \note Can be called from Interrupt Service Routines, the wakeup is then deferred to the kernel.
+int32_t osEventFlagsSet (osEventFlagsId evtflags_id, int32_t flags);
+
+/// Clear the specified Event Flags.
+/// \param[in]     evtflags_id   event flags object referenced with \ref osEventFlags.
+/// \param[in]     flags         specifies the flags that shall be cleared.
+/// \return flags before clearing or 0x80000000 in case of incorrect parameters.
+int32_t osEventFlagsClear (osEventFlagsId evtflags_id, int32_t flags);
+
+/// Get the current Event Flags.
+/// \param[in]     evtflags_id   event flags object referenced with \ref osEventFlags.
+/// \return current flags or 0x80000000 in case of incorrect parameters.
+/// \note Can be called from Interrupt Service Routines.
+int32_t osEventFlagsGet (osEventFlagsId evtflags_id);
+
+/// Wait for any (or all) of the specified Event Flags. Any number of threads can wait on the same object.
+/// \param[in]     evtflags_id   event flags object referenced with \ref osEventFlags.
+/// \param[in]     flags         specifies the flags to wait for.
+/// \param[in]     options       \ref osFlagsWaitAny or \ref osFlagsWaitAll, optionally with \ref osFlagsNoClear.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return flags that satisfied the wait, 0 in case of a time-out or 0x80000000 in case of incorrect parameters.
+int32_t osEventFlagsWait (osEventFlagsId evtflags_id, int32_t flags, uint32_t options, uint32_t millisec);
+
+#endif     // Event Flags available
  
 //  ==== Memory Pool Management Functions ====
 
@@ -596,6 +745,12 @@ void *osPoolCAlloc (osPoolId pool_id);
 /// \note MUST REMAIN UNCHANGED: \b osPoolFree shall be consistent in every CMSIS-RTOS.
 osStatus osPoolFree (osPoolId pool_id, void *block);
 
+/// Get the usage counters of a memory pool (RTX extension).
+/// \param[in]     pool_id       memory pool ID obtain referenced with \ref osPoolCreate.
+/// \param[out]    stats         usage counters.
+/// \return status code: osErrorResource if the pool is not tracked (OS_TELEMETRY too small or 0).
+osStatus osPoolGetStats (osPoolId pool_id, osObjectStats *stats);
+
 #endif   // Memory Pool Management available
 
 
@@ -648,6 +803,37 @@ osStatus osMessagePut (osMessageQId queue_id, uint32_t info, uint32_t millisec);
 /// \note MUST REMAIN UNCHANGED: \b osMessageGet shall be consistent in every CMSIS-RTOS.
 os_InRegs osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec);
 
+/// Put several Messages to a Queue with one kernel entry per batch (RTX extension).
+/// Messages that fit are queued (or handed to waiting threads) at once and the
+/// receiver is woken once; when the queue is full the call waits up to \a millisec
+/// for each further free entry.
+/// \param[in]     queue_id      message queue ID obtained with \ref osMessageCreate.
+/// \param[in]     info          array of \a count message information values.
+/// \param[in]     count         number of messages to put.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out (must be 0 in ISRs).
+/// \return number of messages put, in order.
+int32_t osMessagePutN (osMessageQId queue_id, const uint32_t *info, uint32_t count, uint32_t millisec);
+
+/// Get several Messages from a Queue with one kernel entry (RTX extension).
+/// Waits up to \a millisec only while the queue is empty, then returns what is queued.
+/// \param[in]     queue_id      message queue ID obtained with \ref osMessageCreate.
+/// \param[out]    info          array receiving up to \a count message information values.
+/// \param[in]     count         size of \a info.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out (must be 0 in ISRs).
+/// \return number of messages received.
+int32_t osMessageGetN (osMessageQId queue_id, uint32_t *info, uint32_t count, uint32_t millisec);
+
+/// Get the number of Messages in a Queue (RTX extension).
+/// \param[in]     queue_id      message queue ID obtained with \ref osMessageCreate.
+/// \return number of messages queued now, 0 for an invalid queue_id.
+uint32_t osMessageCount (osMessageQId queue_id);
+
+/// Get the usage counters of a message queue (RTX extension).
+/// \param[in]     queue_id      message queue ID obtained with \ref osMessageCreate.
+/// \param[out]    stats         usage counters.
+/// \return status code: osErrorResource if the queue is not tracked (OS_TELEMETRY too small or 0).
+osStatus osMessageGetStats (osMessageQId queue_id, osObjectStats *stats);
+
 #endif     // Message Queues available
 
 
@@ -49,6 +49,8 @@ extern U32 mp_tcb[];
 extern U64 mp_stk[];
 extern U32 os_fifo[];
 extern void *os_active_TCB[];
+extern U32 os_mon_cycles[];
+extern U32 os_telemetry[];
 
 /* Constants */
 extern U16 const os_maxtaskrun;
@@ -63,6 +65,8 @@ extern U32 const mp_stk_size;
 extern U32 const *m_tmr;
 extern U16 const mp_tmr_size;
 extern U8  const os_fifo_size;
+extern U8  const os_monitor;
+extern U8  const os_telemetry_cnt;
 
 /* Functions */
 extern void os_idle_demon   (void);
@@ -53,9 +53,11 @@
 #include "rt_Time.h"
 #include "rt_Mutex.h"
 #include "rt_Semaphore.h"
+#include "rt_EvtFlags.h"
 #include "rt_Mailbox.h"
 #include "rt_MemBox.h"
 #include "rt_Memory.h"
+#include "rt_Monitor.h"
 #include "rt_HAL_CM.h"
 
 #define os_thread_cb OS_TCB
@@ -71,6 +73,9 @@
 #if (osFeature_Wait != 0)
 #error osWait not supported!
 #endif
+#if (osFeature_EventFlags != 16)
+#error Invalid "osFeature_EventFlags" value!
+#endif
 
 
 // ==== Enumeration, structures, defines ====
@@ -453,7 +458,9 @@ static void *rt_id2obj (void *id) {
 // ==== Kernel Control ====
 
 // Kernel Control Service Calls declarations
-SVC_2_1(svcKernelStart, osStatus, osThreadDef_t *, void *, RET_osStatus);
+SVC_2_1(svcKernelStart,   osStatus, osThreadDef_t *, void *, RET_osStatus);
+SVC_0_1(svcKernelSuspend, int32_t,                          RET_int32_t);
+SVC_1_1(svcKernelResume,  osStatus, uint32_t,               RET_osStatus);
 
 __NO_RETURN void osThreadExit (void);
 
@@ -524,6 +531,17 @@ osStatus svcKernelStart (osThreadDef_t *thread_def, void *argument) {
   return osOK;
 }
 
+/// Suspend the scheduler and return the number of ticks it may sleep
+int32_t svcKernelSuspend (void) {
+  return (int32_t)rt_suspend();
+}
+
+/// Resume the scheduler after "sleep_time" ticks have elapsed
+osStatus svcKernelResume (uint32_t sleep_time) {
+  rt_resume(sleep_time);
+  return osOK;
+}
+
 // Kernel Control Public API
 
 /// Start the RTOS Kernel with executing the specified thread
@@ -561,6 +579,18 @@ int32_t osKernelRunning(void) {
   return (os_tsk.run != NULL) ?  1 : 0;
 }
 
+/// Suspend the scheduler for tickless idle (called from os_idle_demon)
+uint32_t os_suspend (void) {
+  if (__get_IPSR() != 0) return 0;              // Not allowed in ISR
+  return (uint32_t)__svcKernelSuspend();
+}
+
+/// Resume the scheduler after tickless idle
+void os_resume (uint32_t sleep_time) {
+  if (__get_IPSR() != 0) return;                // Not allowed in ISR
+  __svcKernelResume(sleep_time);
+}
+
 
 // ==== Thread Management ====
 
@@ -576,6 +606,10 @@ SVC_1_1(svcThreadTerminate,   osStatus,   osThreadId,                  RET_osSta
 SVC_0_1(svcThreadYield,       osStatus,                                RET_osStatus);
 SVC_2_1(svcThreadSetPriority, osStatus,   osThreadId,      osPriority, RET_osStatus);
 SVC_1_1(svcThreadGetPriority, osPriority, osThreadId,                  RET_osPriority);
+SVC_2_1(svcThreadGetInfo,     osStatus,   osThreadId,  osThreadInfo *, RET_osStatus);
+SVC_3_1(svcThreadSetPeriod,   osStatus,   osThreadId,      uint32_t, uint32_t, RET_osStatus);
+SVC_0_1(svcThreadWaitPeriod,  int32_t,                                 RET_int32_t);
+SVC_1_1(svcThreadRateMonotonic, osStatus, osPriority,                  RET_osStatus);
 
 // Thread Service Calls
 
@@ -626,6 +660,12 @@ osThreadId svcThreadCreate (osThreadDef_t *thread_def, void *argument) {
 
   *((uint32_t *)ptcb->tsk_stack + 13) = (uint32_t)osThreadExit;
 
+  if (thread_def->quantum > 0xFFFF) {           // Round Robin time slice
+    ptcb->quantum = 0xFFFF;
+  } else {
+    ptcb->quantum = (U16)thread_def->quantum;
+  }
+
   return ptcb;
 }
 
@@ -698,6 +738,72 @@ osPriority svcThreadGetPriority (osThreadId thread_id) {
   return (osPriority)(ptcb->prio - 1 + osPriorityIdle); 
 }
 
+/// Get run time and stack usage of an active thread
+osStatus svcThreadGetInfo (osThreadId thread_id, osThreadInfo *info) {
+  P_TCB ptcb;
+
+  if (info == NULL) return osErrorParameter;
+
+  if (thread_id == NULL) {
+    ptcb = &os_idle_TCB;                        // Idle demon
+  } else {
+    ptcb = rt_tid2ptcb(thread_id);              // Get TCB pointer
+    if (ptcb == NULL) return osErrorParameter;
+  }
+
+  if (os_monitor != 0) {
+    rt_mon_switch(os_tsk.run);                  // Charge running thread up to now
+    info->cycles     = rt_mon_cycles(ptcb);
+    info->stack_size = rt_mon_stack_size(ptcb);
+    info->stack_used = rt_mon_stack_used(ptcb);
+  } else {
+    info->cycles     = 0;                       // Monitor not configured
+    info->stack_size = 0;
+    info->stack_used = 0;
+  }
+  info->preempts   = ptcb->preempts;            // Counted by the scheduler
+
+  info->slices     = ptcb->slices;
+  info->misses     = ptcb->misses;
+
+  return osOK;
+}
+
+/// Make an active thread periodic
+osStatus svcThreadSetPeriod (osThreadId thread_id, uint32_t period, uint32_t deadline) {
+  P_TCB    ptcb;
+  uint32_t prd, dl;
+
+  ptcb = rt_tid2ptcb(thread_id);                // Get TCB pointer
+  if (ptcb == NULL) return osErrorParameter;
+
+  prd = (period   != 0) ? rt_ms2tick(period)   : 0;
+  dl  = (deadline != 0) ? rt_ms2tick(deadline) : 0;
+  if ((prd > 0x7FFF) || (dl > prd)) {           // Wrap-safe range of os_time
+    return osErrorValue;
+  }
+
+  rt_prd_set(ptcb, (U16)prd, (U16)dl);          // First job released now
+
+  return osOK;
+}
+
+/// Wait for the next release of the running periodic thread
+int32_t svcThreadWaitPeriod (void) {
+  if (os_tsk.run->period == 0) return -1;       // Not a periodic thread
+  return rt_prd_wait();                         // Deadline misses of this job
+}
+
+/// Assign rate monotonic priorities to the periodic threads
+osStatus svcThreadRateMonotonic (osPriority priority) {
+  if ((priority < osPriorityIdle) || (priority > osPriorityHigh)) {
+    return osErrorValue;
+  }
+  rt_prd_rm(priority - osPriorityIdle + 1,      // Longest period
+            osPriorityHigh - osPriorityIdle + 1);  // Shortest periods
+  return osOK;
+}
+
 
 // Thread Public API
 
@@ -737,6 +843,30 @@ osPriority osThreadGetPriority (osThreadId thread_id) {
   return __svcThreadGetPriority(thread_id);
 }
 
+/// Get run time and stack usage of an active thread
+osStatus osThreadGetInfo (osThreadId thread_id, osThreadInfo *info) {
+  if (__get_IPSR() != 0) return osErrorISR;     // Not allowed in ISR
+  return __svcThreadGetInfo(thread_id, info);
+}
+
+/// Make an active thread periodic
+osStatus osThreadSetPeriod (osThreadId thread_id, uint32_t period, uint32_t deadline) {
+  if (__get_IPSR() != 0) return osErrorISR;     // Not allowed in ISR
+  return __svcThreadSetPeriod(thread_id, period, deadline);
+}
+
+/// Wait for the next release of the running periodic thread
+int32_t osThreadWaitPeriod (void) {
+  if (__get_IPSR() != 0) return -1;             // Not allowed in ISR
+  return __svcThreadWaitPeriod();
+}
+
+/// Assign rate monotonic priorities to the periodic threads
+osStatus osThreadRateMonotonic (osPriority priority) {
+  if (__get_IPSR() != 0) return osErrorISR;     // Not allowed in ISR
+  return __svcThreadRateMonotonic(priority);
+}
+
 /// INTERNAL - Not Public
 /// Auto Terminate Thread on exit (used implicitly when thread exists)
 __NO_RETURN void osThreadExit (void) { 
@@ -1017,6 +1147,31 @@ void sysTimerTick (void) {
 }
 
 
+/// Ticks until the first active Timer expires (0xFFFF if none)
+uint32_t sysUserTimerWakeupTime (void) {
+
+  if (os_timer_head != NULL) {
+    return os_timer_head->tcnt;
+  }
+  return 0xFFFF;
+}
+
+/// Account "sleep_time" ticks elapsed in tickless idle
+void sysUserTimerUpdate (uint32_t sleep_time) {
+
+  while ((os_timer_head != NULL) && (sleep_time != 0)) {
+    if (sleep_time >= os_timer_head->tcnt) {
+      sleep_time -= os_timer_head->tcnt;
+      os_timer_head->tcnt = 1;
+      sysTimerTick();                           // Fire expired timers
+    } else {
+      os_timer_head->tcnt -= (uint16_t)sleep_time;
+      break;
+    }
+  }
+}
+
+
 // Timer Management Public API
 
 /// Create timer
@@ -1402,6 +1557,253 @@ osStatus osSemaphoreRelease (osSemaphoreId semaphore_id) {
 }
 
 
+// ==== Event Flags Management ====
+
+#define EVTFLAGS_MASK  (0xFFFFFFFF << osFeature_EventFlags)
+
+// Event Flags Service Calls declarations
+SVC_1_1(svcEventFlagsCreate, osEventFlagsId, osEventFlagsDef_t *,                             RET_pointer);
+SVC_2_1(svcEventFlagsSet,    int32_t,        osEventFlagsId,      int32_t,                    RET_int32_t);
+SVC_2_1(svcEventFlagsClear,  int32_t,        osEventFlagsId,      int32_t,                    RET_int32_t);
+SVC_4_1(svcEventFlagsWait,   int32_t,        osEventFlagsId,      int32_t, uint32_t, uint32_t, RET_int32_t);
+
+// Event Flags Service Calls
+
+/// Create and Initialize an Event Flags object
+osEventFlagsId svcEventFlagsCreate (osEventFlagsDef_t *evtflags_def) {
+  OS_ID flg;
+
+  if (evtflags_def == NULL) {
+    sysThreadError(osErrorParameter);
+    return NULL;
+  }
+
+  flg = evtflags_def->evtflags;
+  if (flg == NULL) {
+    sysThreadError(osErrorParameter);
+    return NULL;
+  }
+
+  if (((P_FCB)flg)->cb_type != 0) {
+    sysThreadError(osErrorParameter);
+    return NULL;
+  }
+
+  rt_flg_init(flg, 0);                          // Initialize Event Flags
+
+  return flg;
+}
+
+/// Set the specified Event Flags
+int32_t svcEventFlagsSet (osEventFlagsId evtflags_id, int32_t flags) {
+  OS_ID flg;
+
+  flg = rt_id2obj(evtflags_id);
+  if (flg == NULL) return 0x80000000;
+
+  if (((P_FCB)flg)->cb_type != FCB) return 0x80000000;
+
+  if (flags & EVTFLAGS_MASK) return 0x80000000;
+
+  return rt_flg_set(flg, (U16)flags);           // Set flags and wake waiters
+}
+
+/// Clear the specified Event Flags
+int32_t svcEventFlagsClear (osEventFlagsId evtflags_id, int32_t flags) {
+  OS_ID flg;
+
+  flg = rt_id2obj(evtflags_id);
+  if (flg == NULL) return 0x80000000;
+
+  if (((P_FCB)flg)->cb_type != FCB) return 0x80000000;
+
+  if (flags & EVTFLAGS_MASK) return 0x80000000;
+
+  return rt_flg_clr(flg, (U16)flags);           // Clear flags
+}
+
+/// Wait for any (or all) of the specified Event Flags
+int32_t svcEventFlagsWait (osEventFlagsId evtflags_id, int32_t flags, uint32_t options, uint32_t millisec) {
+  OS_ID flg;
+
+  flg = rt_id2obj(evtflags_id);
+  if (flg == NULL) return 0x80000000;
+
+  if (((P_FCB)flg)->cb_type != FCB) return 0x80000000;
+
+  if ((flags == 0) || (flags & EVTFLAGS_MASK)) return 0x80000000;
+
+  // Returns 0 when the thread blocks, rt_flg_set returns the matched flags in its place
+  return rt_flg_wait(flg, (U16)flags, options, rt_ms2tick(millisec));
+}
+
+
+// Event Flags ISR Calls
+
+/// Set the specified Event Flags
+static __INLINE int32_t isrEventFlagsSet (osEventFlagsId evtflags_id, int32_t flags) {
+  OS_ID flg;
+
+  flg = rt_id2obj(evtflags_id);
+  if (flg == NULL) return 0x80000000;
+
+  if (((P_FCB)flg)->cb_type != FCB) return 0x80000000;
+
+  if (flags & EVTFLAGS_MASK) return 0x80000000;
+
+  isr_flg_set(flg, (U16)flags);                 // Set flags, wakeup done by the kernel
+
+  return ((P_FCB)flg)->flags | flags;
+}
+
+
+// Event Flags Public API
+
+/// Create and Initialize an Event Flags object
+osEventFlagsId osEventFlagsCreate (osEventFlagsDef_t *evtflags_def) {
+  if (__get_IPSR() != 0) return NULL;           // Not allowed in ISR
+  return __svcEventFlagsCreate(evtflags_def);
+}
+
+/// Set the specified Event Flags
+int32_t osEventFlagsSet (osEventFlagsId evtflags_id, int32_t flags) {
+  if (__get_IPSR() != 0) {                      // in ISR
+    return   isrEventFlagsSet(evtflags_id, flags);
+  } else {                                      // in Thread
+    return __svcEventFlagsSet(evtflags_id, flags);
+  }
+}
+
+/// Clear the specified Event Flags
+int32_t osEventFlagsClear (osEventFlagsId evtflags_id, int32_t flags) {
+  if (__get_IPSR() != 0) return 0x80000000;     // Not allowed in ISR
+  return __svcEventFlagsClear(evtflags_id, flags);
+}
+
+/// Get the current Event Flags
+int32_t osEventFlagsGet (osEventFlagsId evtflags_id) {
+  OS_ID flg;
+
+  flg = rt_id2obj(evtflags_id);
+  if (flg == NULL) return 0x80000000;
+
+  if (((P_FCB)flg)->cb_type != FCB) return 0x80000000;
+
+  return ((P_FCB)flg)->flags;                   // Single halfword read
+}
+
+/// Wait for any (or all) of the specified Event Flags
+int32_t osEventFlagsWait (osEventFlagsId evtflags_id, int32_t flags, uint32_t options, uint32_t millisec) {
+  if (__get_IPSR() != 0) return 0x80000000;     // Not allowed in ISR
+  return __svcEventFlagsWait(evtflags_id, flags, options, millisec);
+}
+
+
+// ==== Pool and Message Queue Telemetry ====
+
+typedef struct {
+  void          *id;                            // Pool or Message Queue ID (NULL = free entry)
+  osObjectStats  stats;                         // Usage counters
+} sysObjectStats;
+
+/// Find the usage counters of a Pool or Message Queue (NULL if not tracked)
+static sysObjectStats *sysStatsFind (void *id) {
+  sysObjectStats *p = (sysObjectStats *)os_telemetry;
+  uint32_t        i;
+
+  for (i = 0; i < os_telemetry_cnt; i++, p++) {
+    if (p->id == id) return p;
+    if (p->id == NULL) break;
+  }
+  return NULL;
+}
+
+/// Start tracking a Pool or Message Queue with "capacity" blocks or messages
+static void sysStatsAdd (void *id, uint32_t capacity) {
+  sysObjectStats *p = (sysObjectStats *)os_telemetry;
+  uint32_t        i;
+
+  for (i = 0; i < os_telemetry_cnt; i++, p++) {
+    if ((p->id == id) || (p->id == NULL)) {
+      p->id             = id;                   // Re-created objects restart from 0
+      p->stats.capacity = capacity;
+      p->stats.count    = 0;
+      p->stats.peak     = 0;
+      p->stats.failures = 0;
+      p->stats.put_wait = 0;
+      p->stats.get_wait = 0;
+      return;
+    }
+  }
+}
+
+/// Update the usage counters: "delta" is added to the count, 0 counts a failure
+static void sysStatsUpdate (void *id, int32_t delta) {
+  sysObjectStats *p;
+  uint32_t        primask;
+
+  p = sysStatsFind(id);
+  if (p == NULL) return;
+
+  primask = __get_PRIMASK();                    // Pool calls may come from ISRs
+  __disable_irq();
+  if (delta == 0) {
+    p->stats.failures++;
+  } else {
+    p->stats.count += delta;
+    if (p->stats.count > p->stats.peak) {
+      p->stats.peak = p->stats.count;
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+/// Account a blocked put or get that has ended, called by the kernel on wake-up
+void sysMessageWaited (void *queue_id, U32 put, U32 ticks, U32 timeout) {
+  sysObjectStats *p;
+
+  p = sysStatsFind(queue_id);
+  if (p == NULL) return;
+
+  if (put) {
+    p->stats.put_wait += ticks;
+    if (timeout) {
+      sysStatsUpdate(queue_id, 0);              // The put really timed out
+    }
+  } else {
+    p->stats.get_wait += ticks;
+  }
+}
+
+/// Record the occupancy of a Message Queue after a put
+static void sysStatsPeak (void *id, uint32_t count) {
+  sysObjectStats *p;
+
+  p = sysStatsFind(id);
+  if ((p != NULL) && (count > p->stats.peak)) {
+    p->stats.peak = count;
+  }
+}
+
+/// Copy the usage counters of a Pool or Message Queue
+static osStatus sysStatsGet (void *id, osObjectStats *stats) {
+  sysObjectStats *p;
+  uint32_t        primask;
+
+  if ((id == NULL) || (stats == NULL)) return osErrorParameter;
+
+  p = sysStatsFind(id);
+  if (p == NULL) return osErrorResource;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  *stats = p->stats;
+  __set_PRIMASK(primask);
+
+  return osOK;
+}
+
+
 // ==== Memory Management Functions ====
 
 // Memory Management Helper Functions
@@ -1441,6 +1843,8 @@ osPoolId svcPoolCreate (osPoolDef_t *pool_def) {
 
   _init_box(pool_def->pool, sizeof(struct OS_BM) + pool_def->pool_sz * blk_sz, blk_sz);
 
+  sysStatsAdd(pool_def->pool, pool_def->pool_sz);
+
   return pool_def->pool;
 }
 
@@ -1454,6 +1858,7 @@ void *sysPoolAlloc (osPoolId pool_id, uint32_t clr) {
   if (clr) {
     rt_clr_box(pool_id, ptr);
   }
+  sysStatsUpdate(pool_id, (ptr != NULL) ? 1 : 0);
 
   return ptr;
 }
@@ -1467,6 +1872,8 @@ osStatus sysPoolFree (osPoolId pool_id, void *block) {
   res = rt_free_box(pool_id, block);
   if (res != 0) return osErrorValue;
 
+  sysStatsUpdate(pool_id, -1);
+
   return osOK;
 }
 
@@ -1506,6 +1913,11 @@ osStatus osPoolFree (osPoolId pool_id, void *block) {
   }
 }
 
+/// Get the usage counters of a memory pool
+osStatus osPoolGetStats (osPoolId pool_id, osObjectStats *stats) {
+  return sysStatsGet(pool_id, stats);
+}
+
 
 // ==== Message Queue Management Functions ====
 
@@ -1513,6 +1925,8 @@ osStatus osPoolFree (osPoolId pool_id, void *block) {
 SVC_2_1(svcMessageCreate,           osMessageQId, osMessageQDef_t *, osThreadId,           RET_pointer);
 SVC_3_1(svcMessagePut,              osStatus,     osMessageQId,      uint32_t,   uint32_t, RET_osStatus);
 SVC_2_3(svcMessageGet,    os_InRegs osEvent,      osMessageQId,      uint32_t,             RET_osEvent);
+SVC_4_1(svcMessagePutN,             int32_t,      osMessageQId,      uint32_t *, uint32_t, uint32_t, RET_int32_t);
+SVC_3_1(svcMessageGetN,             int32_t,      osMessageQId,      uint32_t *, uint32_t, RET_int32_t);
 
 // Message Queue Service Calls
 
@@ -1533,6 +1947,8 @@ osMessageQId svcMessageCreate (osMessageQDef_t *queue_def, osThreadId thread_id)
 
   rt_mbx_init(queue_def->pool, 4*(queue_def->queue_sz + 4));
 
+  sysStatsAdd(queue_def->pool, queue_def->queue_sz);
+
   return queue_def->pool;
 }
 
@@ -1547,8 +1963,12 @@ osStatus svcMessagePut (osMessageQId queue_id, uint32_t info, uint32_t millisec)
   res = rt_mbx_send(queue_id, (void *)info, rt_ms2tick(millisec));
 
   if (res == OS_R_TMO) {
+    if (millisec == 0) {
+      sysStatsUpdate(queue_id, 0);              // Blocked puts are counted on wake-up
+    }
     return (millisec ? osErrorTimeoutResource : osErrorResource);
   }
+  sysStatsPeak(queue_id, ((P_MCB)queue_id)->count);
 
   return osOK;
 }
@@ -1581,6 +2001,35 @@ os_InRegs osEvent_type svcMessageGet (osMessageQId queue_id, uint32_t millisec)
 }
 
 
+/// Put up to "count" Messages to a Queue without waiting
+int32_t svcMessagePutN (osMessageQId queue_id, uint32_t *info, uint32_t count, uint32_t millisec) {
+  uint32_t n;
+
+  if ((queue_id == NULL) || (info == NULL)) return 0;
+
+  if (((P_MCB)queue_id)->cb_type != MCB) return 0;
+
+  n = rt_mbx_send_n(queue_id, (void **)info, count);
+
+  if ((n < count) && (millisec == 0)) {
+    sysStatsUpdate(queue_id, 0);                // Otherwise the caller waits for room
+  }
+  sysStatsPeak(queue_id, ((P_MCB)queue_id)->count);
+
+  return (int32_t)n;
+}
+
+/// Get up to "count" queued Messages without waiting
+int32_t svcMessageGetN (osMessageQId queue_id, uint32_t *info, uint32_t count) {
+
+  if ((queue_id == NULL) || (info == NULL)) return 0;
+
+  if (((P_MCB)queue_id)->cb_type != MCB) return 0;
+
+  return (int32_t)rt_mbx_wait_n(queue_id, (void **)info, count);
+}
+
+
 // Message Queue ISR Calls
 
 /// Put a Message to a Queue
@@ -1593,10 +2042,12 @@ static __INLINE osStatus isrMessagePut (osMessageQId queue_id, uint32_t info, ui
   if (((P_MCB)queue_id)->cb_type != MCB) return osErrorParameter;
 
   if (rt_mbx_check(queue_id) == 0) {            // Check if Queue is full
+    sysStatsUpdate(queue_id, 0);
     return osErrorResource;
   }
 
   isr_mbx_send(queue_id, (void *)info);
+  sysStatsPeak(queue_id, ((P_MCB)queue_id)->count + 1);   // Queued when the kernel runs
 
   return osOK;
 }
@@ -1655,6 +2106,76 @@ os_InRegs osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec) {
   }
 }
 
+/// Put "count" Messages to a Queue, one kernel entry per batch that fits
+int32_t osMessagePutN (osMessageQId queue_id, const uint32_t *info, uint32_t count, uint32_t millisec) {
+  uint32_t done = 0;
+
+  if (__get_IPSR() != 0) {                      // in ISR
+    while ((done < count) && (isrMessagePut(queue_id, info[done], 0) == osOK)) {
+      done++;
+    }
+    return (int32_t)done;
+  }
+  while (done < count) {                        // in Thread
+    done += __svcMessagePutN(queue_id, (uint32_t *)info + done, count - done, millisec);
+    if ((done == count) || (millisec == 0)) break;
+    // Queue full: wait for room for one Message, then batch again
+    if (osMessagePut(queue_id, info[done], millisec) != osOK) break;
+    done++;
+  }
+  return (int32_t)done;
+}
+
+/// Get up to "count" Messages from a Queue, waiting only if it is empty
+int32_t osMessageGetN (osMessageQId queue_id, uint32_t *info, uint32_t count, uint32_t millisec) {
+  osEvent  evt;
+  uint32_t done = 0;
+
+  if (count == 0) return 0;
+
+  if (__get_IPSR() != 0) {                      // in ISR
+    while (done < count) {
+      evt = isrMessageGet(queue_id, 0);
+      if (evt.status != osEventMessage) break;
+      info[done++] = evt.value.v;
+    }
+    return (int32_t)done;
+  }
+  done = __svcMessageGetN(queue_id, info, count);   // in Thread
+  if ((done == 0) && (millisec != 0)) {
+    evt = osMessageGet(queue_id, millisec);
+    if (evt.status == osEventMessage) {
+      info[done++] = evt.value.v;
+      done += __svcMessageGetN(queue_id, info + done, count - done);
+    }
+  }
+  return (int32_t)done;
+}
+
+/// Get the number of Messages in a Queue, a single word read that needs no kernel entry
+uint32_t osMessageCount (osMessageQId queue_id) {
+
+  if (queue_id == NULL) return 0;
+
+  if (((P_MCB)queue_id)->cb_type != MCB) return 0;
+
+  return ((P_MCB)queue_id)->count;
+}
+
+/// Get the usage counters of a message queue
+osStatus osMessageGetStats (osMessageQId queue_id, osObjectStats *stats) {
+  osStatus status;
+
+  status = sysStatsGet(queue_id, stats);
+  if (status == osOK) {
+    stats->count = ((P_MCB)queue_id)->count;    // Queue keeps its own count
+    if (stats->count > stats->peak) {
+      stats->peak = stats->count;
+    }
+  }
+  return status;
+}
+
 
 // ==== Mail Queue Management Functions ====
 
@@ -0,0 +1,166 @@
+/*----------------------------------------------------------------------------
+ *      RL-ARM - RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_EVTFLAGS.C
+ *      Purpose: Event flag groups shared by several tasks
+ *      Rev.:    V4.20
+ *----------------------------------------------------------------------------
+ *
+ * Unlike task events (rt_Event.c), the flags of a group are not owned by a
+ * task: any number of tasks can wait for an AND or OR combination of them.
+ * Setting flags checks every waiting task in one pass, wakes all of them
+ * whose condition is met and clears the matched flags only afterwards, so
+ * one set can release several waiters on the same flag.
+ *---------------------------------------------------------------------------*/
+
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_System.h"
+#include "rt_EvtFlags.h"
+#include "rt_List.h"
+#include "rt_Task.h"
+#include "rt_HAL_CM.h"
+
+
+/*----------------------------------------------------------------------------
+ *      Local Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_flg_match ----------------------------------*/
+
+static U16 rt_flg_match (U16 flags, U16 wait_flags, U32 wait_all) {
+  /* Return the flags satisfying a wait, 0 if its condition is not met. */
+  if (wait_all) {
+    return (((flags & wait_flags) == wait_flags) ? wait_flags : 0);
+  }
+  return (flags & wait_flags);
+}
+
+
+/*--------------------------- rt_flg_wakeup ---------------------------------*/
+
+static U32 rt_flg_wakeup (P_FCB p_FCB) {
+  /* Make every task whose condition is met ready, return the number woken. */
+  P_TCB p_TCB, p_next;
+  U16   match;
+  U16   clear = 0;
+  U32   cnt   = 0;
+
+  for (p_TCB = p_FCB->p_lnk; p_TCB != NULL; p_TCB = p_next) {
+    p_next = p_TCB->p_lnk;
+    match  = rt_flg_match (p_FCB->flags, p_TCB->waits,
+                           (p_TCB->state == WAIT_FLG_AND));
+    if (match == 0) {
+      continue;
+    }
+    /* Unlink from the waiting list, the list is doubly linked. */
+    p_TCB->p_rlnk->p_lnk = p_TCB->p_lnk;
+    if (p_TCB->p_lnk != NULL) {
+      p_TCB->p_lnk->p_rlnk = p_TCB->p_rlnk;
+    }
+    p_TCB->p_lnk  = NULL;
+    p_TCB->p_rlnk = NULL;
+
+    /* "msg" holds the wait options while the task waits for flags. */
+    if (((U32)p_TCB->msg & FLG_NO_CLEAR) == 0) {
+      clear |= match;
+    }
+    rt_ret_val (p_TCB, match);
+    rt_rmv_dly (p_TCB);
+    p_TCB->state = READY;
+    rt_put_prio (&os_rdy, p_TCB);
+    cnt++;
+  }
+  p_FCB->flags &= ~clear;
+  return (cnt);
+}
+
+
+/*----------------------------------------------------------------------------
+ *      Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_flg_init -----------------------------------*/
+
+void rt_flg_init (OS_ID group, U16 flags) {
+  /* Initialize an event flag group. */
+  P_FCB p_FCB = group;
+
+  p_FCB->cb_type = FCB;
+  p_FCB->p_lnk   = NULL;
+  p_FCB->flags   = flags;
+}
+
+
+/*--------------------------- rt_flg_set ------------------------------------*/
+
+U16 rt_flg_set (OS_ID group, U16 flags) {
+  /* Set flags, wake all matching tasks, return the flags after the wakeup. */
+  P_FCB p_FCB = group;
+
+  p_FCB->flags |= flags;
+  if (rt_flg_wakeup (p_FCB) != 0) {
+    rt_dispatch_rdy ();
+  }
+  return (p_FCB->flags);
+}
+
+
+/*--------------------------- rt_flg_clr ------------------------------------*/
+
+U16 rt_flg_clr (OS_ID group, U16 flags) {
+  /* Clear flags, return the flags before clearing. */
+  P_FCB p_FCB = group;
+  U16   prev  = p_FCB->flags;
+
+  p_FCB->flags &= ~flags;
+  return (prev);
+}
+
+
+/*--------------------------- rt_flg_wait -----------------------------------*/
+
+U16 rt_flg_wait (OS_ID group, U16 flags, U32 options, U16 timeout) {
+  /* Wait for flags of a group. Return the matched flags, or 0 if the task  */
+  /* has to wait: rt_flg_set then returns the matched flags in its place.   */
+  P_FCB p_FCB = group;
+  U16   match;
+
+  match = rt_flg_match (p_FCB->flags, flags, options & FLG_WAIT_ALL);
+  if (match != 0) {
+    if ((options & FLG_NO_CLEAR) == 0) {
+      p_FCB->flags &= ~match;
+    }
+    return (match);
+  }
+  if (timeout == 0) {
+    return (0);
+  }
+  rt_put_prio ((P_XCB)p_FCB, os_tsk.run);
+  os_tsk.run->waits = flags;
+  os_tsk.run->msg   = (void **)options;
+  rt_block (timeout, (options & FLG_WAIT_ALL) ? WAIT_FLG_AND : WAIT_FLG_OR);
+  return (0);
+}
+
+
+/*--------------------------- isr_flg_set -----------------------------------*/
+
+void isr_flg_set (OS_ID group, U16 flags) {
+  /* Same function as "rt_flg_set", but to be called by ISRs. */
+  rt_psq_enq (group, flags);
+  rt_psh_req ();
+}
+
+
+/*--------------------------- rt_flg_psh ------------------------------------*/
+
+void rt_flg_psh (P_FCB p_CB, U16 flags) {
+  /* Set flags requested by an ISR, rt_pop_req does the task switch. */
+  p_CB->flags |= flags;
+  rt_flg_wakeup (p_CB);
+}
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
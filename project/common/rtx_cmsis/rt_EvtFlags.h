@@ -0,0 +1,23 @@
+/*----------------------------------------------------------------------------
+ *      RL-ARM - RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_EVTFLAGS.H
+ *      Purpose: Event flag groups shared by several tasks definitions
+ *      Rev.:    V4.20
+ *---------------------------------------------------------------------------*/
+
+/* Wait options */
+#define FLG_WAIT_ALL    0x01            /* AND-connected flags (OR if clear) */
+#define FLG_NO_CLEAR    0x02            /* Leave the flags set after a match */
+
+/* Functions */
+extern void      rt_flg_init  (OS_ID group, U16 flags);
+extern U16       rt_flg_set   (OS_ID group, U16 flags);
+extern U16       rt_flg_clr   (OS_ID group, U16 flags);
+extern U16       rt_flg_wait  (OS_ID group, U16 flags, U32 options, U16 timeout);
+extern void      isr_flg_set  (OS_ID group, U16 flags);
+extern void      rt_flg_psh   (P_FCB p_CB, U16 flags);
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
@@ -36,9 +36,22 @@
 #define INITIAL_xPSR    0x01000000
 #define DEMCR_TRCENA    0x01000000
 #define ITM_ITMENA      0x00000001
+#define DWT_CYCCNTENA   0x00000001
 #define MAGIC_WORD      0xE25A2EA5
 
-#if defined (__CC_ARM)          /* ARM Compiler */
+#if defined (BENCHMARK_HOST)    /* Host build of the list and round-robin code */
+
+#undef  __USE_EXCLUSIVE_ACCESS
+#define __TARGET_ARCH_6S_M 0
+#define __TARGET_FPU_VFP 0
+#define __inline inline
+#define __weak __attribute__((weak))
+
+static inline void __enable_irq(void) {}
+static inline U32 __disable_irq(void) { return 0; }
+static inline U8 __clz(U32 value) { return (value == 0)? 32: __builtin_clz(value); }
+
+#elif defined (__CC_ARM)        /* ARM Compiler */
 
 #if ((__TARGET_ARCH_7_M || __TARGET_ARCH_7E_M) && !NO_EXCLUSIVE_ACCESS)
  #define __USE_EXCLUSIVE_ACCESS
@@ -156,6 +169,10 @@ static inline U8 __clz(U32 value)
 /* Core Debug registers */
 #define DEMCR           (*((volatile U32 *)0xE000EDFC))
 
+/* DWT registers */
+#define DWT_CTRL        (*((volatile U32 *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile U32 *)0xE0001004))
+
 /* ITM registers */
 #define ITM_CONTROL     (*((volatile U32 *)0xE0000E80))
 #define ITM_ENABLE      (*((volatile U32 *)0xE0000E00))
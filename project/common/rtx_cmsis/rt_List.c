@@ -38,6 +38,7 @@
 #include "rt_List.h"
 #include "rt_Task.h"
 #include "rt_Time.h"
+#include "rt_Mailbox.h"
 #include "rt_HAL_CM.h"
 
 /*----------------------------------------------------------------------------
@@ -49,6 +50,106 @@ struct OS_XCB  os_rdy;
 /* List head of chained delay tasks */
 struct OS_XCB  os_dly;
 
+#ifdef __RDY_BITMAP
+/* Bitmap of priority levels with ready tasks */
+U32   os_rdy_map;
+/* Last ready task of every priority level */
+P_TCB os_rdy_tail[RDY_PRIO_MAX];
+#endif
+
+
+/*----------------------------------------------------------------------------
+ *      Local Functions
+ *---------------------------------------------------------------------------*/
+
+#ifdef __RDY_BITMAP
+
+/*--------------------------- rt_rdy_above ----------------------------------*/
+
+static __inline P_TCB rt_rdy_above (U32 prio) {
+  /* Return the last ready task with a priority higher than "prio", this is */
+  /* the list element after which the tasks of level "prio" are chained.    */
+  U32 map;
+
+  map = os_rdy_map & ~((2U << prio) - 1);
+  if (map == 0) {
+    return ((P_TCB)&os_rdy);
+  }
+#if (__TARGET_ARCH_6S_M)
+  for (prio++; (map & (1U << prio)) == 0; prio++);
+#else
+  /* Isolate the lowest set bit, CLZ gives its index. */
+  prio = 31 - __clz (map & (0 - map));
+#endif
+  return (os_rdy_tail[prio]);
+}
+
+
+/*--------------------------- rt_put_rdy ------------------------------------*/
+
+static void rt_put_rdy (P_TCB p_task) {
+  /* Append "p_task" to the tasks of its priority level in the ready list.  */
+  P_TCB p_prev;
+  U32 prio;
+
+  prio = p_task->prio;
+  if (os_rdy_map & (1U << prio)) {
+    p_prev = os_rdy_tail[prio];
+  }
+  else {
+    p_prev = rt_rdy_above (prio);
+    os_rdy_map |= (1U << prio);
+  }
+  p_task->p_lnk  = p_prev->p_lnk;
+  p_task->p_rlnk = NULL;
+  p_prev->p_lnk  = p_task;
+  p_task->rdy_prio   = prio;
+  os_rdy_tail[prio] = p_task;
+}
+
+
+/*--------------------------- rt_rmv_rdy_head -------------------------------*/
+
+static __inline void rt_rmv_rdy_head (P_TCB p_first) {
+  /* Update the level of task "p_first" just taken from the list head.      */
+  if (os_rdy_tail[p_first->rdy_prio] == p_first) {
+    os_rdy_map &= ~(1U << p_first->rdy_prio);
+  }
+}
+
+
+/*--------------------------- rt_rmv_rdy ------------------------------------*/
+
+static void rt_rmv_rdy (P_TCB p_task) {
+  /* Remove "p_task" from the ready list if enqueued. Only the tasks of the */
+  /* same priority level are searched.                                      */
+  P_TCB p_b,p_start;
+  U32 prio;
+
+  prio = p_task->rdy_prio;
+  if ((os_rdy_map & (1U << prio)) == 0) {
+    return;
+  }
+  p_start = rt_rdy_above (prio);
+  for (p_b = p_start; p_b != os_rdy_tail[prio]; p_b = p_b->p_lnk) {
+    if (p_b->p_lnk == p_task) {
+      p_b->p_lnk = p_task->p_lnk;
+      if (os_rdy_tail[prio] == p_task) {
+        if (p_b == p_start) {
+          /* Level is empty now. */
+          os_rdy_map &= ~(1U << prio);
+        }
+        else {
+          os_rdy_tail[prio] = p_b;
+        }
+      }
+      return;
+    }
+  }
+}
+
+#endif
+
 
 /*----------------------------------------------------------------------------
  *      Functions
@@ -65,7 +166,14 @@ void rt_put_prio (P_XCB p_CB, P_TCB p_task) {
   U32 prio;
   BOOL sem_mbx = __FALSE;
 
-  if (p_CB->cb_type == SCB || p_CB->cb_type == MCB || p_CB->cb_type == MUCB) {
+#ifdef __RDY_BITMAP
+  if (p_CB == &os_rdy) {
+    rt_put_rdy (p_task);
+    return;
+  }
+#endif
+  if (p_CB->cb_type == SCB || p_CB->cb_type == MCB || p_CB->cb_type == MUCB ||
+      p_CB->cb_type == FCB) {
     sem_mbx = __TRUE;
   }
   prio = p_task->prio;
@@ -99,7 +207,8 @@ P_TCB rt_get_first (P_XCB p_CB) {
 
   p_first = p_CB->p_lnk;
   p_CB->p_lnk = p_first->p_lnk;
-  if (p_CB->cb_type == SCB || p_CB->cb_type == MCB || p_CB->cb_type == MUCB) {
+  if (p_CB->cb_type == SCB || p_CB->cb_type == MCB || p_CB->cb_type == MUCB ||
+      p_CB->cb_type == FCB) {
     if (p_first->p_lnk != NULL) {
       p_first->p_lnk->p_rlnk = (P_TCB)p_CB;
       p_first->p_lnk = NULL;
@@ -107,6 +216,11 @@ P_TCB rt_get_first (P_XCB p_CB) {
     p_first->p_rlnk = NULL;
   }
   else {
+#ifdef __RDY_BITMAP
+    if (p_CB == &os_rdy) {
+      rt_rmv_rdy_head (p_first);
+    }
+#endif
     p_first->p_lnk = NULL;
   }
   return (p_first);
@@ -121,6 +235,13 @@ void rt_put_rdy_first (P_TCB p_task) {
   p_task->p_lnk = os_rdy.p_lnk;
   p_task->p_rlnk = NULL;
   os_rdy.p_lnk = p_task;
+#ifdef __RDY_BITMAP
+  p_task->rdy_prio = p_task->prio;
+  if ((os_rdy_map & (1U << p_task->prio)) == 0) {
+    os_rdy_map |= (1U << p_task->prio);
+    os_rdy_tail[p_task->prio] = p_task;
+  }
+#endif
 }
 
 
@@ -134,6 +255,9 @@ P_TCB rt_get_same_rdy_prio (void) {
   p_first = os_rdy.p_lnk;
   if (p_first->prio == os_tsk.run->prio) {
     os_rdy.p_lnk = os_rdy.p_lnk->p_lnk;
+#ifdef __RDY_BITMAP
+    rt_rmv_rdy_head (p_first);
+#endif
     return (p_first);
   }
   return (NULL);
@@ -227,6 +351,7 @@ void rt_dec_dly (void) {
       }
       p_rdy->p_rlnk = NULL;
     }
+    rt_mbx_woken (p_rdy, 1);
     rt_put_prio (&os_rdy, p_rdy);
     os_dly.delta_time = p_rdy->delta_time;
     if (p_rdy->state == WAIT_ITV) {
@@ -249,7 +374,9 @@ void rt_dec_dly (void) {
 void rt_rmv_list (P_TCB p_task) {
   /* Remove task identified with "p_task" from ready, semaphore or mailbox  */
   /* waiting list if enqueued.                                              */
+#ifndef __RDY_BITMAP
   P_TCB p_b;
+#endif
 
   if (p_task->p_rlnk != NULL) {
     /* A task is enqueued in semaphore / mailbox waiting list. */
@@ -260,6 +387,9 @@ void rt_rmv_list (P_TCB p_task) {
     return;
   }
 
+#ifdef __RDY_BITMAP
+  rt_rmv_rdy (p_task);
+#else
   p_b = (P_TCB)&os_rdy;
   while (p_b != NULL) {
     /* Search the ready list for task "p_task" */
@@ -269,6 +399,7 @@ void rt_rmv_list (P_TCB p_task) {
     }
     p_b = p_b->p_lnk;
   }
+#endif
 }
 
 
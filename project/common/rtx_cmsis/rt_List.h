@@ -40,10 +40,24 @@
 #define SCB             2
 #define MUCB            3
 #define HCB             4
+#define FCB             5
+
+/* OS_RDYBITMAP (RTX_Conf_CM.c, in the project defines so that the kernel  */
+/* sources see it too) or __RDY_BITMAP keeps one FIFO tail per priority     */
+/* level and a bitmap of non-empty levels, so that tasks enter the ready    */
+/* list in constant time. Priorities must then be below 32.                 */
+#if defined(OS_RDYBITMAP) && (OS_RDYBITMAP != 0) && !defined(__RDY_BITMAP)
+#define __RDY_BITMAP
+#endif
+#define RDY_PRIO_MAX    32
 
 /* Variables */
 extern struct OS_XCB os_rdy;
 extern struct OS_XCB os_dly;
+#ifdef __RDY_BITMAP
+extern U32   os_rdy_map;
+extern P_TCB os_rdy_tail[RDY_PRIO_MAX];
+#endif
 
 /* Functions */
 extern void  rt_put_prio      (P_XCB p_CB, P_TCB p_task);
@@ -39,6 +39,7 @@
 #include "rt_Mailbox.h"
 #include "rt_MemBox.h"
 #include "rt_Task.h"
+#include "rt_Time.h"
 #include "rt_HAL_CM.h"
 
 
@@ -47,6 +48,31 @@
  *---------------------------------------------------------------------------*/
 
 
+/*--------------------------- rt_mbx_blocked --------------------------------*/
+
+static void rt_mbx_blocked (P_MCB p_MCB, U32 put) {
+  /* The running task blocks on a mailbox: start timing the wait. */
+  os_tsk.run->wait_mbx  = p_MCB;
+  os_tsk.run->wait_time = os_time;
+  os_tsk.run->wait_put  = (U8)put;
+}
+
+
+/*--------------------------- rt_mbx_woken ----------------------------------*/
+
+void rt_mbx_woken (P_TCB p_TCB, U32 timeout) {
+  /* A task blocked on a mailbox got its message, its free entry or timed  */
+  /* out: report the wait. Memory allocation waits are not timed.          */
+  if (p_TCB->wait_mbx != NULL) {
+#ifdef __CMSIS_RTOS
+    sysMessageWaited (p_TCB->wait_mbx, p_TCB->wait_put,
+                      (U16)(os_time - p_TCB->wait_time), timeout);
+#endif
+    p_TCB->wait_mbx = NULL;
+  }
+}
+
+
 /*--------------------------- rt_mbx_init -----------------------------------*/
 
 void rt_mbx_init (OS_ID mailbox, U16 mbx_size) {
@@ -84,6 +110,7 @@ OS_RESULT rt_mbx_send (OS_ID mailbox, void *p_msg, U16 timeout) {
     *p_TCB->msg = p_msg;
     rt_ret_val (p_TCB, OS_R_MBX);
 #endif
+    rt_mbx_woken (p_TCB, 0);
     rt_rmv_dly (p_TCB);
     rt_dispatch (p_TCB);
   }
@@ -107,6 +134,7 @@ OS_RESULT rt_mbx_send (OS_ID mailbox, void *p_msg, U16 timeout) {
         p_MCB->state = 2;
       }
       os_tsk.run->msg = p_msg;
+      rt_mbx_blocked (p_MCB, 1);
       rt_block (timeout, WAIT_MBX);
       return (OS_R_TMO);
     }
@@ -150,6 +178,7 @@ OS_RESULT rt_mbx_wait (OS_ID mailbox, void **message, U16 timeout) {
       if (++p_MCB->first == p_MCB->size) {
         p_MCB->first = 0;
       }
+      rt_mbx_woken (p_TCB, 0);
       rt_rmv_dly (p_TCB);
       rt_dispatch (p_TCB);
     }
@@ -172,6 +201,7 @@ OS_RESULT rt_mbx_wait (OS_ID mailbox, void **message, U16 timeout) {
     /* Task is waiting to receive a message */      
     p_MCB->state = 1;
   }
+  rt_mbx_blocked (p_MCB, 0);
   rt_block(timeout, WAIT_MBX);
 #ifndef __CMSIS_RTOS
   os_tsk.run->msg = message;
@@ -180,6 +210,94 @@ OS_RESULT rt_mbx_wait (OS_ID mailbox, void **message, U16 timeout) {
 }
 
 
+/*--------------------------- rt_mbx_ready ----------------------------------*/
+
+static void rt_mbx_ready (P_TCB p_TCB) {
+  /* Make a woken task ready without switching, see rt_dispatch_rdy. */
+  rt_mbx_woken (p_TCB, 0);
+  rt_rmv_dly (p_TCB);
+  p_TCB->state = READY;
+  rt_put_prio (&os_rdy, p_TCB);
+}
+
+
+/*--------------------------- rt_mbx_send_n ---------------------------------*/
+
+U32 rt_mbx_send_n (OS_ID mailbox, void **p_msg, U32 cnt) {
+  /* Send up to 'cnt' messages without waiting, return the number sent. */
+  P_MCB p_MCB = mailbox;
+  P_TCB p_TCB;
+  U32   i = 0;
+
+  /* Hand messages directly to the tasks waiting for one. */
+  while ((i < cnt) && (p_MCB->state == 1)) {
+    p_TCB = rt_get_first ((P_XCB)p_MCB);
+    if (p_MCB->p_lnk == NULL) {
+      p_MCB->state = 0;
+    }
+#ifdef __CMSIS_RTOS
+    rt_ret_val2(p_TCB, 0x10/*osEventMessage*/, (U32)p_msg[i]);
+#else
+    *p_TCB->msg = p_msg[i];
+    rt_ret_val (p_TCB, OS_R_MBX);
+#endif
+    rt_mbx_ready (p_TCB);
+    i++;
+  }
+  /* Store the rest in the mailbox queue while there is room. */
+  while ((i < cnt) && (p_MCB->count < p_MCB->size)) {
+    p_MCB->msg[p_MCB->first] = p_msg[i];
+    rt_inc (&p_MCB->count);
+    if (++p_MCB->first == p_MCB->size) {
+      p_MCB->first = 0;
+    }
+    i++;
+  }
+  rt_dispatch_rdy ();
+  return (i);
+}
+
+
+/*--------------------------- rt_mbx_wait_n ---------------------------------*/
+
+U32 rt_mbx_wait_n (OS_ID mailbox, void **message, U32 cnt) {
+  /* Receive up to 'cnt' queued messages without waiting, return the number */
+  /* received. Tasks waiting to send refill the freed entries.             */
+  P_MCB p_MCB = mailbox;
+  P_TCB p_TCB;
+  U32   i = 0;
+
+  while ((i < cnt) && (p_MCB->count != 0)) {
+    message[i++] = p_MCB->msg[p_MCB->last];
+    if (++p_MCB->last == p_MCB->size) {
+      p_MCB->last = 0;
+    }
+    if (p_MCB->state == 2) {
+      /* A task is waiting to send message */
+      p_TCB = rt_get_first ((P_XCB)p_MCB);
+      if (p_MCB->p_lnk == NULL) {
+        p_MCB->state = 0;
+      }
+#ifdef __CMSIS_RTOS
+      rt_ret_val(p_TCB, 0/*osOK*/);
+#else
+      rt_ret_val(p_TCB, OS_R_OK);
+#endif
+      p_MCB->msg[p_MCB->first] = p_TCB->msg;
+      if (++p_MCB->first == p_MCB->size) {
+        p_MCB->first = 0;
+      }
+      rt_mbx_ready (p_TCB);
+    }
+    else {
+      rt_dec (&p_MCB->count);
+    }
+  }
+  rt_dispatch_rdy ();
+  return (i);
+}
+
+
 /*--------------------------- rt_mbx_check ----------------------------------*/
 
 OS_RESULT rt_mbx_check (OS_ID mailbox) {
@@ -267,6 +385,7 @@ void rt_mbx_psh (P_MCB p_CB, void *p_msg) {
         p_CB->first = 0;
       }
       p_TCB->state = READY;
+      rt_mbx_woken (p_TCB, 0);
       rt_rmv_dly (p_TCB);
       rt_put_prio (&os_rdy, p_TCB);
       break;
@@ -283,6 +402,7 @@ void rt_mbx_psh (P_MCB p_CB, void *p_msg) {
       rt_ret_val (p_TCB, OS_R_MBX);
 #endif
       p_TCB->state = READY;
+      rt_mbx_woken (p_TCB, 0);
       rt_rmv_dly (p_TCB);
       rt_put_prio (&os_rdy, p_TCB);
       break;
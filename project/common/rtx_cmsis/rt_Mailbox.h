@@ -36,10 +36,18 @@
 extern void      rt_mbx_init  (OS_ID mailbox, U16 mbx_size);
 extern OS_RESULT rt_mbx_send  (OS_ID mailbox, void *p_msg,    U16 timeout);
 extern OS_RESULT rt_mbx_wait  (OS_ID mailbox, void **message, U16 timeout);
+extern U32       rt_mbx_send_n (OS_ID mailbox, void **p_msg,   U32 cnt);
+extern U32       rt_mbx_wait_n (OS_ID mailbox, void **message, U32 cnt);
 extern OS_RESULT rt_mbx_check (OS_ID mailbox);
 extern void      isr_mbx_send (OS_ID mailbox, void *p_msg);
 extern OS_RESULT isr_mbx_receive (OS_ID mailbox, void **message);
 extern void      rt_mbx_psh   (P_MCB p_CB,    void *p_msg);
+extern void      rt_mbx_woken (P_TCB p_TCB,   U32 timeout);
+
+#ifdef __CMSIS_RTOS
+/* Message Queue telemetry (rt_CMSIS.c): a blocked put or get has ended */
+extern void      sysMessageWaited (void *queue_id, U32 put, U32 ticks, U32 timeout);
+#endif
 
 
 /*----------------------------------------------------------------------------
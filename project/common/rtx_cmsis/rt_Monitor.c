@@ -0,0 +1,127 @@
+/*----------------------------------------------------------------------------
+ *      RL-ARM - RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_MONITOR.C
+ *      Purpose: Thread run time and stack usage monitor
+ *      Rev.:    V4.20
+ *----------------------------------------------------------------------------
+ *
+ * Run time is accumulated in CPU cycles (DWT cycle counter) every time the
+ * scheduler requests a task switch. Stack usage is measured by painting the
+ * unused part of each task stack when the task is created and searching for
+ * the lowest overwritten word. Enabled with OS_MONITOR in RTX_Conf_CM.c, the
+ * weak functions are replaced by empty ones in RTX_CM_lib.h otherwise.
+ *---------------------------------------------------------------------------*/
+
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_Task.h"
+#include "rt_Time.h"
+#include "rt_Monitor.h"
+#include "rt_HAL_CM.h"
+
+/*----------------------------------------------------------------------------
+ *      Global Variables
+ *---------------------------------------------------------------------------*/
+
+/* Cycle counter value at the last task switch request. */
+U32 os_mon_last;
+
+/* Index of the run time counter: idle demon uses entry 0. */
+#define rt_mon_idx(p_TCB) (((p_TCB)->task_id == 255) ? 0 : (p_TCB)->task_id)
+
+#if (__TARGET_ARCH_6S_M)
+ /* No cycle counter on ARMv6-M, count in timer ticks instead. */
+ #define rt_mon_now()     ((U32)os_time)
+#else
+ #define rt_mon_now()     DWT_CYCCNT
+#endif
+
+
+/*----------------------------------------------------------------------------
+ *      Global Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_mon_init -----------------------------------*/
+
+__weak void rt_mon_init (void) {
+  /* Start the cycle counter used for run time accounting. */
+#if !(__TARGET_ARCH_6S_M)
+  DEMCR      |= DEMCR_TRCENA;
+  DWT_CYCCNT  = 0;
+  DWT_CTRL   |= DWT_CYCCNTENA;
+#endif
+  os_mon_last = rt_mon_now();
+}
+
+
+/*--------------------------- rt_mon_task_init ------------------------------*/
+
+__weak void rt_mon_task_init (P_TCB p_TCB) {
+  /* Clear run time and paint the unused stack of a newly created task. */
+  U32 *stk;
+
+  os_mon_cycles[rt_mon_idx(p_TCB)] = 0;
+
+  /* Paint from above the magic word up to the initial stack frame. */
+  for (stk = &p_TCB->stack[1]; stk < (U32 *)p_TCB->tsk_stack; stk++) {
+    *stk = MON_STACK_PAINT;
+  }
+}
+
+
+/*--------------------------- rt_mon_switch ---------------------------------*/
+
+__weak void rt_mon_switch (P_TCB p_new) {
+  /* Charge the cycles since the last switch to the running task. */
+  U32 now;
+
+  now = rt_mon_now();
+  if (os_tsk.run != NULL) {
+    os_mon_cycles[rt_mon_idx(os_tsk.run)] += now - os_mon_last;
+  }
+  os_mon_last = now;
+}
+
+
+/*--------------------------- rt_mon_cycles ---------------------------------*/
+
+U32 rt_mon_cycles (P_TCB p_TCB) {
+  /* Return the accumulated run time of a task. The counter wraps, so the */
+  /* caller should work with differences between two readings.           */
+  return (os_mon_cycles[rt_mon_idx(p_TCB)]);
+}
+
+
+/*--------------------------- rt_mon_stack_size -----------------------------*/
+
+U32 rt_mon_stack_size (P_TCB p_TCB) {
+  /* Return the stack size of a task in bytes. */
+  U32 size;
+
+  size = p_TCB->priv_stack;
+  if (size == 0) {
+    size = (U16)os_stackinfo;
+  }
+  return (size);
+}
+
+
+/*--------------------------- rt_mon_stack_used -----------------------------*/
+
+U32 rt_mon_stack_used (P_TCB p_TCB) {
+  /* Return the stack high-water mark of a task in bytes. */
+  U32 *stk,*top;
+
+  top = &p_TCB->stack[rt_mon_stack_size (p_TCB) >> 2];
+  for (stk = &p_TCB->stack[1]; stk < top; stk++) {
+    if (*stk != MON_STACK_PAINT) {
+      break;
+    }
+  }
+  return ((U32)top - (U32)stk);
+}
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
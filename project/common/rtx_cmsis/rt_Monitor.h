@@ -0,0 +1,25 @@
+/*----------------------------------------------------------------------------
+ *      RL-ARM - RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_MONITOR.H
+ *      Purpose: Thread run time and stack usage monitor definitions
+ *      Rev.:    V4.20
+ *---------------------------------------------------------------------------*/
+
+/* Definitions */
+#define MON_STACK_PAINT 0xCDCDCDCD
+
+/* Variables */
+extern U32 os_mon_last;
+
+/* Functions */
+extern void rt_mon_init       (void);
+extern void rt_mon_task_init  (P_TCB p_TCB);
+extern void rt_mon_switch     (P_TCB p_new);
+extern U32  rt_mon_cycles     (P_TCB p_TCB);
+extern U32  rt_mon_stack_size (P_TCB p_TCB);
+extern U32  rt_mon_stack_used (P_TCB p_TCB);
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
@@ -63,18 +63,29 @@ __weak void rt_init_robin (void) {
 
 __weak void rt_chk_robin (void) {
   /* Check if Round Robin timeout expired and switch to the next ready task.*/
+  /* A task created with its own quantum runs that many ticks instead of   */
+  /* the global timeout.                                                    */
   P_TCB p_new;
+  U16   tout;
 
   if (os_robin.task != os_rdy.p_lnk) {
     /* New task was suspended, reset Round Robin timeout. */
     os_robin.task = os_rdy.p_lnk;
-    os_robin.time = os_time + os_robin.tout - 1;
+    tout = os_robin.task->quantum;
+    if (tout == 0) {
+      tout = os_robin.tout;
+    }
+    os_robin.time = os_time + tout - 1;
   }
   if (os_robin.time == os_time) {
     /* Round Robin timeout has expired, swap Robin tasks. */
     os_robin.task = NULL;
     p_new = rt_get_first (&os_rdy);
     rt_put_prio ((P_XCB)&os_rdy, p_new);
+    if (os_rdy.p_lnk != p_new) {
+      /* Another task of the same priority runs next. */
+      p_new->slices++;
+    }
   }
 }
 
@@ -37,6 +37,7 @@
 #include "rt_Task.h"
 #include "rt_System.h"
 #include "rt_Event.h"
+#include "rt_EvtFlags.h"
 #include "rt_List.h"
 #include "rt_Mailbox.h"
 #include "rt_Semaphore.h"
@@ -124,6 +125,10 @@ void rt_pop_req (void) {
       /* Is of MCB type */
       rt_mbx_psh ((P_MCB)p_CB, (void *)os_psq->q[idx].arg);
     }
+    else if (p_CB->cb_type == FCB) {
+      /* Is of FCB type */
+      rt_flg_psh ((P_FCB)p_CB, (U16)os_psq->q[idx].arg);
+    }
     else {
       /* Must be of SCB type */
       rt_sem_psh ((P_SCB)p_CB);
@@ -168,6 +173,74 @@ void rt_systick (void) {
   rt_switch_req (next);
 }
 
+/*--------------------------- rt_suspend ------------------------------------*/
+
+#ifdef __CMSIS_RTOS
+extern U32  sysUserTimerWakeupTime (void);
+extern void sysUserTimerUpdate (U32 sleep_time);
+#endif
+
+U32 rt_suspend (void) {
+  /* Suspend the scheduler for tickless idle. Return the number of ticks    */
+  /* until the next delay or user timer expires, 0xFFFF if none is pending. */
+  U32 delta = 0xFFFF;
+#ifdef __CMSIS_RTOS
+  U32 tmr;
+#endif
+
+  rt_tsk_lock ();
+
+  if (os_dly.p_dlnk != NULL) {
+    delta = os_dly.delta_time;
+  }
+#ifdef __CMSIS_RTOS
+  tmr = sysUserTimerWakeupTime ();
+  if (tmr < delta) {
+    delta = tmr;
+  }
+#endif
+  return (delta);
+}
+
+
+/*--------------------------- rt_resume -------------------------------------*/
+
+void rt_resume (U32 sleep_time) {
+  /* Account "sleep_time" elapsed ticks and resume the scheduler. */
+  P_TCB next;
+  U32 delta = sleep_time;
+
+  os_tsk.run->state = READY;
+  rt_put_rdy_first (os_tsk.run);
+
+  /* Restart the Round Robin timeout. */
+  os_robin.task = NULL;
+
+  /* Update delays: jump from one expiring delay to the next one. */
+  while ((os_dly.p_dlnk != NULL) && (delta >= os_dly.delta_time)) {
+    delta      -= os_dly.delta_time;
+    os_time    += os_dly.delta_time;
+    os_dly.delta_time = 1;
+    rt_dec_dly ();
+  }
+  if (os_dly.p_dlnk != NULL) {
+    os_dly.delta_time -= delta;
+  }
+  os_time += delta;
+
+  /* Check the user timers. */
+#ifdef __CMSIS_RTOS
+  sysUserTimerUpdate (sleep_time);
+#endif
+
+  /* Switch back to highest ready task */
+  next = rt_get_first (&os_rdy);
+  rt_switch_req (next);
+
+  rt_tsk_unlock ();
+}
+
+
 /*--------------------------- rt_stk_check ----------------------------------*/
 
 __weak void rt_stk_check (void) {
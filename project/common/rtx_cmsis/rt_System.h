@@ -41,6 +41,8 @@ extern void rt_tsk_unlock (void);
 extern void rt_psh_req    (void);
 extern void rt_pop_req    (void);
 extern void rt_systick    (void);
+extern U32  rt_suspend    (void);
+extern void rt_resume     (U32 sleep_time);
 extern void rt_stk_check  (void);
 
 /*----------------------------------------------------------------------------
@@ -39,6 +39,7 @@
 #include "rt_List.h"
 #include "rt_MemBox.h"
 #include "rt_Robin.h"
+#include "rt_Monitor.h"
 #include "rt_HAL_CM.h"
 
 /*----------------------------------------------------------------------------
@@ -84,6 +85,12 @@ static void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
   p_TCB->events  = 0;
   p_TCB->waits   = 0;
   p_TCB->stack_frame = 0;
+  p_TCB->quantum  = 0;
+  p_TCB->preempts = 0;
+  p_TCB->slices   = 0;
+  p_TCB->period   = 0;
+  p_TCB->misses   = 0;
+  p_TCB->wait_mbx = NULL;
 
   if (p_TCB->priv_stack == 0) {
     /* Allocate the memory space for the stack. */
@@ -96,7 +103,15 @@ static void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
 /*--------------------------- rt_switch_req ---------------------------------*/
 
 void rt_switch_req (P_TCB p_new) {
-  /* Switch to next task (identified by "p_new"). */
+  /* Switch to next task (identified by "p_new"). A task still ready when */
+  /* it is switched out was preempted (a dispatch, an ISR or a delay woke */
+  /* a higher priority task, or its time slice ran out); rt_tsk_pass only */
+  /* makes the yielding task ready after the request.                     */
+  if ((os_tsk.run != NULL) && (os_tsk.run != p_new) &&
+      (os_tsk.run->state == READY)) {
+    os_tsk.run->preempts++;
+  }
+  rt_mon_switch (p_new);
   os_tsk.new   = p_new;
   p_new->state = RUNNING;
   DBG_TASK_SWITCH(p_new->task_id);
@@ -130,6 +145,29 @@ void rt_dispatch (P_TCB next_TCB) {
 }
 
 
+/*--------------------------- rt_dispatch_rdy -------------------------------*/
+
+void rt_dispatch_rdy (void) {
+  /* Tasks were made ready without a switch (several may have been woken in */
+  /* one pass): preempt the running task once if one has a higher priority. */
+  /* The preempted task goes first in the ready list unless another woken   */
+  /* task still ranks above it, then it queues by priority.                 */
+  P_TCB next_TCB;
+
+  if ((os_rdy.p_lnk != NULL) && (os_rdy.p_lnk->prio > os_tsk.run->prio)) {
+    next_TCB = rt_get_first (&os_rdy);
+    if ((os_rdy.p_lnk != NULL) && (os_rdy.p_lnk->prio > os_tsk.run->prio)) {
+      rt_put_prio (&os_rdy, os_tsk.run);
+    }
+    else {
+      rt_put_rdy_first (os_tsk.run);
+    }
+    os_tsk.run->state = READY;
+    rt_switch_req (next_TCB);
+  }
+}
+
+
 /*--------------------------- rt_block --------------------------------------*/
 
 void rt_block (U16 timeout, U8 block_state) {
@@ -158,8 +196,9 @@ void rt_tsk_pass (void) {
   p_new = rt_get_same_rdy_prio();
   if (p_new != NULL) {
     rt_put_prio ((P_XCB)&os_rdy, os_tsk.run);
-    os_tsk.run->state = READY;
+    /* A yield is not a preemption: not READY yet for rt_switch_req */
     rt_switch_req (p_new);
+    os_tsk.run->state = READY;
   }
 }
 
@@ -239,6 +278,7 @@ OS_TID rt_tsk_create (FUNCP task, U32 prio_stksz, void *stk, void *argv) {
   i = rt_get_TID ();
   os_active_TCB[i-1] = task_context;
   task_context->task_id = i;
+  rt_mon_task_init (task_context);
   DBG_TASK_NOTIFY(task_context, __TRUE);
   rt_dispatch (task_context);
   return ((OS_TID)i);
@@ -302,10 +342,14 @@ void rt_sys_init (FUNCP first_task, U32 prio_stksz, void *stk) {
   os_idle_TCB.task_id    = 255;
   os_idle_TCB.priv_stack = 0;
   rt_init_context (&os_idle_TCB, 0, os_idle_demon);
+  rt_mon_task_init (&os_idle_TCB);
 
   /* Set up ready list: initially empty */
   os_rdy.cb_type = HCB;
   os_rdy.p_lnk   = NULL;
+#ifdef __RDY_BITMAP
+  os_rdy_map     = 0;
+#endif
   /* Set up delay list: initially empty */
   os_dly.cb_type = HCB;
   os_dly.p_dlnk  = NULL;
@@ -326,6 +370,7 @@ void rt_sys_init (FUNCP first_task, U32 prio_stksz, void *stk) {
   /* Intitialize system clock timer */
   rt_tmr_init ();
   rt_init_robin ();
+  rt_mon_init ();
 
   /* Start up first user task before entering the endless loop */
   rt_tsk_create (first_task, prio_stksz, stk, NULL);
@@ -45,6 +45,8 @@
 #define WAIT_SEM        7
 #define WAIT_MBX        8
 #define WAIT_MUT        9
+#define WAIT_FLG_OR     10
+#define WAIT_FLG_AND    11
 
 /* Return codes */
 #define OS_R_TMO        0x01
@@ -63,6 +65,7 @@ extern struct OS_TCB os_idle_TCB;
 /* Functions */
 extern void      rt_switch_req (P_TCB p_new);
 extern void      rt_dispatch   (P_TCB next_TCB);
+extern void      rt_dispatch_rdy (void);
 extern void      rt_block      (U16 timeout, U8 block_state);
 extern void      rt_tsk_pass   (void);
 extern OS_TID    rt_tsk_self   (void);
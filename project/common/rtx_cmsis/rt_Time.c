@@ -35,6 +35,7 @@
 #include "rt_TypeDef.h"
 #include "RTX_Config.h"
 #include "rt_Task.h"
+#include "rt_List.h"
 #include "rt_Time.h"
 
 /*----------------------------------------------------------------------------
@@ -80,6 +81,98 @@ void rt_itv_wait (void) {
   }
 }
 
+
+/*--------------------------- rt_prd_set ------------------------------------*/
+
+void rt_prd_set (P_TCB p_TCB, U16 period, U16 deadline) {
+  /* Make a task periodic, or aperiodic again with "period" 0. The current  */
+  /* job counts as released now. "deadline" 0 means the end of the period. */
+  p_TCB->period   = period;
+  p_TCB->deadline = (deadline == 0) ? period : deadline;
+  p_TCB->release  = os_time;
+  p_TCB->misses   = 0;
+}
+
+
+/*--------------------------- rt_prd_wait -----------------------------------*/
+
+U32 rt_prd_wait (void) {
+  /* End the job of the running periodic task and wait for the release of  */
+  /* the next one. A job that ends after its deadline is a miss, and so is */
+  /* every release that passed while the task overran: those jobs are      */
+  /* skipped rather than run back to back. Return the misses of this call. */
+  P_TCB p_TCB = os_tsk.run;
+  U16   delta;
+  U32   missed = 0;
+
+  if ((U16)(os_time - p_TCB->release) > p_TCB->deadline) {
+    missed++;
+  }
+  p_TCB->release += p_TCB->period;
+
+  delta = os_time - p_TCB->release;
+  if ((delta & 0x8000) == 0) {
+    /* Next release has passed already: skip whole periods, run late. */
+    missed         += delta / p_TCB->period;
+    p_TCB->release += (delta / p_TCB->period) * p_TCB->period;
+  }
+  p_TCB->misses += missed;
+
+  delta = p_TCB->release - os_time;
+  if ((delta != 0) && ((delta & 0x8000) == 0)) {
+    rt_block (delta, WAIT_ITV);
+  }
+  return (missed);
+}
+
+
+/*--------------------------- rt_prd_rm -------------------------------------*/
+
+void rt_prd_rm (U8 base_prio, U8 max_prio) {
+  /* Assign rate monotonic priorities to all periodic tasks: the longest    */
+  /* period gets "base_prio", each shorter period one level more, up to    */
+  /* "max_prio". Tasks with equal periods share a priority level.           */
+  P_TCB p_TCB, p_j, p_k;
+  U32   i, j, k, prio;
+
+  for (i = 0; i < os_maxtaskrun; i++) {
+    p_TCB = os_active_TCB[i];
+    if ((p_TCB == NULL) || (p_TCB->period == 0)) {
+      continue;
+    }
+    /* One level above every distinct longer period. */
+    prio = base_prio;
+    for (j = 0; j < os_maxtaskrun; j++) {
+      p_j = os_active_TCB[j];
+      if ((p_j == NULL) || (p_j->period <= p_TCB->period)) {
+        continue;
+      }
+      for (k = 0; k < j; k++) {
+        p_k = os_active_TCB[k];
+        if ((p_k != NULL) && (p_k->period == p_j->period)) {
+          break;
+        }
+      }
+      if (k == j) {
+        prio++;
+      }
+    }
+    if (prio > max_prio) {
+      prio = max_prio;
+    }
+    p_TCB->prio = prio;
+    if (p_TCB != os_tsk.run) {
+      rt_resort_prio (p_TCB);
+    }
+  }
+  /* Preempt the running task once if it is no longer the highest. */
+  if (rt_rdy_prio() > os_tsk.run->prio) {
+    rt_put_prio (&os_rdy, os_tsk.run);
+    os_tsk.run->state = READY;
+    rt_switch_req (rt_get_first (&os_rdy));
+  }
+}
+
 /*----------------------------------------------------------------------------
  * end of file
  *---------------------------------------------------------------------------*/
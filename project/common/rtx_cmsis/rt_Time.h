@@ -39,6 +39,9 @@ extern U16 os_time;
 extern void rt_dly_wait (U16 delay_time);
 extern void rt_itv_set  (U16 interval_time);
 extern void rt_itv_wait (void);
+extern void rt_prd_set  (P_TCB p_TCB, U16 period, U16 deadline);
+extern U32  rt_prd_wait (void);
+extern void rt_prd_rm   (U8 base_prio, U8 max_prio);
 
 /*----------------------------------------------------------------------------
  * end of file
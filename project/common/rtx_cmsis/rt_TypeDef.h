@@ -67,13 +67,29 @@ typedef struct OS_TCB {
 
   /* Hardware dependant part: specific for CM processor                      */
   U8     stack_frame;             /* Stack frame: 0=Basic, 1=Extended        */
-  U8     reserved;
+  U8     rdy_prio;                /* Priority level queued in ready list     */
   U16    priv_stack;              /* Private stack size, 0= system assigned  */
   U32    tsk_stack;               /* Current task Stack pointer (R13)        */
   U32    *stack;                  /* Pointer to Task Stack memory block      */
 
   /* Task entry point used for uVision debugger                              */
   FUNCP  ptask;                   /* Task entry address                      */
+
+  /* Round Robin part                                                        */
+  U16    quantum;                 /* Time slice in ticks, 0= os_robin.tout   */
+  U16    period;                  /* Job release period in ticks, 0= none    */
+  U32    preempts;                /* Switched out while still ready          */
+  U32    slices;                  /* Round Robin time slices used up         */
+
+  /* Periodic task part                                                      */
+  U16    deadline;                /* Relative deadline of a job in ticks     */
+  U16    release;                 /* Release time of the current job         */
+  U32    misses;                  /* Deadline misses incl. skipped releases  */
+
+  /* Message Queue telemetry part                                            */
+  void   *wait_mbx;               /* Mailbox blocked on, NULL= none          */
+  U16    wait_time;               /* Time the mailbox wait started           */
+  U8     wait_put;                /* 1= blocked sending, 0= receiving        */
 } *P_TCB;
 #define TCB_STACKF      32        /* 'stack_frame' offset                    */
 #define TCB_TSTACK      36        /* 'tsk_stack' offset                      */
@@ -130,6 +146,13 @@ typedef struct OS_SCB {
   struct OS_TCB *p_lnk;           /* Chain of tasks waiting for tokens       */
 } *P_SCB;
 
+typedef struct OS_FCB {
+  U8     cb_type;                 /* Control Block Type                      */
+  U8     reserved;                /* Unused, same layout as OS_SCB           */
+  U16    flags;                   /* Event flags of the group                */
+  struct OS_TCB *p_lnk;           /* Chain of tasks waiting for flags        */
+} *P_FCB;
+
 typedef struct OS_MUCB {
   U8     cb_type;                 /* Control Block Type                      */
   U8     prio;                    /* Owner task default priority             */
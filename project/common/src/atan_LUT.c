@@ -1,5 +1,5 @@
 
-#include "stm32f4xx_conf.h"
+#include <stdint.h>
 #include "atan_LUT.h"
 
 /* Angles go up to 45 degrees since atan(x) = 90 - atan(1/x) x e (0,45) */
@@ -23,7 +23,7 @@ static const float atan_lookup[101] =
  * @return: arctan(X)
  */
 float atan_table(float x) {
-	u16 temp;
+	uint16_t temp;
 	float val;
 	if (x < 0) {							// if negative
 		val = -(x*100);						// scale by 100, take absolute value
@@ -31,11 +31,11 @@ float atan_table(float x) {
 			if (val > 10000) {			 	// if too big prevent overflow
 				val = 100;				 	// set a barrier
 			}
-			temp = (u16) (val);		 		// cast into u16 type
+			temp = (uint16_t) (val);		 		// cast into uint16_t type
 			temp = 10000/temp;			 	// 1/x
 			val = atan_lookup[temp]-90;	 	// -(90 - arctan(1/x))
 		} else {
-			temp = (u16) (val);		 		// cast into u16 type
+			temp = (uint16_t) (val);		 		// cast into uint16_t type
 			val = -atan_lookup[temp];
 		}
 	} else {								// if positive
@@ -44,11 +44,11 @@ float atan_table(float x) {
 			if (val > 10000) {			 	// if too big prevent overflow
 				val = 100;				 	// set a barrier
 			}
-			temp = (u16) (val);				// cast into u16 type
+			temp = (uint16_t) (val);				// cast into uint16_t type
 			temp = 10000/temp;			 	// 1/x
 			val = 90-atan_lookup[temp];  	// 90 - arctan(1/x)
 		} else {
-			temp = (u16) (val);				// cast into u16 type
+			temp = (uint16_t) (val);				// cast into uint16_t type
 			val = atan_lookup[temp];
 		}
 	}
@@ -0,0 +1,294 @@
+#include "benchmark.h"
+
+#ifdef BENCHMARK_HOST
+//The kernel headers define NULL unguarded, the C library ones redefine it quietly
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_List.h"
+#include "rt_Task.h"
+#endif
+
+#include <stdio.h>
+
+#include "atan_LUT.h"
+#include "filter.h"
+
+#ifdef BENCHMARK_HOST
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#else
+#include "stm32f4xx.h"
+#include "cmsis_os.h"
+
+/* Not described by this version of core_cm4.h */
+#define DWT_CTRL	(*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT	(*((volatile uint32_t *)0xE0001004))
+#define DWT_CTRL_CYCCNTENA	0x00000001
+#endif
+
+void benchmark_counter_init()
+{
+#ifndef BENCHMARK_HOST
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;	// enable the DWT unit
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+uint32_t benchmark_counter_read()
+{
+#ifndef BENCHMARK_HOST
+	return DWT_CYCCNT;
+#elif defined(__i386__) || defined(__x86_64__)
+	return (uint32_t)__rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);	// ns instead of cycles
+#endif
+}
+
+void benchmark_init(Benchmark_report *r, const char *target)
+{
+	uint32_t i, start, end;
+	uint32_t overhead = 0xFFFFFFFF;
+
+	r->target = target;
+	r->numResults = 0;
+	r->overhead = 0;
+
+	benchmark_counter_init();
+
+	//Cheapest empty region is the cost of reading the counter itself
+	for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+	{
+		start = benchmark_counter_read();
+		end = benchmark_counter_read();
+		if (end - start < overhead)
+		{
+			overhead = end - start;
+		}
+	}
+	r->overhead = overhead;
+}
+
+Benchmark_result *benchmark_begin(Benchmark_report *r, const char *name)
+{
+	Benchmark_result *b;
+
+	if (r->numResults >= BENCHMARK_MAX_RESULTS)
+	{
+		return 0;
+	}
+
+	b = &r->results[r->numResults++];
+	b->name = name;
+	b->iterations = 0;
+	b->total = 0;
+	b->min = 0xFFFFFFFF;
+	b->max = 0;
+	return b;
+}
+
+void benchmark_sample(Benchmark_report *r, Benchmark_result *b, uint32_t start, uint32_t end)
+{
+	//unsigned subtraction handles a single counter wrap
+	uint32_t cycles = end - start;
+
+	cycles = (cycles > r->overhead)? cycles - r->overhead: 0;
+
+	b->iterations++;
+	b->total += cycles;
+	if (cycles < b->min)
+	{
+		b->min = cycles;
+	}
+	if (cycles > b->max)
+	{
+		b->max = cycles;
+	}
+}
+
+void benchmark_print_json(Benchmark_report *r)
+{
+	int i;
+	Benchmark_result *b;
+
+	printf("{\"target\":\"%s\",\"overhead\":%u,\"results\":[", r->target, (unsigned)r->overhead);
+	for (i = 0; i < r->numResults; i++)
+	{
+		b = &r->results[i];
+		printf("%s{\"name\":\"%s\",\"iterations\":%u,\"mean\":%u,\"min\":%u,\"max\":%u}",
+			(i == 0)? "": ",",
+			b->name,
+			(unsigned)b->iterations,
+			(unsigned)((b->iterations != 0)? b->total / b->iterations: 0),
+			(unsigned)((b->iterations != 0)? b->min: 0),
+			(unsigned)b->max);
+	}
+	printf("]}\n");
+}
+
+void benchmark_run_common(Benchmark_report *r)
+{
+	static Queue queue;
+	static Filter filter;
+	volatile float angle;
+	int element = 0;
+	int sample = 0;
+	float x = -12.0f;
+
+	BENCHMARK_RUN(r, "atan_table", x = (x > 12.0f)? -12.0f: x + 0.023f, angle = atan_table(x));
+
+	initialize_queue(&queue, BUFFER_SIZE);
+	BENCHMARK_RUN(r, "enqueue", element++, enqueue(&queue, &element));
+	BENCHMARK_RUN(r, "dequeue", if (is_empty(&queue)) enqueue(&queue, &element), dequeue(&queue, &element));
+
+	//Same depth as the angle filters
+	initialize_queue(&queue, BUFFER_SIZE);
+	init_filter(&filter, &queue, BUFFER_SIZE);
+	BENCHMARK_RUN(r, "add_measurement", sample = (sample + 7) % 180, add_measurement(&filter, sample - 90));
+
+	(void)angle;
+}
+
+#ifndef BENCHMARK_HOST
+//Filler threads stay ready but never run while the benchmark holds the CPU
+static void benchmark_filler_thread(void const *arg)
+{
+	while(1)
+	{
+		osThreadYield();
+	}
+}
+
+osThreadDef(benchmark_filler_thread, osPriorityBelowNormal, 1, 0);
+
+void benchmark_run_scheduler(Benchmark_report *r, int maxThreads)
+{
+	static char names[8][32];
+	osThreadId fillers[32];
+	osThreadId target;
+	osThreadId self = osThreadGetId();
+	osPriority selfPriority = osThreadGetPriority(self);
+	osPriority targetPriority = osPriorityLow;
+	int numFillers = 0;
+	int n = 1;
+	int i = 0;
+	
+	osThreadSetPriority(self, osPriorityHigh);
+	
+	//The timed thread is queued behind all the fillers
+	target = osThreadCreate(osThread(benchmark_filler_thread), NULL);
+	if (target == NULL)
+	{
+		osThreadSetPriority(self, selfPriority);
+		return;
+	}
+	osThreadSetPriority(target, targetPriority);
+	
+	while (n <= maxThreads && n <= 32 && i < 8)
+	{
+		while (numFillers < n)
+		{
+			fillers[numFillers] = osThreadCreate(osThread(benchmark_filler_thread), NULL);
+			if (fillers[numFillers] == NULL)
+			{
+				break;
+			}
+			numFillers++;
+		}
+		if (numFillers < n)
+		{
+			break;
+		}
+		
+		sprintf(names[i], "ready_resort_%d", n);
+		BENCHMARK_RUN(r, names[i],
+			targetPriority = (targetPriority == osPriorityLow)? osPriorityIdle: osPriorityLow,
+			osThreadSetPriority(target, targetPriority));
+		i++;
+		n *= 2;
+	}
+	
+	for (i = 0; i < numFillers; i++)
+	{
+		osThreadTerminate(fillers[i]);
+	}
+	osThreadTerminate(target);
+	osThreadSetPriority(self, selfPriority);
+}
+#else
+//The kernel ready list (rt_List.c) on its own: TCBs take the kernel priorities of the target benchmark
+//threads, fillers at osPriorityBelowNormal (3) and the timed one toggling between Low (2) and Idle (1)
+struct OS_TSK os_tsk;
+U16 os_time;
+U32 os_fifo[4];
+
+void os_error(U32 err_code)
+{
+}
+
+//rt_dec_dly reports the end of mailbox waits, nothing here waits on one
+void rt_mbx_woken(P_TCB p_TCB, U32 timeout)
+{
+}
+
+void benchmark_run_scheduler(Benchmark_report *r, int maxThreads)
+{
+	static char names[16][32];
+	static struct OS_TCB tasks[33];
+	P_TCB target = &tasks[32];
+	int numFillers = 0;
+	int n = 1;
+	int i = 0;
+	
+	os_rdy.cb_type = HCB;
+	os_rdy.p_lnk = NULL;
+	target->cb_type = TCB;
+	target->state = READY;
+	target->prio = 2;
+	rt_put_prio(&os_rdy, target);
+	
+	while (n <= maxThreads && n <= 32 && i < 16)
+	{
+		while (numFillers < n)
+		{
+			tasks[numFillers].cb_type = TCB;
+			tasks[numFillers].state = READY;
+			tasks[numFillers].prio = 3;
+			rt_put_prio(&os_rdy, &tasks[numFillers]);
+			numFillers++;
+		}
+		
+		sprintf(names[i], "ready_resort_%d", n);
+		BENCHMARK_RUN(r, names[i],
+			target->prio = (target->prio == 2)? 1: 2,
+			rt_resort_prio(target));
+		i++;
+		
+		//A round-robin switch (rt_dispatch): the head of the list runs, the preempted filler goes
+		//behind the others of its level
+		sprintf(names[i], "dispatch_%d", n);
+		BENCHMARK_RUN(r, names[i], (void)0, rt_put_prio(&os_rdy, rt_get_first(&os_rdy)));
+		i++;
+		n *= 2;
+	}
+}
+#endif
+
+#ifdef BENCHMARK_HOST
+int main(void)
+{
+	static Benchmark_report report;
+
+	benchmark_init(&report, "host");
+	benchmark_run_common(&report);
+	benchmark_run_scheduler(&report, 32);
+	benchmark_print_json(&report);
+	return 0;
+}
+#endif
@@ -0,0 +1,126 @@
+/*!
+ @file benchmark.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a small cycle-accurate micro-benchmark harness. On target it uses the DWT cycle counter,
+ on a host build (BENCHMARK_HOST defined) it uses rdtsc or clock_gettime. Results are printed as JSON.
+
+ Define BENCHMARK in a board project to run its suite on target before the threads start.
+ Host build of the common suite and of the kernel ready list; add -DOS_RDYBITMAP=1 for the constant time list:
+ gcc -std=gnu99 -O2 -DBENCHMARK_HOST -I../rtx_cmsis benchmark.c atan_LUT.c filter.c circular_queue.c
+ ../rtx_cmsis/rt_List.c -o benchmark
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include <stdint.h>
+
+#define BENCHMARK_MAX_RESULTS 16	/*!< Maximum number of results in one report */
+#define BENCHMARK_ITERATIONS 1000	/*!< Default number of timed calls per benchmark */
+
+/**
+* A structure to hold the timing of one benchmarked function
+*/
+typedef struct {
+	const char *name;	/*!< The name of the benchmarked function */
+	uint32_t iterations;	/*!< The number of timed calls */
+	uint64_t total;	/*!< The sum of all call times in cycles */
+	uint32_t min;	/*!< The fastest call in cycles */
+	uint32_t max;	/*!< The slowest call in cycles */
+} Benchmark_result;
+
+/**
+* A structure to hold all the results of one benchmark run
+*/
+typedef struct {
+	const char *target;	/*!< The name of the board or host the suite ran on */
+	uint32_t overhead;	/*!< The cost of an empty timed region, subtracted from every sample */
+	int numResults;	/*!< The number of valid entries in results */
+	Benchmark_result results[BENCHMARK_MAX_RESULTS];	/*!< The results */
+} Benchmark_report;
+
+/*!
+ Start the cycle counter. Must be called once before any benchmark is run.
+ */
+void benchmark_counter_init(void);
+
+/*!
+ Read the current value of the cycle counter.
+ */
+uint32_t benchmark_counter_read(void);
+
+/*!
+ Initialize a report and measure the timing overhead.
+ @param[in,out] r A pointer to the report struct
+ @param[in] target The name of the board or host
+ */
+void benchmark_init(Benchmark_report *r, const char *target);
+
+/*!
+ Start a new result in the report. Returns NULL if the report is full.
+ @param[in,out] r A pointer to the report struct
+ @param[in] name The name of the benchmarked function
+ */
+Benchmark_result *benchmark_begin(Benchmark_report *r, const char *name);
+
+/*!
+ Add one timed call to a result.
+ @param[in] r A pointer to the report struct
+ @param[in,out] b A pointer to the result struct
+ @param[in] start The counter value before the call
+ @param[in] end The counter value after the call
+ */
+void benchmark_sample(Benchmark_report *r, Benchmark_result *b, uint32_t start, uint32_t end);
+
+/*!
+ Print a report as a single JSON object through printf (ITM on target).
+ @param[in] r A pointer to the report struct
+ */
+void benchmark_print_json(Benchmark_report *r);
+
+/*!
+ Run the benchmarks for the hardware independent common code (atan_table, add_measurement, enqueue and dequeue).
+ @param[in,out] r A pointer to the report struct
+ */
+void benchmark_run_common(Benchmark_report *r);
+
+/*!
+ Run the scheduler benchmark. Times a ready list re-sort (osThreadSetPriority of a ready thread) with a growing
+ number of ready threads, up to maxThreads or until OS_TASKCNT is reached. Compare a kernel built with and
+ without __RDY_BITMAP. Must be called from the highest priority thread. The host build times rt_List.c
+ directly, and also a round-robin dispatch (the head taken, the preempted thread queued again).
+ @param[in,out] r A pointer to the report struct
+ @param[in] maxThreads The maximum number of ready threads
+ */
+void benchmark_run_scheduler(Benchmark_report *r, int maxThreads);
+
+/*!
+ Time a statement BENCHMARK_ITERATIONS times, one sample per call.
+ @param[in] report A pointer to the report struct
+ @param[in] name The name of the benchmark
+ @param[in] setup A statement run before every call, not timed
+ @param[in] call The statement to time
+ */
+#define BENCHMARK_RUN(report, name, setup, call)	\
+do {	\
+	Benchmark_result *b_ = benchmark_begin((report), (name));	\
+	uint32_t i_, start_, end_;	\
+	for (i_ = 0; b_ != 0 && i_ < BENCHMARK_ITERATIONS; i_++) {	\
+		setup;	\
+		start_ = benchmark_counter_read();	\
+		call;	\
+		end_ = benchmark_counter_read();	\
+		benchmark_sample((report), b_, start_, end_);	\
+	}	\
+} while (0)
+
+#endif
+
+//! @}
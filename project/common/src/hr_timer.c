@@ -0,0 +1,209 @@
+#include "hr_timer.h"
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_tim.h"
+
+//Min-heap of running timers, heap[0] expires first
+static HR_timer *heap[HR_TIMER_MAX];
+static int heapSize = 0;
+
+//Wrap-safe comparison of two counter values
+#define HR_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+
+static void heap_swap(int i, int j)
+{
+	HR_timer *t = heap[i];
+
+	heap[i] = heap[j];
+	heap[j] = t;
+	heap[i]->index = i;
+	heap[j]->index = j;
+}
+
+static void heap_up(int i)
+{
+	while (i > 0 && HR_BEFORE(heap[i]->deadline, heap[(i - 1) / 2]->deadline))
+	{
+		heap_swap(i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+
+static void heap_down(int i)
+{
+	int smallest, child;
+
+	while (1)
+	{
+		smallest = i;
+		child = 2 * i + 1;
+		if (child < heapSize && HR_BEFORE(heap[child]->deadline, heap[smallest]->deadline))
+		{
+			smallest = child;
+		}
+		child++;
+		if (child < heapSize && HR_BEFORE(heap[child]->deadline, heap[smallest]->deadline))
+		{
+			smallest = child;
+		}
+		if (smallest == i)
+		{
+			return;
+		}
+		heap_swap(i, smallest);
+		i = smallest;
+	}
+}
+
+static void heap_remove(HR_timer *t)
+{
+	int i = t->index;
+
+	heapSize--;
+	if (i != heapSize)
+	{
+		heap[i] = heap[heapSize];
+		heap[i]->index = i;
+		heap_up(i);
+		heap_down(heap[i]->index);
+	}
+	t->index = -1;
+}
+
+//Program the compare channel for the earliest deadline. Interrupts must be disabled.
+static void reprogram()
+{
+	if (heapSize == 0)
+	{
+		TIM_ITConfig(TIM5, TIM_IT_CC1, DISABLE);
+		return;
+	}
+	TIM_SetCompare1(TIM5, heap[0]->deadline);
+	TIM_ClearITPendingBit(TIM5, TIM_IT_CC1);
+	TIM_ITConfig(TIM5, TIM_IT_CC1, ENABLE);
+
+	//Deadline passed while programming: let the interrupt handle it right away
+	if (!HR_BEFORE(TIM_GetCounter(TIM5), heap[0]->deadline))
+	{
+		NVIC_SetPendingIRQ(TIM5_IRQn);
+	}
+}
+
+void hr_timer_init()
+{
+	RCC_ClocksTypeDef clock_data;
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStruct;
+	NVIC_InitTypeDef NVIC_InitStruct;
+
+	RCC_GetClocksFreq(&clock_data);
+
+	// Enable clock to TIM5
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM5, ENABLE);
+
+	// 1 MHz counter clock, APB1 timers run at twice PCLK1 (see baseboard_tim2_interrupt_config)
+	TIM_TimeBaseInitStruct.TIM_Period         = 0xFFFFFFFF;
+	TIM_TimeBaseInitStruct.TIM_Prescaler      = (uint16_t)((2*clock_data.PCLK1_Frequency)/1000000) - 1;
+	TIM_TimeBaseInitStruct.TIM_ClockDivision  = 0;
+	TIM_TimeBaseInitStruct.TIM_CounterMode    = TIM_CounterMode_Up;
+	TIM_TimeBaseInit(TIM5, &TIM_TimeBaseInitStruct);
+
+	// Compare channel 1 only raises the interrupt, no output pin
+	TIM_SetCompare1(TIM5, 0);
+	TIM_OC1PreloadConfig(TIM5, TIM_OCPreload_Disable);
+
+	NVIC_InitStruct.NVIC_IRQChannel = TIM5_IRQn;
+	NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = HR_TIMER_PRIORITY;
+	NVIC_InitStruct.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStruct);
+
+	heapSize = 0;
+	TIM_Cmd(TIM5, ENABLE);
+}
+
+uint32_t hr_timer_now()
+{
+	return TIM_GetCounter(TIM5);
+}
+
+void hr_timer_create(HR_timer *t, hr_timer_callback callback, void *arg)
+{
+	t->deadline = 0;
+	t->period = 0;
+	t->callback = callback;
+	t->arg = arg;
+	t->index = -1;
+}
+
+int hr_timer_start(HR_timer *t, uint32_t delay, uint32_t period)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if (t->index >= 0)
+	{
+		heap_remove(t);
+	}
+	if (heapSize >= HR_TIMER_MAX)
+	{
+		__set_PRIMASK(primask);
+		return -1;
+	}
+
+	t->deadline = hr_timer_now() + delay;
+	t->period = period;
+	t->index = heapSize;
+	heap[heapSize++] = t;
+	heap_up(t->index);
+
+	if (heap[0] == t)
+	{
+		reprogram();
+	}
+	__set_PRIMASK(primask);
+	return 0;
+}
+
+void hr_timer_stop(HR_timer *t)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (t->index >= 0)
+	{
+		heap_remove(t);
+		reprogram();
+	}
+	__set_PRIMASK(primask);
+}
+
+// Timer 5 interrupt: run every expired timer, then arm the next deadline
+void TIM5_IRQHandler()
+{
+	HR_timer *t;
+
+	TIM_ClearITPendingBit(TIM5, TIM_IT_CC1);
+
+	__disable_irq();
+	while (heapSize > 0 && !HR_BEFORE(hr_timer_now(), heap[0]->deadline))
+	{
+		t = heap[0];
+		heap_remove(t);
+		if (t->period != 0)
+		{
+			//Reload from the deadline, not from now, so periodic timers do not drift
+			t->deadline += t->period;
+			t->index = heapSize;
+			heap[heapSize++] = t;
+			heap_up(t->index);
+		}
+
+		//Callbacks may start or stop timers, including this one
+		__enable_irq();
+		t->callback(t->arg);
+		__disable_irq();
+	}
+	reprogram();
+	__enable_irq();
+}
@@ -0,0 +1,77 @@
+/*!
+ @file hr_timer.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a microsecond resolution one-shot and periodic software timer service. All timers share
+ TIM5, a 32-bit counter free-running at 1 MHz, whose compare channel 1 is always programmed to the earliest
+ deadline. Pending timers are kept in a binary min-heap. Callbacks run in the TIM5 interrupt, so they must be
+ short and may only call ISR-safe functions (e.g. osSignalSet, osMessagePut with a 0 timeout).
+ Deadlines must be less than 2^31 us (about 35 minutes) in the future.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _HR_TIMER_H
+#define _HR_TIMER_H
+
+#include <stdint.h>
+
+#define HR_TIMER_MAX 16	/*!< Maximum number of simultaneously running timers */
+#define HR_TIMER_PRIORITY 4	/*!< TIM5 pre-emption priority, above the keypad scan interrupts (5) so a TDMA slot starts on time during a scan */
+
+/*!
+ Timer callback, called from the TIM5 interrupt.
+ */
+typedef void (*hr_timer_callback)(void *arg);
+
+/**
+* A structure to represent one timer. Owned by the caller, must stay valid while the timer runs.
+*/
+typedef struct {
+	uint32_t deadline;	/**< the counter value at which the timer expires */
+	uint32_t period;	/**< the reload period in us, 0 for a one-shot timer */
+	hr_timer_callback callback;	/**< the function called on expiry */
+	void *arg;	/**< the argument passed to the callback */
+	int index;	/**< the position in the heap, -1 when stopped */
+} HR_timer;
+
+/*!
+ Initialize TIM5 and the timer service. Must be called once before any timer is started.
+ */
+void hr_timer_init(void);
+
+/*!
+ Read the current time in us. Wraps every 2^32 us.
+ */
+uint32_t hr_timer_now(void);
+
+/*!
+ Initialize a timer. The timer is stopped.
+ @param[out] t A pointer to the timer struct
+ @param[in] callback The function called on expiry
+ @param[in] arg The argument passed to the callback
+ */
+void hr_timer_create(HR_timer *t, hr_timer_callback callback, void *arg);
+
+/*!
+ Start or restart a timer. Safe to call from an interrupt or from a timer callback.
+ Returns 0 on success, -1 if HR_TIMER_MAX timers are already running.
+ @param[in,out] t A pointer to the timer struct
+ @param[in] delay The time until the first expiry in us
+ @param[in] period The reload period in us, 0 for a one-shot timer
+ */
+int hr_timer_start(HR_timer *t, uint32_t delay, uint32_t period);
+
+/*!
+ Stop a timer. Does nothing if the timer is not running. Safe to call from an interrupt or from a timer callback.
+ @param[in,out] t A pointer to the timer struct
+ */
+void hr_timer_stop(HR_timer *t);
+
+#endif
+
+//! @}
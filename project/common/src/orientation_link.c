@@ -0,0 +1,118 @@
+#include "orientation_link.h"
+
+#include <stdlib.h>
+
+void link_encoder_init(Link_encoder *e)
+{
+	e->rollAngle = 0;
+	e->pitchAngle = 0;
+	e->sequence = 0;
+	e->sinceFull = 0;
+	e->started = 0;
+}
+
+int link_encode(Link_encoder *e, int8_t rollAngle, int8_t pitchAngle, uint8_t *packet)
+{
+	int rollDelta = rollAngle - e->rollAngle;
+	int pitchDelta = pitchAngle - e->pitchAngle;
+	int length;
+
+	//Every sample counts towards the heartbeat, sent or not: a stream of deltas still gets a full
+	//message every LINK_HEARTBEAT samples, so the base board recovers from a lost one in motion too
+	e->sinceFull++;
+
+	//Hold: inside the dead-band and the heartbeat is not due
+	if (e->started && abs(rollDelta) < LINK_DEADBAND && abs(pitchDelta) < LINK_DEADBAND &&
+		e->sinceFull < LINK_HEARTBEAT)
+	{
+		return 0;
+	}
+
+	if (e->started && e->sinceFull < LINK_HEARTBEAT &&
+		abs(rollDelta) <= LINK_MAX_DELTA && abs(pitchDelta) <= LINK_MAX_DELTA)
+	{
+		packet[0] = e->sequence;
+		packet[1] = ((rollDelta + LINK_MAX_DELTA) << 4) | (pitchDelta + LINK_MAX_DELTA);
+		length = LINK_DELTA_SIZE;
+	}
+	else
+	{
+		//Same layout as a Wireless_message, the sequence in place of delta_t
+		packet[0] = (uint8_t)rollAngle;
+		packet[1] = (uint8_t)pitchAngle;
+		packet[2] = e->sequence;
+		packet[3] = 1;
+		length = LINK_FULL_SIZE;
+		e->sinceFull = 0;
+	}
+
+	e->rollAngle = rollAngle;
+	e->pitchAngle = pitchAngle;
+	e->sequence++;
+	e->started = 1;
+	return length;
+}
+
+void link_decoder_init(Link_decoder *d)
+{
+	d->rollAngle = 0;
+	d->pitchAngle = 0;
+	d->sequence = 0;
+	d->synced = 0;
+}
+
+int link_decode(Link_decoder *d, const uint8_t *packet, int length, int8_t *rollAngle, int8_t *pitchAngle)
+{
+	if (length == LINK_FULL_SIZE)
+	{
+		d->rollAngle = (int8_t)packet[0];
+		d->pitchAngle = (int8_t)packet[1];
+		d->sequence = packet[2];
+		d->synced = 1;
+	}
+	else if (length == LINK_DELTA_SIZE && d->synced && packet[0] == d->sequence)
+	{
+		d->rollAngle += (packet[1] >> 4) - LINK_MAX_DELTA;
+		d->pitchAngle += (packet[1] & 0x0F) - LINK_MAX_DELTA;
+	}
+	else
+	{
+		//A packet was lost: the state is unknown until the next full message
+		d->synced = 0;
+		return -1;
+	}
+
+	d->sequence++;
+	*rollAngle = d->rollAngle;
+	*pitchAngle = d->pitchAngle;
+	return 0;
+}
+
+int link_telemetry_encode(const Link_telemetry *t, uint8_t *packet)
+{
+	packet[0] = LINK_TELEMETRY;
+	packet[1] = (uint8_t)t->rollAngle;
+	packet[2] = (uint8_t)t->pitchAngle;
+	packet[3] = t->motorQueue;
+	packet[4] = t->interpolatorQueue;
+	packet[5] = t->motorDropped;
+	packet[6] = t->interpolatorDropped;
+	packet[7] = t->lost;
+	return LINK_TELEMETRY_SIZE;
+}
+
+int link_telemetry_decode(Link_telemetry *t, const uint8_t *packet, int length)
+{
+	if (length != LINK_TELEMETRY_SIZE || packet[0] != LINK_TELEMETRY)
+	{
+		return -1;
+	}
+	t->rollAngle = (int8_t)packet[1];
+	t->pitchAngle = (int8_t)packet[2];
+	t->motorQueue = packet[3];
+	t->interpolatorQueue = packet[4];
+	t->motorDropped = packet[5];
+	t->interpolatorDropped = packet[6];
+	t->lost = packet[7];
+	return 0;
+}
@@ -0,0 +1,134 @@
+/*!
+ @file orientation_link.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is the transmit policy and packet encoding of the realtime roll/pitch stream.
+ The remote board only transmits a sample when it moved at least LINK_DEADBAND degrees from the last
+ transmitted state. Small moves are sent as a 2 byte delta packet (sequence number, roll and pitch changes
+ in nibbles), anything else as a full 4 byte message carrying the absolute angles, and every LINK_HEARTBEAT
+ samples the state is sent in full whether it moved or not. The base board rebuilds exactly the transmitted
+ state: a missing sequence number makes it ignore deltas until the next full message, which is at most one
+ heartbeat away, in motion as at rest (host/link_sim.c).
+ Control packets, 3 bytes long, carry the radio profile switch, the keepalive of an idle remote board and
+ the request for a TDMA slot (tdma.h).
+ Telemetry flows back from the base board on request: the remote board sends LINK_REQUEST_TELEMETRY and
+ listens, the base board answers after LINK_TELEMETRY_DELAY frames with the angles it commanded, the depth of
+ its queues and its drop counters. With TDMA the beacon is the only downlink, so telemetry is not requested.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _ORIENTATION_LINK_H
+#define _ORIENTATION_LINK_H
+
+#include <stdint.h>
+
+#define LINK_DEADBAND 2	/*!< Smallest change sent, in degrees; the filtered angles jitter by 1 at rest */
+#define LINK_HEARTBEAT 50	/*!< Samples from one full message to the next at the latest (500 ms at 100 Hz) */
+#define LINK_MAX_DELTA 7	/*!< Largest change sent in a delta packet */
+
+#define LINK_FULL_SIZE 4	/*!< Bytes in a full message: roll, pitch, sequence, realtime flag (1) */
+#define LINK_DELTA_SIZE 2	/*!< Bytes in a delta packet: sequence, changes (roll + 7) << 4 | (pitch + 7) */
+#define LINK_CONTROL_SIZE 3	/*!< Bytes in a control packet: LINK_CONTROL, command, argument */
+#define LINK_TELEMETRY_SIZE 8	/*!< Bytes in a telemetry packet: LINK_TELEMETRY, then Link_telemetry */
+
+#define LINK_CONTROL 0xC5	/*!< First byte of a control packet */
+#define LINK_KEEPALIVE 0	/*!< Control command: the remote board is idle but present */
+#define LINK_IDLE 1	/*!< Keepalive argument: nothing follows, a base board on wake-on-radio sleeps again at once */
+#define LINK_SET_PROFILE 1	/*!< Control command: the remote board switches to the radio profile in the argument */
+#define LINK_JOIN 2	/*!< Control command: the remote board asks for a TDMA slot, sent in the join slot */
+#define LINK_REQUEST_TELEMETRY 3	/*!< Control command: the remote board listens for a telemetry packet */
+
+#define LINK_TELEMETRY 0x7E	/*!< First byte of a telemetry packet */
+#define LINK_TELEMETRY_DELAY 2	/*!< Frames the base board waits before answering, while the remote board turns to RX */
+#define LINK_BEHIND 8	/*!< Messages waiting in a base board queue from which the remote board thins its realtime stream */
+
+/**
+* A structure to represent the transmit side
+*/
+typedef struct {
+	int8_t rollAngle;	/**< the last transmitted roll */
+	int8_t pitchAngle;	/**< the last transmitted pitch */
+	uint8_t sequence;	/**< the sequence number of the next packet */
+	uint8_t sinceFull;	/**< the number of samples since the last full message */
+	uint8_t started;	/**< whether anything was transmitted yet */
+} Link_encoder;
+
+/**
+* A structure to represent the receive side
+*/
+typedef struct {
+	int8_t rollAngle;	/**< the rebuilt roll */
+	int8_t pitchAngle;	/**< the rebuilt pitch */
+	uint8_t sequence;	/**< the sequence number expected next */
+	uint8_t synced;	/**< whether deltas can be applied, cleared by a lost packet */
+} Link_decoder;
+
+/**
+* A structure to represent the state of the base board sent back as telemetry
+*/
+typedef struct {
+	int8_t rollAngle;	/**< the roll angle last commanded to the servo */
+	int8_t pitchAngle;	/**< the pitch angle last commanded to the servo */
+	uint8_t motorQueue;	/**< the messages waiting in motor_message_box */
+	uint8_t interpolatorQueue;	/**< the messages waiting in interpolator_message_box */
+	uint8_t motorDropped;	/**< the motor steps dropped for want of message memory, wraps */
+	uint8_t interpolatorDropped;	/**< the received messages dropped for want of message memory, wraps */
+	uint8_t lost;	/**< the packets that failed their CRC or could not be decoded, wraps */
+} Link_telemetry;
+
+/*!
+ Start a stream: the first sample is sent in full.
+ @param[out] e A pointer to the encoder struct
+ */
+void link_encoder_init(Link_encoder *e);
+
+/*!
+ Apply the transmit policy to a sample. Returns the packet length, 0 if nothing has to be sent,
+ LINK_DELTA_SIZE or LINK_FULL_SIZE.
+ @param[in,out] e A pointer to the encoder struct
+ @param[in] rollAngle The roll angle in degrees
+ @param[in] pitchAngle The pitch angle in degrees
+ @param[out] packet Receives the packet, LINK_FULL_SIZE bytes
+ */
+int link_encode(Link_encoder *e, int8_t rollAngle, int8_t pitchAngle, uint8_t *packet);
+
+/*!
+ Wait for a full message before applying deltas.
+ @param[out] d A pointer to the decoder struct
+ */
+void link_decoder_init(Link_decoder *d);
+
+/*!
+ Rebuild the state from a received realtime packet. Returns 0 if the state was updated, -1 if the
+ packet was dropped (malformed, or a delta after a lost packet).
+ @param[in,out] d A pointer to the decoder struct
+ @param[in] packet The packet
+ @param[in] length The packet length, LINK_DELTA_SIZE or LINK_FULL_SIZE
+ @param[out] rollAngle The roll angle in degrees
+ @param[out] pitchAngle The pitch angle in degrees
+ */
+int link_decode(Link_decoder *d, const uint8_t *packet, int length, int8_t *rollAngle, int8_t *pitchAngle);
+
+/*!
+ Write a telemetry packet. Returns LINK_TELEMETRY_SIZE.
+ @param[in] t A pointer to the telemetry
+ @param[out] packet Receives the packet, LINK_TELEMETRY_SIZE bytes
+ */
+int link_telemetry_encode(const Link_telemetry *t, uint8_t *packet);
+
+/*!
+ Read a telemetry packet. Returns 0 on success, -1 if the packet is not telemetry.
+ @param[out] t A pointer to the telemetry
+ @param[in] packet The packet
+ @param[in] length The packet length
+ */
+int link_telemetry_decode(Link_telemetry *t, const uint8_t *packet, int length);
+
+#endif
+
+//! @}
@@ -0,0 +1,194 @@
+#include "slab.h"
+
+#include <stdio.h>
+
+#include "stm32f4xx.h"
+
+#ifndef SLAB_LOCK_FREE
+#if (__CORTEX_M >= 0x03)
+#define SLAB_LOCK_FREE 1
+#else
+#define SLAB_LOCK_FREE 0
+#endif
+#endif
+
+typedef struct {
+	uint32_t *start;	//first block
+	uint32_t *end;	//one past the last block
+	uint32_t blockSize;
+	uint32_t numBlocks;
+	volatile uint32_t free;	//address of the first free block, 0 if empty
+	volatile uint32_t used;
+	volatile uint32_t peak;
+	volatile uint32_t failures;
+} Slab_class;
+
+static uint32_t blocks4[SLAB_BLOCKS_4];
+static uint32_t blocks8[SLAB_BLOCKS_8 * 2];
+static uint32_t blocks16[SLAB_BLOCKS_16 * 4];
+static uint32_t blocks32[SLAB_BLOCKS_32 * 8];
+
+//Smallest class first
+static Slab_class classes[SLAB_NUM_CLASSES] = {
+	{blocks4, blocks4 + SLAB_BLOCKS_4, 4, SLAB_BLOCKS_4},
+	{blocks8, blocks8 + SLAB_BLOCKS_8 * 2, 8, SLAB_BLOCKS_8},
+	{blocks16, blocks16 + SLAB_BLOCKS_16 * 4, 16, SLAB_BLOCKS_16},
+	{blocks32, blocks32 + SLAB_BLOCKS_32 * 8, 32, SLAB_BLOCKS_32}
+};
+
+#if SLAB_LOCK_FREE
+static uint32_t atomic_add(volatile uint32_t *value, int32_t delta)
+{
+	uint32_t result;
+
+	do {
+		result = __LDREXW(value) + delta;
+	} while (__STREXW(result, value));
+	return result;
+}
+
+static void atomic_max(volatile uint32_t *value, uint32_t candidate)
+{
+	do {
+		if (__LDREXW(value) >= candidate)
+		{
+			__CLREX();
+			return;
+		}
+	} while (__STREXW(candidate, value));
+}
+#endif
+
+void slab_init()
+{
+	int i;
+	uint32_t *block;
+	Slab_class *c;
+
+	for (i = 0; i < SLAB_NUM_CLASSES; i++)
+	{
+		c = &classes[i];
+
+		//Link every block to the next one, the first word of a free block is the link
+		for (block = c->start; block < c->end; block += c->blockSize / 4)
+		{
+			*block = (block + c->blockSize / 4 < c->end)? (uint32_t)(block + c->blockSize / 4): 0;
+		}
+		c->free = (uint32_t)c->start;
+		c->used = 0;
+		c->peak = 0;
+		c->failures = 0;
+	}
+}
+
+void *slab_alloc(uint32_t size)
+{
+	int i;
+	uint32_t block;
+	Slab_class *c;
+#if !SLAB_LOCK_FREE
+	uint32_t primask;
+#endif
+
+	for (i = 0; i < SLAB_NUM_CLASSES && classes[i].blockSize < size; i++);
+	if (i == SLAB_NUM_CLASSES)
+	{
+		return NULL;
+	}
+	c = &classes[i];
+
+#if SLAB_LOCK_FREE
+	do {
+		block = __LDREXW(&c->free);
+		if (block == 0)
+		{
+			__CLREX();
+			break;
+		}
+	} while (__STREXW(*(uint32_t *)block, &c->free));
+
+	if (block == 0)
+	{
+		atomic_add(&c->failures, 1);
+		return NULL;
+	}
+	atomic_max(&c->peak, atomic_add(&c->used, 1));
+#else
+	primask = __get_PRIMASK();
+	__disable_irq();
+	block = c->free;
+	if (block != 0)
+	{
+		c->free = *(uint32_t *)block;
+		if (++c->used > c->peak)
+		{
+			c->peak = c->used;
+		}
+	}
+	else
+	{
+		c->failures++;
+	}
+	__set_PRIMASK(primask);
+#endif
+	return (void *)block;
+}
+
+void slab_free(void *block)
+{
+	int i;
+	uint32_t *b = block;
+	Slab_class *c;
+#if !SLAB_LOCK_FREE
+	uint32_t primask;
+#endif
+
+	for (i = 0; i < SLAB_NUM_CLASSES; i++)
+	{
+		c = &classes[i];
+		if (b >= c->start && b < c->end && ((uint32_t)b - (uint32_t)c->start) % c->blockSize == 0)
+		{
+#if SLAB_LOCK_FREE
+			do {
+				*b = __LDREXW(&c->free);
+			} while (__STREXW((uint32_t)b, &c->free));
+			atomic_add(&c->used, -1);
+#else
+			primask = __get_PRIMASK();
+			__disable_irq();
+			*b = c->free;
+			c->free = (uint32_t)b;
+			c->used--;
+			__set_PRIMASK(primask);
+#endif
+			return;
+		}
+	}
+}
+
+int slab_get_stats(int sizeClass, Slab_stats *stats)
+{
+	if (sizeClass < 0 || sizeClass >= SLAB_NUM_CLASSES)
+	{
+		return -1;
+	}
+	stats->blockSize = classes[sizeClass].blockSize;
+	stats->numBlocks = classes[sizeClass].numBlocks;
+	stats->used = classes[sizeClass].used;
+	stats->peak = classes[sizeClass].peak;
+	stats->failures = classes[sizeClass].failures;
+	return 0;
+}
+
+void slab_print_stats()
+{
+	int i;
+	Slab_stats stats;
+
+	for (i = 0; i < SLAB_NUM_CLASSES; i++)
+	{
+		slab_get_stats(i, &stats);
+		printf("slab %u: used %u/%u peak %u failed %u\n", (unsigned)stats.blockSize, (unsigned)stats.used,
+			(unsigned)stats.numBlocks, (unsigned)stats.peak, (unsigned)stats.failures);
+	}
+}
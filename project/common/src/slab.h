@@ -0,0 +1,82 @@
+/*!
+ @file slab.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a fixed-size block allocator shared by all message types. Blocks come from a few size classes,
+ each a free list in a static array, so allocation and free are O(1) and safe to call from interrupts.
+ On Cortex-M3/M4 the free lists are updated with LDREX/STREX and never disable interrupts (SLAB_LOCK_FREE).
+ This is safe on a single core because every exception entry and return clears the exclusive monitor, so an
+ interrupted update always retries. The number of blocks per class can be overridden in the project defines.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include <stdint.h>
+
+#ifndef SLAB_BLOCKS_4
+#define SLAB_BLOCKS_4 96	/*!< Number of 4 byte blocks */
+#endif
+#ifndef SLAB_BLOCKS_8
+#define SLAB_BLOCKS_8 16	/*!< Number of 8 byte blocks */
+#endif
+#ifndef SLAB_BLOCKS_16
+#define SLAB_BLOCKS_16 8	/*!< Number of 16 byte blocks */
+#endif
+#ifndef SLAB_BLOCKS_32
+#define SLAB_BLOCKS_32 8	/*!< Number of 32 byte blocks */
+#endif
+
+#define SLAB_NUM_CLASSES 4	/*!< Number of size classes */
+
+/**
+* A structure to hold the usage counters of one size class
+*/
+typedef struct {
+	uint32_t blockSize;	/**< the block size in bytes */
+	uint32_t numBlocks;	/**< the number of blocks */
+	uint32_t used;	/**< the number of blocks currently allocated */
+	uint32_t peak;	/**< the highest number of blocks allocated at once */
+	uint32_t failures;	/**< the number of allocations that found the class empty */
+} Slab_stats;
+
+/*!
+ Build the free lists. Must be called once before any block is allocated.
+ */
+void slab_init(void);
+
+/*!
+ Allocate a block from the smallest class that fits. Returns NULL if that class is empty.
+ Safe to call from an interrupt.
+ @param[in] size The size in bytes
+ */
+void *slab_alloc(uint32_t size);
+
+/*!
+ Return a block to its class. Does nothing for NULL or a pointer that was not allocated by slab_alloc.
+ Safe to call from an interrupt.
+ @param[in] block A pointer to the block
+ */
+void slab_free(void *block);
+
+/*!
+ Read the usage counters of one size class. Returns 0 on success, -1 for an invalid class.
+ @param[in] sizeClass The class index, 0 to SLAB_NUM_CLASSES - 1
+ @param[out] stats A pointer to the stats struct
+ */
+int slab_get_stats(int sizeClass, Slab_stats *stats);
+
+/*!
+ Print the usage counters of every class through printf (ITM on target).
+ */
+void slab_print_stats(void);
+
+#endif
+
+//! @}
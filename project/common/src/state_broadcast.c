@@ -0,0 +1,60 @@
+#include "state_broadcast.h"
+
+#include "stm32f4xx.h"
+
+//Signal every subscriber, osSignalSet is ISR safe
+static void notify(State_broadcast *s)
+{
+	int i;
+
+	for (i = 0; i < s->numSubscribers; i++)
+	{
+		osSignalSet(s->subscribers[i], s->signals[i]);
+	}
+}
+
+void state_init(State_broadcast *s, uint16_t value)
+{
+	s->word = value;
+	s->numSubscribers = 0;
+}
+
+int state_subscribe(State_broadcast *s, osThreadId id, int32_t signal)
+{
+	if (s->numSubscribers >= STATE_MAX_SUBSCRIBERS)
+	{
+		return -1;
+	}
+	s->subscribers[s->numSubscribers] = id;
+	s->signals[s->numSubscribers] = signal;
+	s->numSubscribers++;
+	return 0;
+}
+
+void state_publish(State_broadcast *s, uint16_t value)
+{
+	uint32_t word;
+
+	//Any interrupt between LDREX and STREX makes the store fail and the update retry
+	do {
+		word = __LDREXW(&s->word);
+		word = (word & 0xFFFF0000) + 0x10000 + value;
+	} while (__STREXW(word, &s->word));
+
+	notify(s);
+}
+
+uint16_t state_update(State_broadcast *s, uint16_t (*f)(uint16_t value))
+{
+	uint32_t word;
+	uint16_t value;
+
+	do {
+		word = __LDREXW(&s->word);
+		value = f((uint16_t)(word & 0xFFFF));
+		word = (word & 0xFFFF0000) + 0x10000 + value;
+	} while (__STREXW(word, &s->word));
+
+	notify(s);
+	return value;
+}
@@ -0,0 +1,80 @@
+/*!
+ @file state_broadcast.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a lock-free way to share a small state value (e.g. the operating mode) between threads and ISRs.
+ The value and a version counter live in one 32-bit word, so readers need a single load and never block.
+ Writers update the word with LDREX/STREX, which makes state_publish safe from interrupts, and then set a
+ signal on every subscribed thread so threads can sleep until the state changes.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _STATE_BROADCAST_H
+#define _STATE_BROADCAST_H
+
+#include <stdint.h>
+#include "cmsis_os.h"
+
+#define STATE_MAX_SUBSCRIBERS 4	/*!< Maximum number of threads notified of a change */
+
+/**
+* A structure to represent a broadcast state
+*/
+typedef struct {
+	volatile uint32_t word;	/**< the version in the upper 16 bits, the value in the lower 16 bits */
+	osThreadId subscribers[STATE_MAX_SUBSCRIBERS];	/**< the threads notified of a change */
+	int32_t signals[STATE_MAX_SUBSCRIBERS];	/**< the signal set on each subscriber */
+	int numSubscribers;	/**< the number of subscribers */
+} State_broadcast;
+
+/*!
+ Initialize a state with version 0.
+ @param[out] s A pointer to the state struct
+ @param[in] value The initial value
+ */
+void state_init(State_broadcast *s, uint16_t value);
+
+/*!
+ Notify a thread of every change. Call from thread context before the state is published concurrently.
+ Returns 0 on success, -1 if STATE_MAX_SUBSCRIBERS threads are already subscribed.
+ @param[in,out] s A pointer to the state struct
+ @param[in] id The thread to notify
+ @param[in] signal The signal flag set on the thread
+ */
+int state_subscribe(State_broadcast *s, osThreadId id, int32_t signal);
+
+/*!
+ Set a new value, increment the version and notify the subscribers. Safe to call from an interrupt.
+ @param[in,out] s A pointer to the state struct
+ @param[in] value The new value
+ */
+void state_publish(State_broadcast *s, uint16_t value);
+
+/*!
+ Atomically replace the value by f(value), e.g. to toggle a mode from an ISR. Returns the new value.
+ @param[in,out] s A pointer to the state struct
+ @param[in] f The update function, may be called more than once
+ */
+uint16_t state_update(State_broadcast *s, uint16_t (*f)(uint16_t value));
+
+/*!
+ Read the current value with a single load.
+ @param[in] s A pointer to the state struct
+ */
+#define state_get(s) ((uint16_t)((s)->word & 0xFFFF))
+
+/*!
+ Read the current version, which changes on every publish. Compare two versions to detect a change
+ without comparing values.
+ @param[in] s A pointer to the state struct
+ */
+#define state_version(s) ((uint16_t)((s)->word >> 16))
+
+#endif
+
+//! @}
@@ -0,0 +1,139 @@
+#include "tdma.h"
+
+uint16_t tdma_slot_time(uint16_t frameTime)
+{
+	return frameTime + TDMA_GUARD;
+}
+
+uint32_t tdma_superframe_time(uint16_t slotTime)
+{
+	return (uint32_t)slotTime * (TDMA_BEACON_SLOTS + TDMA_SLOTS + 1);
+}
+
+//Timed from the end of the beacon, which is on the air for less than TDMA_BEACON_SLOTS: the superframe
+//still has room for every slot after it. Half the guard on each side of a packet
+uint32_t tdma_slot_start(const Tdma_beacon *b, int slot)
+{
+	return (uint32_t)b->slotTime * slot + TDMA_GUARD / 2;
+}
+
+void tdma_master_init(Tdma_master *m, uint16_t slotTime)
+{
+	int i;
+
+	m->beacon.sequence = 0;
+	m->beacon.slotTime = slotTime;
+	m->timeout = (uint32_t)TDMA_TIMEOUT * 1000 / tdma_superframe_time(slotTime) + 1;
+	for (i = 0; i < TDMA_SLOTS; i++)
+	{
+		m->beacon.owners[i] = TDMA_BROADCAST;
+		m->silent[i] = 0;
+	}
+}
+
+int tdma_master_heard(Tdma_master *m, uint8_t address)
+{
+	int slot = tdma_slot_of(&m->beacon, address);
+
+	if (slot >= 0)
+	{
+		m->silent[slot] = 0;
+	}
+	return slot;
+}
+
+int tdma_master_join(Tdma_master *m, uint8_t address)
+{
+	int slot = tdma_master_heard(m, address);
+	int i;
+
+	for (i = 0; slot < 0 && i < TDMA_SLOTS; i++)
+	{
+		if (m->beacon.owners[i] == TDMA_BROADCAST)
+		{
+			m->beacon.owners[i] = address;
+			m->silent[i] = 0;
+			slot = i;
+		}
+	}
+	return slot;
+}
+
+void tdma_master_next(Tdma_master *m)
+{
+	int i;
+
+	for (i = 0; i < TDMA_SLOTS; i++)
+	{
+		if (m->beacon.owners[i] != TDMA_BROADCAST && ++m->silent[i] >= m->timeout)
+		{
+			m->beacon.owners[i] = TDMA_BROADCAST;
+		}
+	}
+	m->beacon.sequence++;
+}
+
+int tdma_beacon_encode(const Tdma_beacon *b, uint8_t *packet)
+{
+	int i;
+
+	packet[0] = TDMA_BEACON;
+	packet[1] = b->sequence;
+	packet[2] = b->slotTime & 0xff;
+	packet[3] = b->slotTime >> 8;
+	for (i = 0; i < TDMA_SLOTS; i++)
+	{
+		packet[4 + i] = b->owners[i];
+	}
+	return TDMA_BEACON_SIZE;
+}
+
+int tdma_beacon_decode(Tdma_beacon *b, const uint8_t *packet, int length)
+{
+	int i;
+
+	if (length != TDMA_BEACON_SIZE || packet[0] != TDMA_BEACON)
+	{
+		return -1;
+	}
+	b->sequence = packet[1];
+	b->slotTime = packet[2] | (packet[3] << 8);
+	for (i = 0; i < TDMA_SLOTS; i++)
+	{
+		b->owners[i] = packet[4 + i];
+	}
+	return 0;
+}
+
+int tdma_slot_of(const Tdma_beacon *b, uint8_t address)
+{
+	int i;
+
+	for (i = 0; i < TDMA_SLOTS; i++)
+	{
+		if (b->owners[i] == address)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+//Addresses 1 to TDMA_SLOTS ask in the even rounds of TDMA_SLOTS superframes, which are theirs alone: a
+//higher address asking in the same superframe would collide with them every time and could take the last
+//free slot meanwhile. The next TDMA_SLOTS addresses ask in every odd round, the next in one out of two, ...
+int tdma_may_join(const Tdma_beacon *b, uint8_t address)
+{
+	int round = b->sequence / TDMA_SLOTS;
+	int group = (address - 1) / TDMA_SLOTS;
+
+	if (b->sequence % TDMA_SLOTS != (address - 1) % TDMA_SLOTS)
+	{
+		return 0;
+	}
+	if (group == 0)
+	{
+		return round % 2 == 0;
+	}
+	return round % 2 == 1 && (round / 2) % group == group - 1;
+}
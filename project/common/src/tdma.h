@@ -0,0 +1,142 @@
+/*!
+ @file tdma.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is the time division medium access used when several remote boards share one base board
+ (TDMA_ENABLE=1 on every board). The base board is the master: each superframe starts with its beacon,
+ which lists the remote address owning each of the TDMA_SLOTS data slots. A remote transmits one packet in
+ its own slot, timed from the end of the beacon, so transmissions never overlap. The slot after the data
+ slots takes join requests: a remote without a slot asks for one in one superframe out of TDMA_SLOTS, picked
+ from its address. Remotes with addresses 1 to TDMA_SLOTS ask in every other round of TDMA_SLOTS superframes
+ and never collide there either; higher addresses ask in the rounds between, less often the higher they are,
+ so they collide now and then. A slot whose owner stays silent for TDMA_TIMEOUT is given up.
+ host/tdma_sim.c checks the slot timing and the joins on every radio profile.
+
+ Superframe: | beacon (TDMA_BEACON_SLOTS) | data slot 0 | ... | data slot TDMA_SLOTS - 1 | join slot |
+
+ A slot is the air time of one full message (CC2500_Profile frameTime) plus TDMA_GUARD: 488 us at
+ 500 kBaud, a 3.4 ms superframe carrying 292 packets per second for each remote; 60 ms at 2.4 kBaud,
+ a 422 ms superframe.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _TDMA_H
+#define _TDMA_H
+
+#include <stdint.h>
+
+#ifndef TDMA_ENABLE
+#define TDMA_ENABLE 0	/*!< 1: several remote boards share the base board, 0: one remote and no beacons */
+#endif
+
+#define TDMA_SLOTS 4	/*!< Data slots in a superframe, the most remote boards one base board follows */
+#define TDMA_BEACON_SLOTS 2	/*!< Slots taken by the beacon, a longer packet than the data */
+#define TDMA_GUARD 200	/*!< usec added to each slot for timing errors and the RX to TX turnaround */
+#define TDMA_TIMEOUT 1500	/*!< msec without a packet from its owner before a slot is freed, three keepalives */
+
+#define TDMA_BROADCAST 0	/*!< Address of the beacons; remote boards use 1 to 255 */
+#define TDMA_BEACON 0xB5	/*!< First byte of a beacon */
+#define TDMA_BEACON_SIZE (4 + TDMA_SLOTS)	/*!< Bytes in a beacon: TDMA_BEACON, sequence, slot time (2), owners */
+
+/**
+* A structure to represent a beacon
+*/
+typedef struct {
+	uint8_t sequence;	/**< the superframe number */
+	uint16_t slotTime;	/**< the slot length in usec */
+	uint8_t owners[TDMA_SLOTS];	/**< the address owning each data slot, TDMA_BROADCAST if free */
+} Tdma_beacon;
+
+/**
+* A structure to represent the master side, kept by the base board
+*/
+typedef struct {
+	Tdma_beacon beacon;	/**< the next beacon */
+	uint16_t timeout;	/**< the superframes of silence before a slot is freed */
+	uint16_t silent[TDMA_SLOTS];	/**< the superframes since each owner was heard */
+} Tdma_master;
+
+/*!
+ Get the slot length for a radio profile in usec
+ @param[in] frameTime The air time of a full message in usec
+ */
+uint16_t tdma_slot_time(uint16_t frameTime);
+
+/*!
+ Get the superframe length in usec
+ @param[in] slotTime The slot length in usec
+ */
+uint32_t tdma_superframe_time(uint16_t slotTime);
+
+/*!
+ Get the start of a slot in usec after the end of the beacon
+ @param[in] b A pointer to the beacon
+ @param[in] slot The data slot, or TDMA_SLOTS for the join slot
+ */
+uint32_t tdma_slot_start(const Tdma_beacon *b, int slot);
+
+/*!
+ Start with every slot free.
+ @param[out] m A pointer to the master struct
+ @param[in] slotTime The slot length in usec
+ */
+void tdma_master_init(Tdma_master *m, uint16_t slotTime);
+
+/*!
+ Account a packet from a remote board. Returns its data slot, or -1 if it owns none.
+ @param[in,out] m A pointer to the master struct
+ @param[in] address The address of the remote board
+ */
+int tdma_master_heard(Tdma_master *m, uint8_t address);
+
+/*!
+ Give a slot to a remote board asking to join. Returns its data slot (the one it already owns if any),
+ or -1 if every slot is taken.
+ @param[in,out] m A pointer to the master struct
+ @param[in] address The address of the remote board
+ */
+int tdma_master_join(Tdma_master *m, uint8_t address);
+
+/*!
+ End a superframe: free the slots of silent owners and number the next beacon.
+ @param[in,out] m A pointer to the master struct
+ */
+void tdma_master_next(Tdma_master *m);
+
+/*!
+ Write a beacon. Returns TDMA_BEACON_SIZE.
+ @param[in] b A pointer to the beacon
+ @param[out] packet Receives the packet, TDMA_BEACON_SIZE bytes
+ */
+int tdma_beacon_encode(const Tdma_beacon *b, uint8_t *packet);
+
+/*!
+ Read a beacon. Returns 0 on success, -1 if the packet is not a beacon.
+ @param[out] b A pointer to the beacon
+ @param[in] packet The packet
+ @param[in] length The packet length
+ */
+int tdma_beacon_decode(Tdma_beacon *b, const uint8_t *packet, int length);
+
+/*!
+ Find the data slot of a remote board in a beacon. Returns the slot, or -1 if it owns none.
+ @param[in] b A pointer to the beacon
+ @param[in] address The address of the remote board
+ */
+int tdma_slot_of(const Tdma_beacon *b, uint8_t address);
+
+/*!
+ Whether a remote board without a slot may ask for one in this superframe
+ @param[in] b A pointer to the beacon
+ @param[in] address The address of the remote board
+ */
+int tdma_may_join(const Tdma_beacon *b, uint8_t address);
+
+#endif
+
+//! @}
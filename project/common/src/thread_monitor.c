@@ -0,0 +1,114 @@
+#include "thread_monitor.h"
+
+#include <stdio.h>
+
+#include "slab.h"
+
+typedef struct {
+	osThreadId id;
+	const char *name;
+	uint32_t lastCycles;
+} Monitor_entry;
+
+//entry 0 is the idle thread
+static Monitor_entry entries[MONITOR_MAX_THREADS + 1] = {{NULL, "idle", 0}};
+static int numEntries = 1;
+
+typedef struct {
+	osMessageQId id;
+	const char *name;
+} Monitor_queue;
+
+static Monitor_queue queues[MONITOR_MAX_QUEUES];
+static int numQueues = 0;
+
+void monitor_add(osThreadId id, const char *name)
+{
+	if (numEntries <= MONITOR_MAX_THREADS)
+	{
+		entries[numEntries].id = id;
+		entries[numEntries].name = name;
+		entries[numEntries].lastCycles = 0;
+		numEntries++;
+	}
+}
+
+void monitor_add_queue(osMessageQId id, const char *name)
+{
+	if (numQueues < MONITOR_MAX_QUEUES)
+	{
+		queues[numQueues].id = id;
+		queues[numQueues].name = name;
+		numQueues++;
+	}
+}
+
+void monitor_report()
+{
+	osThreadInfo info[MONITOR_MAX_THREADS + 1];
+	uint32_t delta[MONITOR_MAX_THREADS + 1];
+	uint32_t total = 0;
+	int i;
+	
+	//Snapshot all threads first so the report itself is not counted in between
+	for (i = 0; i < numEntries; i++)
+	{
+		if (osThreadGetInfo(entries[i].id, &info[i]) != osOK)
+		{
+			return;
+		}
+		delta[i] = info[i].cycles - entries[i].lastCycles;
+		entries[i].lastCycles = info[i].cycles;
+		total += delta[i];
+	}
+	
+	if (total == 0)
+	{
+		return;
+	}
+	
+	for (i = 0; i < numEntries; i++)
+	{
+		printf("%s: cpu %u.%u%% stack %u/%u preempted %u (slices %u) missed %u\n",
+			entries[i].name,
+			(unsigned)((uint64_t)delta[i] * 1000 / total / 10),
+			(unsigned)((uint64_t)delta[i] * 1000 / total % 10),
+			(unsigned)info[i].stack_used,
+			(unsigned)info[i].stack_size,
+			(unsigned)info[i].preempts,
+			(unsigned)info[i].slices,
+			(unsigned)info[i].misses);
+	}
+}
+
+void monitor_report_queues()
+{
+	osObjectStats stats;
+	int i;
+	
+	for (i = 0; i < numQueues; i++)
+	{
+		if (osMessageGetStats(queues[i].id, &stats) == osOK)
+		{
+			printf("%s: queue %u/%u peak %u failed %u put_wait %u get_wait %u\n",
+				queues[i].name,
+				(unsigned)stats.count,
+				(unsigned)stats.capacity,
+				(unsigned)stats.peak,
+				(unsigned)stats.failures,
+				(unsigned)stats.put_wait,
+				(unsigned)stats.get_wait);
+		}
+	}
+	slab_print_stats();
+}
+
+void monitor_thread(void const *arg)
+{
+	while(1)
+	{
+		osDelay(MONITOR_PERIOD);
+		monitor_report();
+		monitor_report_queues();
+	}
+}
@@ -0,0 +1,62 @@
+/*!
+ @file thread_monitor.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a monitor thread that periodically prints the CPU load and stack high-water mark of every
+ registered thread over ITM (fputc_debug.c). Requires OS_MONITOR=1 in the project defines. It also prints the
+ usage counters of every registered message queue (requires OS_TELEMETRY > 0) and of the slab allocator. The monitor
+ thread uses a private stack, so OS_PRIVCNT must be increased by 1 and OS_PRIVSTKSIZE by MONITOR_STACK_SIZE.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _THREAD_MONITOR_H
+#define _THREAD_MONITOR_H
+
+#include "cmsis_os.h"
+
+#define MONITOR_MAX_THREADS 8	/*!< Maximum number of monitored threads (idle thread not included) */
+#define MONITOR_MAX_QUEUES 8	/*!< Maximum number of monitored message queues */
+#define MONITOR_PERIOD 1000	/*!< Report period in ms, must stay below one cycle counter wrap (25 s at 168 MHz) */
+#define MONITOR_STACK_SIZE 512	/*!< Stack size of the monitor thread in bytes */
+
+/*!
+ Add a thread to the report.
+ @param[in] id The thread ID
+ @param[in] name The name printed in the report
+ */
+void monitor_add(osThreadId id, const char *name);
+
+/*!
+ Add a message queue to the report.
+ @param[in] id The message queue ID
+ @param[in] name The name printed in the report
+ */
+void monitor_add_queue(osMessageQId id, const char *name);
+
+/*!
+ Print one report: for every thread the share of CPU cycles since the last report (one decimal)
+ and the stack used out of the stack size in bytes, followed by how often the thread was preempted since it started
+ and how many of those preemptions were round-robin time slices running out, and the deadline misses of periodic threads.
+ */
+void monitor_report(void);
+
+/*!
+ Print the usage counters of every message queue (occupancy, peak, failed puts and ticks blocked in put
+ and get) and of every slab allocator size class.
+ */
+void monitor_report_queues(void);
+
+/*!
+ Monitor thread: prints a report every MONITOR_PERIOD ms.
+ @param[in] arg Unused
+ */
+void monitor_thread(void const *arg);
+
+#endif
+
+//! @}
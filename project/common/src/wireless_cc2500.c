@@ -9,6 +9,52 @@ void CC2500_LowLevelInit(void);
 void CC2500_LowLevelWireless_Init(void);
 int CC2500_Check_Status(char status);
 void CC2500_Delay(void);
+void CC2500_WriteProfile(const CC2500_Profile *p);
+
+const CC2500_Profile CC2500_Profiles[CC2500_PROFILE_COUNT] = {
+	{"2.4 KBAUD", 60027, 0x08, {0x86, 0x83, 0x03, SMARTRF_SETTING_MDMCFG1, SMARTRF_SETTING_MDMCFG0, 0x44}, {0x16, 0x6C, 0x03, 0x40, 0x91}, 0x56},
+	{"10 KBAUD", 14411, 0x06, {0x78, 0x93, 0x03, SMARTRF_SETTING_MDMCFG1, SMARTRF_SETTING_MDMCFG0, 0x44}, {0x16, 0x6C, 0x43, 0x40, 0x91}, 0x56},
+	{"250 KBAUD", 576, 0x0A, {0x2D, 0x3B, 0x73, SMARTRF_SETTING_MDMCFG1, SMARTRF_SETTING_MDMCFG0, 0x00}, {0x1D, 0x1C, 0xC7, 0x00, 0xB0}, 0xB6},
+	{"500 KBAUD", 288, SMARTRF_SETTING_FSCTRL1,
+		{SMARTRF_SETTING_MDMCFG4, SMARTRF_SETTING_MDMCFG3, SMARTRF_SETTING_MDMCFG2, SMARTRF_SETTING_MDMCFG1, SMARTRF_SETTING_MDMCFG0, SMARTRF_SETTING_DEVIATN},
+		{SMARTRF_SETTING_FOCCFG, SMARTRF_SETTING_BSCFG, SMARTRF_SETTING_AGCCTRL2, SMARTRF_SETTING_AGCCTRL1, SMARTRF_SETTING_AGCCTRL0},
+		SMARTRF_SETTING_FREND1}
+};
+
+static CC2500_Rate profile = CC2500_PROFILE;
+static uint8_t channel = SMARTRF_SETTING_CHANNR;
+static uint8_t pktctrl1 = SMARTRF_SETTING_PKTCTRL1;	// with the address check of CC2500_SetAddress
+static uint8_t fifothr = SMARTRF_SETTING_FIFOTHR;	// last written by CC2500_SetTXRoom
+
+// Not described by this version of core_cm4.h
+#define DWT_CTRL	(*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT	(*((volatile uint32_t *)0xE0001004))
+#define DWT_CTRL_CYCCNTENA	0x00000001
+
+// MARCSTATE values
+#define MARCSTATE_IDLE 0x01
+#define MARCSTATE_RX 0x0D
+#define MARCSTATE_TX 0x13
+
+// A synthesizer calibration, valid for one channel with one profile
+typedef struct {
+	uint8_t valid;
+	uint8_t channel;
+	uint8_t profile;
+	int8_t fscal[3];	// FSCAL3, FSCAL2, FSCAL1
+} CC2500_Calibration;
+
+static CC2500_Calibration calibrations[CC2500_CAL_CACHE_SIZE];
+static int nextCalibration = 0;	// the entry replaced by the next new calibration
+static uint32_t turnaround = 0;
+
+// Wake-on-radio: RC oscillator on and calibrated, EVENT1 = 48 RC periods for the crystal to start, WOR_RES 0
+#define WOR_WORCTRL 0x78
+// Listen 3.125% of EVENT0 (RX_TIME 2), longer while a preamble is heard (RX_TIME_QUAL)
+#define WOR_MCSM2 0x0A
+#define RX_MCSM2 0x07
+// A preamble is only "heard" above a quality threshold (PQT 1); with PQT 0 the radio would never time out
+#define WOR_PQT 0x20
 
 int CC2500_CmdStrobe(int8_t command) {
 	CC2500_NSS_LOW();
@@ -180,6 +226,11 @@ void CC2500_Init()
 {
 	// Perform the low-level initialization of the SPI, GPIO, etc...
 	CC2500_LowLevelInit();
+	
+	// Start the cycle counter used by CC2500_Enter, without clearing it for other users
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
 	CC2500_LowLevelWireless_Init();
 }
 
@@ -244,6 +295,251 @@ void CC2500_LowLevelWireless_Init()
 	registerData[0] = 0x3e;
 	CC2500_Write_Reg(registerData, MCSM1_WRITE_SINGLE, 1);
 	
+	// Modem settings of the selected data rate, then the first calibration
+	pktctrl1 = SMARTRF_SETTING_PKTCTRL1;
+	fifothr = SMARTRF_SETTING_FIFOTHR;
+	profile = CC2500_PROFILE;
+	CC2500_WriteProfile(&CC2500_Profiles[profile]);
+	// Not cached if the radio does not go idle: the first SetProfile or SetChannel calibrates again
+	CC2500_SetChannel(SMARTRF_SETTING_CHANNR);
+}
+
+// Wait until a strobe sent the radio to IDLE, bounded like CC2500_Enter. Returns 0 once idle, -1 on timeout
+static int CC2500_WaitIdle(void)
+{
+	uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+	uint32_t start = DWT_CYCCNT;
+	int8_t state;
+	
+	do
+	{
+		CC2500_Read_Reg(&state, MARCSTATE, 1);
+		if ((state & 0x1f) == MARCSTATE_IDLE)
+		{
+			return 0;
+		}
+	} while ((DWT_CYCCNT - start) / cyclesPerUs < CC2500_ENTER_TIMEOUT);
+	return -1;
+}
+
+static CC2500_Calibration *CC2500_FindCalibration(void)
+{
+	int i;
+	
+	for (i = 0; i < CC2500_CAL_CACHE_SIZE; i++)
+	{
+		if (calibrations[i].valid && calibrations[i].channel == channel && calibrations[i].profile == profile)
+		{
+			return &calibrations[i];
+		}
+	}
+	return NULL;
+}
+
+int CC2500_Calibrate()
+{
+	CC2500_Calibration *c = CC2500_FindCalibration();
+	
+	if (c == NULL)
+	{
+		c = &calibrations[nextCalibration];
+		nextCalibration = (nextCalibration + 1) % CC2500_CAL_CACHE_SIZE;
+	}
+	
+	// A calibration that did not finish is not cached, the next tune starts another
+	c->valid = 0;
+	CC2500_CmdStrobe(SCAL);
+	if (CC2500_WaitIdle() != 0)
+	{
+		return -1;
+	}
+	CC2500_Read_Reg(c->fscal, FSCAL3_READ_BURST, 3);
+	c->channel = channel;
+	c->profile = profile;
+	c->valid = 1;
+	return 0;
+}
+
+// Load the calibration of the channel and profile in use, the radio must be idle
+static int CC2500_Tune(void)
+{
+	CC2500_Calibration *c = CC2500_FindCalibration();
+	
+	if (c != NULL)
+	{
+		CC2500_Write_Reg(c->fscal, FSCAL3_WRITE_BURST, 3);
+		return 0;
+	}
+	return CC2500_Calibrate();
+}
+
+int CC2500_SetChannel(uint8_t newChannel)
+{
+	CC2500_CmdStrobe(SIDLE);
+	if (CC2500_WaitIdle() != 0)
+	{
+		return -1;
+	}
+	
+	channel = newChannel;
+	CC2500_Write_Reg((int8_t *)&channel, CHANNR_WRITE_SINGLE, 1);
+	return CC2500_Tune();
+}
+
+uint8_t CC2500_GetChannel()
+{
+	return channel;
+}
+
+uint32_t CC2500_Enter(int8_t strobe)
+{
+	uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+	uint8_t target = (strobe == SRX)? MARCSTATE_RX: (strobe == STX)? MARCSTATE_TX: MARCSTATE_IDLE;
+	uint32_t start = DWT_CYCCNT;
+	int8_t state;
+	
+	CC2500_CmdStrobe(strobe);
+	do
+	{
+		CC2500_Read_Reg(&state, MARCSTATE, 1);
+		turnaround = (DWT_CYCCNT - start) / cyclesPerUs;
+	} while ((state & 0x1f) != target && turnaround < CC2500_ENTER_TIMEOUT);
+	
+	return turnaround;
+}
+
+uint32_t CC2500_Turnaround()
+{
+	return turnaround;
+}
+
+void CC2500_PacketInterruptCmd(FunctionalState state)
+{
+	if (state == ENABLE)
+	{
+		EXTI_ClearITPendingBit(CC2500_SPI_INT0_EXTI_LINE);
+		EXTI->IMR |= CC2500_SPI_INT0_EXTI_LINE;
+	}
+	else
+	{
+		EXTI->IMR &= ~CC2500_SPI_INT0_EXTI_LINE;
+	}
+}
+
+int CC2500_WakeOnRadio(uint16_t period)
+{
+	// EVENT0 counts periods of 750 / f_XOSC (28.8 us)
+	uint16_t event0 = (uint32_t)period * 26000 / 750;
+	int8_t registerData[3];
+	
+	CC2500_CmdStrobe(SIDLE);
+	if (CC2500_WaitIdle() != 0)
+	{
+		return -1;
+	}
+	
+	registerData[0] = WOR_MCSM2;
+	CC2500_Write_Reg(registerData, MCSM2_WRITE_SINGLE, 1);
+	registerData[0] = pktctrl1 | WOR_PQT;
+	CC2500_Write_Reg(registerData, PKTCTRL1_WRITE_SINGLE, 1);
+	registerData[0] = event0 >> 8;
+	registerData[1] = event0 & 0xff;
+	registerData[2] = WOR_WORCTRL;
+	CC2500_Write_Reg(registerData, WOREVT1_WRITE_BURST, 3);
+	
+	CC2500_PacketInterrupt_Config();
+	
+	// The synthesizer keeps its FSCAL values through SLEEP, so each wake-up only settles
+	CC2500_CmdStrobe(SFRX);
+	CC2500_CmdStrobe(SWORRST);
+	CC2500_CmdStrobe(SWOR);
+	// The radio only goes to sleep once chip select is released
+	CC2500_NSS_HIGH();
+	return 0;
+}
+
+void CC2500_PacketInterrupt_Config()
+{
+	EXTI_InitTypeDef extiInit;
+	NVIC_InitTypeDef nvicInit;
+	
+	// GDO0 (IOCFG0 0x06) deasserts at the end of a packet
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+	SYSCFG_EXTILineConfig(CC2500_SPI_INT0_EXTI_PORT_SOURCE, CC2500_SPI_INT0_EXTI_PIN_SOURCE);
+	extiInit.EXTI_Line = CC2500_SPI_INT0_EXTI_LINE;
+	extiInit.EXTI_Mode = EXTI_Mode_Interrupt;
+	extiInit.EXTI_Trigger = EXTI_Trigger_Falling;
+	extiInit.EXTI_LineCmd = ENABLE;
+	EXTI_Init(&extiInit);
+	
+	nvicInit.NVIC_IRQChannel = CC2500_SPI_INT0_EXTI_IRQn;
+	nvicInit.NVIC_IRQChannelCmd = ENABLE;
+	nvicInit.NVIC_IRQChannelPreemptionPriority = 1;
+	nvicInit.NVIC_IRQChannelSubPriority = 1;
+	NVIC_Init(&nvicInit);
+	CC2500_PacketInterruptCmd(ENABLE);
+}
+
+void CC2500_SetAddress(uint8_t address, uint8_t check)
+{
+	int8_t registerData[1];
+	
+	pktctrl1 = (SMARTRF_SETTING_PKTCTRL1 & ~0x03) | check;
+	registerData[0] = pktctrl1;
+	CC2500_Write_Reg(registerData, PKTCTRL1_WRITE_SINGLE, 1);
+	registerData[0] = address;
+	CC2500_Write_Reg(registerData, ADDR_WRITE_SINGLE, 1);
+}
+
+int CC2500_WakeUp()
+{
+	int8_t registerData[1];
+	
+	CC2500_PacketInterruptCmd(DISABLE);
+	
+	// SIDLE ends wake-on-radio and keeps the RX FIFO; a packet arriving meanwhile is lost,
+	// so the remote board pauses after the packet that wakes us
+	CC2500_CmdStrobe(SIDLE);
+	if (CC2500_WaitIdle() != 0)
+	{
+		return -1;
+	}
+	registerData[0] = RX_MCSM2;
+	CC2500_Write_Reg(registerData, MCSM2_WRITE_SINGLE, 1);
+	registerData[0] = pktctrl1;
+	CC2500_Write_Reg(registerData, PKTCTRL1_WRITE_SINGLE, 1);
+	CC2500_Enter(SRX);
+	return 0;
+}
+
+// Write the registers that differ between profiles, the radio must be idle
+void CC2500_WriteProfile(const CC2500_Profile *p)
+{
+	CC2500_Write_Reg((int8_t *)&p->fsctrl1, FSCTRL1_WRITE_SINGLE, 1);
+	CC2500_Write_Reg((int8_t *)p->modem, MDMCFG4_WRITE_BURST, sizeof(p->modem));
+	CC2500_Write_Reg((int8_t *)p->frontEnd, FOCCFG_WRITE_BURST, sizeof(p->frontEnd));
+	CC2500_Write_Reg((int8_t *)&p->frend1, FREND1_WRITE_SINGLE, 1);
+}
+
+int CC2500_SetProfile(CC2500_Rate rate)
+{
+	CC2500_CmdStrobe(SIDLE);
+	if (CC2500_WaitIdle() != 0)
+	{
+		return -1;
+	}
+	
+	// Anything in the FIFOs belongs to the old rate
+	CC2500_CmdStrobe(SFRX);
+	CC2500_CmdStrobe(SFTX);
+	CC2500_WriteProfile(&CC2500_Profiles[rate]);
+	profile = rate;
+	return CC2500_Tune();
+}
+
+CC2500_Rate CC2500_GetProfile()
+{
+	return profile;
 }
 
 void CC2500_LowLevelInit()
@@ -332,14 +628,75 @@ void CC2500_LowLevelInit()
 void CC2500_TXGDIOInterrupts_Config()
 {
 	int8_t buffer;
+	EXTI_InitTypeDef extiInit;
+	NVIC_InitTypeDef nvicInit;
 	
-	// Configure GDIO2 to interrupt when TX FIFO is full
-	buffer = 0x03;
+	// Configure GDIO2 to deassert when the TX FIFO drops below the threshold (CC2500_SetTXRoom)
+	buffer = 0x02;
 	CC2500_Write_Reg(&buffer, IOCFG2_WRITE_SINGLE, 1);
 	
-	// Configure GDIO0 to interrupt when sync word has been received
+	// Configure GDIO0 to deassert at the end of each packet sent
 	buffer = 0x06;
 	CC2500_Write_Reg(&buffer, IOCFG0_WRITE_SINGLE, 1);
+	
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+	SYSCFG_EXTILineConfig(CC2500_SPI_INT2_EXTI_PORT_SOURCE, CC2500_SPI_INT2_EXTI_PIN_SOURCE);
+	extiInit.EXTI_Line = CC2500_SPI_INT2_EXTI_LINE;
+	extiInit.EXTI_Mode = EXTI_Mode_Interrupt;
+	extiInit.EXTI_Trigger = EXTI_Trigger_Falling;
+	extiInit.EXTI_LineCmd = ENABLE;
+	EXTI_Init(&extiInit);
+	
+	SYSCFG_EXTILineConfig(CC2500_SPI_INT0_EXTI_PORT_SOURCE, CC2500_SPI_INT0_EXTI_PIN_SOURCE);
+	extiInit.EXTI_Line = CC2500_SPI_INT0_EXTI_LINE;
+	EXTI_Init(&extiInit);
+	
+	// Both lines share EXTI15_10
+	nvicInit.NVIC_IRQChannel = CC2500_SPI_INT0_EXTI_IRQn;
+	nvicInit.NVIC_IRQChannelCmd = ENABLE;
+	nvicInit.NVIC_IRQChannelPreemptionPriority = 1;
+	nvicInit.NVIC_IRQChannelSubPriority = 1;
+	NVIC_Init(&nvicInit);
+	
+	// Masked until a thread waits on them
+	CC2500_TXFifoInterruptCmd(DISABLE);
+	CC2500_PacketInterruptCmd(DISABLE);
+}
+
+void CC2500_TXFifoInterruptCmd(FunctionalState state)
+{
+	if (state == ENABLE)
+	{
+		EXTI_ClearITPendingBit(CC2500_SPI_INT2_EXTI_LINE);
+		EXTI->IMR |= CC2500_SPI_INT2_EXTI_LINE;
+	}
+	else
+	{
+		EXTI->IMR &= ~CC2500_SPI_INT2_EXTI_LINE;
+	}
+}
+
+// FIFO_THR n puts the TX threshold at 61 - 4n bytes: below it at least 4 + 4n bytes are free.
+// The RX threshold moves with it, only GDO2 uses either
+void CC2500_SetTXRoom(int room)
+{
+	int8_t registerData[1];
+	int n = (room - 1) / 4;
+	
+	if (n < 0)
+	{
+		n = 0;
+	}
+	else if (n > 15)
+	{
+		n = 15;
+	}
+	if ((fifothr & 0x0f) != n)
+	{
+		fifothr = (fifothr & ~0x0f) | n;
+		registerData[0] = fifothr;
+		CC2500_Write_Reg(registerData, FIFOTHR_WRITE_SINGLE, 1);
+	}
 }
 
 void CC2500_RXGDIOInterrupts_Config()
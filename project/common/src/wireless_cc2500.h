@@ -110,7 +110,7 @@ int CC2500_Status(char status);
 // Page 65 of datasheet - FREQ 0,1,2 registers
 // We set f_carrier, f_XOSC = 26Mhz
 #define SMARTRF_SETTING_MDMCFG4 0x0E //0x2D // BW of channel = 541.666kHz
-#define SMARTRF_SETTING_MDMCFG3 0x3B // Baud Rate = 125kb
+#define SMARTRF_SETTING_MDMCFG3 0x3B // Baud Rate = 500kb
 #define SMARTRF_SETTING_MDMCFG2 0x73 //before demodulator, MSK modulation, 16/16 sync word bits detected
 #define SMARTRF_SETTING_MDMCFG1 0x42 //
 #define SMARTRF_SETTING_MDMCFG0 0xF8 // Default Channel Spacing of 200kHz
@@ -118,7 +118,7 @@ int CC2500_Status(char status);
 #define SMARTRF_SETTING_DEVIATN 0x00 //0x01 // 1785kHz
 #define SMARTRF_SETTING_FREND1 0xB6
 #define SMARTRF_SETTING_FREND0 0x10
-#define SMARTRF_SETTING_MCSM0 0x18 // Automatically calibrate When going from IDLE to RX or TX (or FSTXON) check CC2500 datasheet
+#define SMARTRF_SETTING_MCSM0 0x08 // No automatic calibration: the driver calibrates once per channel and restores FSCAL3-1 (CC2500_Calibrate)
 #define SMARTRF_SETTING_FOCCFG 0x1D // check datasheet
 #define SMARTRF_SETTING_BSCFG 0x1C
 #define SMARTRF_SETTING_AGCCTRL2 0xC7
@@ -142,6 +142,149 @@ int CC2500_Status(char status);
 
 #endif
 
+/**
+* The radio profiles: modem settings of the SmartRF preset for each data rate. Frequency, packet format
+* and calibration are shared. The air time is for a full 4 byte message: 8 preamble bytes, 2 sync bytes,
+* the length byte, the address byte, the payload and 2 CRC bytes, 144 bits.
+*/
+typedef enum {
+	CC2500_RATE_2K4 = 0,	/*!< 2-FSK, 203 kHz filter, 60.0 ms per frame: keypad programs and a slow stream only */
+	CC2500_RATE_10K,	/*!< 2-FSK, 232 kHz filter, 14.4 ms per frame: the longest range */
+	CC2500_RATE_250K,	/*!< MSK, 541 kHz filter, 576 us per frame */
+	CC2500_RATE_500K,	/*!< MSK, 812 kHz filter, 288 us per frame: the SMARTRF_SETTING values above */
+	CC2500_PROFILE_COUNT
+} CC2500_Rate;
+
+/**
+* A structure to represent a radio profile
+*/
+typedef struct {
+	const char *name;	/**< the name shown to the user */
+	uint16_t frameTime;	/**< the air time of a full message in usec */
+	uint8_t fsctrl1;	/**< the IF frequency */
+	uint8_t modem[6];	/**< MDMCFG4 to DEVIATN, in address order */
+	uint8_t frontEnd[5];	/**< FOCCFG to AGCCTRL0, in address order */
+	uint8_t frend1;	/**< the RX front end currents */
+} CC2500_Profile;
+
+#ifndef CC2500_PROFILE
+#define CC2500_PROFILE CC2500_RATE_500K	/*!< Profile set by CC2500_Init; both boards must start with the same one */
+#endif
+
+extern const CC2500_Profile CC2500_Profiles[CC2500_PROFILE_COUNT];	/*!< The profiles, indexed by CC2500_Rate */
+
+/*!
+ Switch the data rate. Leaves the radio idle with both FIFOs flushed, strobe SRX or STX to resume;
+ the synthesizer calibrates on the way. Returns 0 on success, -1 if the radio did not go idle within
+ CC2500_ENTER_TIMEOUT: before the switch, which keeps the old profile, or during the calibration.
+ @param[in] rate The new profile
+ */
+int CC2500_SetProfile(CC2500_Rate rate);
+
+/*!
+ Get the profile in use
+ */
+CC2500_Rate CC2500_GetProfile(void);
+
+#define CC2500_CAL_CACHE_SIZE 8	/*!< Synthesizer calibrations kept, one per channel and profile (the IF moves the RX LO) */
+#define CC2500_ENTER_TIMEOUT 2000	/*!< Longest wait in usec for CC2500_Enter and for the radio to go idle, a calibration takes about 720 */
+
+/*!
+ Tune to a channel. Restores its calibration if the channel was used before with this profile, so the
+ next SRX or STX only waits for the synthesizer to settle. Leaves the radio idle. Returns 0 on success, -1 if
+ the radio did not go idle within CC2500_ENTER_TIMEOUT.
+ @param[in] channel The channel number, CHANNR
+ */
+int CC2500_SetChannel(uint8_t channel);
+
+/*!
+ Get the channel in use
+ */
+uint8_t CC2500_GetChannel(void);
+
+/*!
+ Calibrate the synthesizer for the channel and profile in use and cache the result. The radio must be idle.
+ Done by CC2500_SetChannel and CC2500_SetProfile when needed; call again after a large temperature change.
+ Returns 0 on success, -1 if the calibration did not end within CC2500_ENTER_TIMEOUT; nothing is cached then.
+ */
+int CC2500_Calibrate(void);
+
+/*!
+ Strobe SRX, STX or SIDLE and wait until the radio is in that state. Returns the turnaround time in usec,
+ also kept for CC2500_Turnaround; CC2500_ENTER_TIMEOUT if the state was not reached.
+ @param[in] strobe SRX, STX or SIDLE
+ */
+uint32_t CC2500_Enter(int8_t strobe);
+
+/*!
+ Get the turnaround time measured by the last CC2500_Enter in usec
+ */
+uint32_t CC2500_Turnaround(void);
+
+#ifndef CC2500_WOR_PERIOD
+#define CC2500_WOR_PERIOD 0	/*!< Wake-on-radio event period of the base board in msec (at most 1890), 0 keeps it in continuous RX; both boards must agree */
+#endif
+#define CC2500_WOR_AWAKE 200	/*!< msec the base board stays in continuous RX after the last packet before going back to wake-on-radio */
+
+/*!
+ Enter wake-on-radio: the radio sleeps and listens for a few percent of every period, staying in RX when it
+ hears a preamble. GDO0 falling at the end of a received packet raises EXTI on CC2500_SPI_INT0_EXTI_LINE;
+ the board provides the handler, which calls CC2500_PacketInterruptCmd(DISABLE). Any SPI access wakes the
+ radio, so the caller must leave it alone until the interrupt or until it calls CC2500_WakeUp.
+ Returns 0 on success, -1 if the radio did not go idle within CC2500_ENTER_TIMEOUT and was left awake.
+ @param[in] period The event period in msec
+ */
+int CC2500_WakeOnRadio(uint16_t period);
+
+/*!
+ Leave wake-on-radio for continuous RX, in about 100 us. A packet that woke the radio stays in the RX FIFO.
+ Returns 0 on success, -1 if the radio did not go idle within CC2500_ENTER_TIMEOUT, before RX was entered.
+ */
+int CC2500_WakeUp(void);
+
+/*!
+ Enable or disable the end of packet interrupt
+ @param[in] state ENABLE or DISABLE
+ */
+void CC2500_PacketInterruptCmd(FunctionalState state);
+
+/*!
+ Route GDO0 falling, the end of a received packet or of a packet dropped by the address check, to EXTI on
+ CC2500_SPI_INT0_EXTI_LINE and enable it. The board provides the handler.
+ */
+void CC2500_PacketInterrupt_Config(void);
+
+/*!
+ Route GDO2 falling, the TX FIFO dropping below the threshold of CC2500_SetTXRoom, and GDO0 falling, the
+ end of each packet sent, to EXTI on CC2500_SPI_INT2_EXTI_LINE and CC2500_SPI_INT0_EXTI_LINE. Both start
+ disabled: a thread waiting for TX FIFO room or for the last packet enables them with CC2500_TXFifoInterruptCmd
+ and CC2500_PacketInterruptCmd instead of polling TXBYTES. The board provides the handler.
+ */
+void CC2500_TXGDIOInterrupts_Config(void);
+
+/*!
+ Enable or disable the TX FIFO threshold interrupt
+ @param[in] state ENABLE or DISABLE
+ */
+void CC2500_TXFifoInterruptCmd(FunctionalState state);
+
+/*!
+ Set the TX FIFO threshold so GDO2 falls once at least room bytes are free (at most FIFO_SIZE, when empty)
+ @param[in] room The free bytes needed
+ */
+void CC2500_SetTXRoom(int room);
+
+#define CC2500_ADR_CHK_NONE 0x00	/*!< Receive every packet */
+#define CC2500_ADR_CHK_BROADCAST 0x02	/*!< Receive packets to this address and to address 0 */
+
+/*!
+ Set the address of this board. Every payload starts with an address byte, the destination or, with
+ CC2500_ADR_CHK_NONE on the receiver, whatever the sender puts there. The radio must be idle.
+ @param[in] address The address, ADDR
+ @param[in] check CC2500_ADR_CHK_NONE or CC2500_ADR_CHK_BROADCAST
+ */
+void CC2500_SetAddress(uint8_t address, uint8_t check);
+
 #define DUMMY_BYTE 												0x00
 #define FIFO_SIZE 64
 
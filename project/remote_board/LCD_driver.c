@@ -2,76 +2,132 @@
 
 // Private method definitions
 void LCD_GPIO_setup(void);
-void printToAddress(char* string, int length, uint8_t address);
+void LCD_refresh(void);
 void send(char data, int type);
-void delay(void);
+void LCD_delay_us(uint32_t us);
+void LCD_delay_ns(uint32_t ns);
 
-// Mutex to prevent conflicting singals
-// being sent to the LCD (i.e. start sending data, send command halfway through)
-osMutexDef (MutexLCD);
-osMutexId Mutex_LCD_id;
+// Not described by this version of core_cm4.h
+#define DWT_CTRL	(*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT	(*((volatile uint32_t *)0xE0001004))
+#define DWT_CTRL_CYCCNTENA	0x00000001
+
+// Both halves of BSRR as one register: the low half sets pins, the high half resets them
+#define LCD_BSRR (*(volatile uint32_t *)&LCD_GPIO_BANK->BSRRL)
+
+// The data lines are consecutive pins, so a byte only needs a shift to land on them
+// (fails to compile otherwise)
+typedef char LCD_data_lines_consecutive[(LCD_DATA_1 == LCD_DATA_0 << 1 && LCD_DATA_7 == LCD_DATA_0 << 7)? 1: -1];
+
+// Frame buffer: threads only write "frame", the refresh thread copies the differences
+// to the display and keeps "glass" equal to what the display shows.
+// Each character is a single byte store, so writers never need a lock; a refresh that
+// overlaps a write is followed by another one because every write signals the refresher.
+static volatile char frame[LCD_ROWS][LCD_COLS];
+static char glass[LCD_ROWS][LCD_COLS];
+
+// Software cursor used by printLCDCharKeypad, and the display mode/shift commands still to be sent
+static volatile int cursorRow = 0;
+static volatile int cursorCol = 0;
+static volatile uint8_t displayMode = displayOn;
+static uint8_t glassDisplayMode = displayOn;
+static volatile int requestedShifts = 0;
+static int sentShifts = 0;
+
+void LCD_refresh_thread(void const *argument);
+osThreadDef(LCD_refresh_thread, osPriorityLow, 1, 0);
+osThreadId tid_LCD_refresh;
+
+// Wake the refresh thread, costs a few microseconds on the calling thread
+static void LCD_request_refresh(void) {
+    osSignalSet(tid_LCD_refresh, LCD_REFRESH_SIGNAL);
+}
 
 // Perform initial LCD configuration, such as GPIO commands
 void LCD_configure(void) {
     LCD_GPIO_setup();
+    
+    // Start the cycle counter used by LCD_delay_us, without clearing it for other users
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
 	
 	// Wait for LCD to boot up if it just turned on
     osDelay(400);
-	// Create Mutex
-    Mutex_LCD_id = osMutexCreate(osMutex(MutexLCD));
 	
     // Send initial setup commands to the display, such as enabling the second row,
     // ensuring the display is on, clearing it and resetting the cursor.
     send(functionSet, CMD);
     send(displayOn, CMD);
     send(displayCursorHome, CMD);
-    clearLCD(); 
+    // Home and clear must wait 1.5 ms...approx to 2
+    osDelay(2);
+    send(clearDisplay, CMD);
+    osDelay(2);
     
+    // A cleared display shows spaces
+    memset(glass, ' ', sizeof(glass));
+    memset((char *)frame, ' ', sizeof(frame));
+    
+    tid_LCD_refresh = osThreadCreate(osThread(LCD_refresh_thread), NULL);
+}
+
+// Low priority thread: push the changed characters to the display whenever the frame changes
+void LCD_refresh_thread(void const *argument) {
+    while (1) {
+        osSignalWait(LCD_REFRESH_SIGNAL, osWaitForever);
+        LCD_refresh();
+    }
 }
 
 // Print a string to the LCD, starting at the beginning of a specified row
 // Rows start from 1; only 2 rows
 // Length limited to 24 characters
-// NOTE: time to execute is approx. 1msec/character in string + 1 msec
+// NOTE: only updates the frame buffer, takes microseconds; the display follows within ~41 usec/character
 void printLCDString(char* string, int row) {
     printLCDToPos(string, row, 1);
 }
 
+// Print one character at the cursor and move the cursor right, wrapping to the next row
 void printLCDCharKeypad(char character) {
-  osMutexWait(Mutex_LCD_id, osWaitForever);
-  send(character, ASCII);
-  osMutexRelease(Mutex_LCD_id);
+    int row = cursorRow;
+    int col = cursorCol;
+    
+    frame[row][col] = character;
+    if (++col == LCD_COLS) {
+        col = 0;
+        row = (row + 1) % LCD_ROWS;
+    }
+    cursorRow = row;
+    cursorCol = col;
+    LCD_request_refresh();
 }
 
 void resetLCDPosition() {
-  osMutexWait(Mutex_LCD_id, osWaitForever);
-  send(displayCursorHome, CMD);
-  osMutexRelease(Mutex_LCD_id);
+    cursorRow = 0;
+    cursorCol = 0;
+    LCD_request_refresh();
 }
 
 void enableCursor() {
-  osMutexWait(Mutex_LCD_id, osWaitForever);
-  send(displayOn_CursorOn, CMD);
-  osMutexRelease(Mutex_LCD_id);
+    displayMode = displayOn_CursorOn;
+    LCD_request_refresh();
 }
 
 void disableCursor() {
-  osMutexWait(Mutex_LCD_id, osWaitForever);
-  send(displayOn, CMD);
-  osMutexRelease(Mutex_LCD_id);
+    displayMode = displayOn;
+    LCD_request_refresh();
 }
 
 void shiftRight() {
-  osMutexWait(Mutex_LCD_id, osWaitForever);
-  send(rightShift, CMD);
-  osMutexRelease(Mutex_LCD_id);
+    requestedShifts++;
+    LCD_request_refresh();
 }
 
 
 // Print a string to the LCD starting at a given row/column
 // Rows and columns start from 1; 2 rows, 24 columns
 // Length limited to 24 characters
-// NOTE: time to execute is approx. 1msec/character in string + 1 msec
+// NOTE: only updates the frame buffer, takes microseconds; the display follows within ~41 usec/character
 void printLCDToPos(char* string, int row, int col) {
 	int length = strlen(string);
     
@@ -94,38 +150,62 @@ void printLCDToPos(char* string, int row, int col) {
     if ((col > 16) && (length > 8)) {
         length = 8;
     }
+    // The frame buffer holds the visible columns only
+    if (col - 1 + length > LCD_COLS) {
+        length = LCD_COLS - (col - 1);
+    }
 
-    // Use printToAddress, with calculations:
-    // Addresses start from 0, columns from 1
-    // Address starts from 0: row 1, col 1.  Columns in increasing order, max visible is col 24
-    // Addresses are in decimal, although when accessing row 2, the addresses start at BCD 40 = 0x40
-    printToAddress(string, length, (col-1) + (row-1)*0x40);
-
+    // Only the frame buffer is written here, the refresh thread updates the display
+    for (int i = 0; i < length; i++) {
+        frame[row-1][col-1+i] = string[i];
+    }
+    LCD_request_refresh();
 }
 
 // Clears the LCD screen
-// NOTE: Time to execute is approx. 1 msec
+// Only blanks the frame buffer, the refresh thread overwrites the characters shown
 void clearLCD() {
-    osMutexWait(Mutex_LCD_id, osWaitForever);
-    send(clearDisplay, CMD);
-		// Must wait 1.5 ms...approx to 2
-		osDelay(2);
-    osMutexRelease(Mutex_LCD_id);
+    memset((char *)frame, ' ', sizeof(frame));
+    LCD_request_refresh();
 }
 
-// Private method: print a string to a position using the LCD's address format spec
-void printToAddress(char* string, int length, uint8_t address) {
-    osMutexWait(Mutex_LCD_id, osWaitForever);
-    // Address commands have a 1 in the 8th bit (MSB), followed by the address -> OR with 0x80
-    // This sets the cursor to that position
-    send(0x80 | address, CMD);
+// Private method: send every character that differs from the display, then the cursor position
+// Each character takes one send (~41 usec), plus an address command whenever the
+// changed characters are not contiguous
+void LCD_refresh() {
+    int row, col;
+    int address = -1;
+    char c;
     
-    // Send string one char at a time
-    for (int i = 0; i < length; i++) {
-        send(string[i], ASCII);
+    if (displayMode != glassDisplayMode) {
+        glassDisplayMode = displayMode;
+        send(glassDisplayMode, CMD);
+    }
+    while (sentShifts != requestedShifts) {
+        sentShifts++;
+        send(rightShift, CMD);
     }
     
-    osMutexRelease(Mutex_LCD_id);
+    for (row = 0; row < LCD_ROWS; row++) {
+        for (col = 0; col < LCD_COLS; col++) {
+            c = frame[row][col];
+            if (c == glass[row][col]) {
+                continue;
+            }
+            // Address commands have a 1 in the 8th bit (MSB), row 2 starts at 0x40
+            if (address != col + row*0x40) {
+                address = col + row*0x40;
+                send(0x80 | address, CMD);
+            }
+            send(c, ASCII);
+            glass[row][col] = c;
+            // The display moves to the next address after each character
+            address++;
+        }
+    }
+    
+    // Leave the display address on the cursor so a visible cursor is in the right place
+    send(0x80 | (cursorCol + cursorRow*0x40), CMD);
 }
 
 // Private method: send a command (with bits specified by the char)
@@ -135,36 +215,49 @@ void printToAddress(char* string, int length, uint8_t address) {
 // See Generic Keypad and LCD Tutorial, p.2
 // For chracters, each new character is written in sequence after the old one, unless commands
 // are sent to explicitely override said functionality
+// NOTE: takes LCD_SETUP_NS + LCD_ENABLE_US + LCD_EXEC_US, about 41 usec
 void send(char data, int type) {
-    // Place command/data on data lines, one bit at a time
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_0, (BitAction)(data & BIT1));
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_1, (BitAction)(data & BIT2));
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_2, (BitAction)(data & BIT3));
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_3, (BitAction)(data & BIT4));
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_4, (BitAction)(data & BIT5));
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_5, (BitAction)(data & BIT6));
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_6, (BitAction)(data & BIT7));
-    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_7, (BitAction)(data & BIT8));
-  
-    // Command
+    uint32_t set = (uint32_t)(uint8_t)data * LCD_DATA_0;
+    uint32_t reset = (~set & LCD_DATA_MASK) | LCD_RW | LCD_EN;
+    
+    // Command mode has REG_SEL = 0, ASCII write has REG_SEL = 1
     if (type == CMD) {
-        // Command mode has REG_SEL = 0, Read/Write = 0, Enable 0
-      GPIO_ResetBits(LCD_GPIO_BANK, LCD_REG_SEL | LCD_RW | LCD_EN);
+        reset |= LCD_REG_SEL;
     }
-    // Data
     else {
-      // ASCII write has REG_SEL = 1, Read/Write = 0, Enable 0
-      GPIO_ResetBits(LCD_GPIO_BANK, LCD_RW | LCD_EN);
-      GPIO_SetBits(LCD_GPIO_BANK, LCD_REG_SEL);
+        set |= LCD_REG_SEL;
     }
     
+    // All data lines, REG_SEL, Read/Write = 0 and Enable = 0 in one write
+    LCD_BSRR = set | (reset << 16);
+    
+    // The lines must be stable for the address setup time before enable rises
+    LCD_delay_ns(LCD_SETUP_NS);
+    
     // Bring enable up/down -> trig on falling edge
-    GPIO_SetBits(LCD_GPIO_BANK, LCD_EN);
-    // Give LCD time to process and reset
-    delay();
-    GPIO_ResetBits(LCD_GPIO_BANK, LCD_EN);
+    LCD_GPIO_BANK->BSRRL = LCD_EN;
+    LCD_delay_us(LCD_ENABLE_US);
+    LCD_GPIO_BANK->BSRRH = LCD_EN;
+    
+    // Give LCD time to execute before the next write
+    LCD_delay_us(LCD_EXEC_US);
 }
 
+// Private method: busy wait for a number of microseconds using the cycle counter
+void LCD_delay_us(uint32_t us) {
+    uint32_t start = DWT_CYCCNT;
+    uint32_t cycles = us * (SystemCoreClock / 1000000);
+    
+    while (DWT_CYCCNT - start < cycles);
+}
+
+// Private method: busy wait for at least a number of nanoseconds using the cycle counter
+void LCD_delay_ns(uint32_t ns) {
+    uint32_t start = DWT_CYCCNT;
+    uint32_t cycles = ns * (SystemCoreClock / 1000000) / 1000 + 1;
+    
+    while (DWT_CYCCNT - start < cycles);
+}
 
 void LCD_GPIO_setup() {
     GPIO_InitTypeDef LCD_GPIO_InitStruct;
@@ -181,10 +274,43 @@ void LCD_GPIO_setup() {
     GPIO_Init(LCD_GPIO_BANK, &LCD_GPIO_InitStruct);
 }
 
-void delay() {
-	int i = 0;
-	while (i < DELAY) {
-		i++;
-	}
+#ifdef BENCHMARK
+// The original bus write: one GPIO_WriteBit per data line and the old 1375 iteration counting loop with enable high
+static void send_gpio(char data, int type) {
+    int i;
+    
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_0, (BitAction)(data & BIT1));
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_1, (BitAction)(data & BIT2));
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_2, (BitAction)(data & BIT3));
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_3, (BitAction)(data & BIT4));
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_4, (BitAction)(data & BIT5));
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_5, (BitAction)(data & BIT6));
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_6, (BitAction)(data & BIT7));
+    GPIO_WriteBit(LCD_GPIO_BANK, LCD_DATA_7, (BitAction)(data & BIT8));
+    if (type == CMD) {
+      GPIO_ResetBits(LCD_GPIO_BANK, LCD_REG_SEL | LCD_RW | LCD_EN);
+    }
+    else {
+      GPIO_ResetBits(LCD_GPIO_BANK, LCD_RW | LCD_EN);
+      GPIO_SetBits(LCD_GPIO_BANK, LCD_REG_SEL);
+    }
+    GPIO_SetBits(LCD_GPIO_BANK, LCD_EN);
+    for (i = 0; i < 1375; i++);
+    GPIO_ResetBits(LCD_GPIO_BANK, LCD_EN);
 }
 
+void LCD_benchmark(Benchmark_report *r) {
+    char c = 'A';
+    
+    // Divide the cycles by 168 for usec per character
+    BENCHMARK_RUN(r, "LCD send GPIO_WriteBit", c = (c == 'Z')? 'A': c + 1, send_gpio(c, ASCII));
+    BENCHMARK_RUN(r, "LCD send BSRR", c = (c == 'Z')? 'A': c + 1, send(c, ASCII));
+    BENCHMARK_RUN(r, "LCD_delay_us(1)", , LCD_delay_us(1));
+    
+    // The characters went to the display behind the frame buffer's back: clear it and redraw
+    send(clearDisplay, CMD);
+    osDelay(2);
+    memset(glass, ' ', sizeof(glass));
+    LCD_request_refresh();
+}
+#endif
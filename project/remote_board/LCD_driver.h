@@ -62,8 +62,26 @@
 #define BIT7 (uint8_t)0x40
 #define BIT8 (uint8_t)0x80
 
-// Number of iterations for short delays
-#define DELAY 1375
+// Address setup time in nsec from RS, R/W and the data lines to the rising enable (min. 40 to 60 nsec)
+#define LCD_SETUP_NS 100
+
+// Bus timing in usec: enable pulse (min. 230 nsec) and execution time of a write (37 usec,
+// clear and home take 1.52 msec and are waited for separately)
+#define LCD_ENABLE_US 1
+#define LCD_EXEC_US 40
+
+// All data lines, data 0 is the lowest pin
+#define LCD_DATA_MASK (LCD_DATA_0 | LCD_DATA_1 | LCD_DATA_2 | LCD_DATA_3 | LCD_DATA_4 | LCD_DATA_5 | LCD_DATA_6 | LCD_DATA_7)
+
+// Visible area held in the frame buffer
+#define LCD_ROWS 2
+#define LCD_COLS 24
+
+// Signal that wakes the refresh thread after the frame buffer changed
+#define LCD_REFRESH_SIGNAL 0x01
+
+// All print, clear and cursor functions only update a frame buffer in RAM and return within microseconds.
+// A low priority refresh thread, started by LCD_configure, sends the changed characters to the display.
 
 void LCD_configure(void);
 void printLCDString(char* string, int row);
@@ -75,4 +93,10 @@ void enableCursor(void);
 void disableCursor(void);
 void shiftRight(void);
 
+#ifdef BENCHMARK
+#include "benchmark.h"
+// Time a character write with the original GPIO_WriteBit bus code and with the BSRR write (cycles in the report)
+void LCD_benchmark(Benchmark_report *r);
+#endif
+
 #endif
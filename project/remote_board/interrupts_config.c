@@ -4,21 +4,19 @@
 
 // Set up (external) interrupt for accelerometer
 void mems_interrupt_config(void);
-// Set up TIM3 interrupt
-void tim3_interrupt_config(void);
 // External interrupt for button
 void button_interrupt_config(void);
 
 // Global variable used to define whether or not NVIC prio. group has already been set
 uint8_t NVIC_PRIORITY_SET = 0;
 
-/* Configure interrupts to work with TIM3, button and MEMS sensor.
+/* Configure interrupts to work with the button and MEMS sensor.
+ * The keypad sets up its own interrupts, see Keypad_configure.
  * Note that the accelerometer must have been already set up. */
 void Interrupts_configure() {
   
   mems_interrupt_config();
   button_interrupt_config();
-  tim3_interrupt_config();
 }
 
 
@@ -63,73 +61,6 @@ void mems_interrupt_config() {
   EXTI_GenerateSWInterrupt(EXTI_Line1);
 }
 
-void tim3_interrupt_config() {
-  
-/* APB1 Max 142 Mhz
- * We know
- * TIM3CLK = 2 * PCLK1  (PCLK1 = APB1 clock -> clock of bus TIM3 is on)
- * There is also the counter clock (CC), output clock and prescaler
- 
- * Prescaler = (TIM3CLK / TIM3 counter clock) - 1
-
- * Output clock period = (TIM3 counter clock / TIM3 output clock) - 1
- 
- * We chose 1Mhz counter clock, 25Hz output clock (desired) -> period = 1MHz/25Hz - 1 = 39999
- * Also keeps prescaler within unsigned 16 bit prescaler limit (65536)
- * 
- * For details about the equations, see Doc ID 018909 Rev 6 and Doc ID 022152 Rev 4
- */
-  
-  // Get bus clock
-  RCC_ClocksTypeDef clock_data;
-  RCC_GetClocksFreq(&clock_data);
-  
-	TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStruct;
-	
-	// Enable clock to TIM3
-	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
-	
-	// Prescaler set dynamically based on Clock Freq, useful if we change it later
-  // According to Doc 018909 rev 6 (p. 627), sec 18.4.11:
-  // Counter clock frequency CK_CNT = fCK_PSC / (PSC[15:0] + 1).
-  // Hence, we must subtract 1 so that our prescaler value is simply fCK_PSC / PSC[15:0]
-	uint16_t PrescalerValue                   = (uint16_t)((2*clock_data.PCLK1_Frequency)/1000000) - 1;
-  
-	TIM_TimeBaseInitStruct.TIM_Period         = PERIOD;
-  TIM_TimeBaseInitStruct.TIM_Prescaler      = PrescalerValue;
-  
-	/* No need to further divide the clock in our case */   
-  TIM_TimeBaseInitStruct.TIM_ClockDivision  = 0;
-  TIM_TimeBaseInitStruct.TIM_CounterMode    = TIM_CounterMode_Up;
-	/* Note: TIM_RepetitionCounter does not apply to TIM3 */
-	
-	/* Send struct to be processed */
-	TIM_TimeBaseInit(TIM3, &TIM_TimeBaseInitStruct);
-	
-	/* Enable the period preload just in case */
-	TIM_ARRPreloadConfig(TIM3, ENABLE);
-  
-  // NVIC config
-  set_nvic_priority();
-  NVIC_InitTypeDef NVIC_InitStruct;
-  // Use TIM3 interrupt
-  NVIC_InitStruct.NVIC_IRQChannel = TIM3_IRQn;
-  // Priority settings. Give 5 .. below accelerometer
-  NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 5;
-  // Don't really need sub priority
-  NVIC_InitStruct.NVIC_IRQChannelSubPriority = 0;
-  // Enable it
-  NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
-  NVIC_Init(&NVIC_InitStruct);
-  
-  // Now tell the timer to enable interrupts
-  TIM_ITConfig(TIM3, TIM_IT_Update, ENABLE);
-  
-	/* Enable counter -> start */
-	TIM_Cmd(TIM3, ENABLE);
-}
-
-
 void button_interrupt_config() {
   
   // Enable SYSCFG, GPIOA for button
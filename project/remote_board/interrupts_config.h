@@ -11,9 +11,6 @@
 // Timer for interrupt generation at specified interval
 #include "stm32f4xx_tim.h"
 
-// TIM3 Period.  See comments in .c file
-#define PERIOD 39999
-
 void Interrupts_configure(void);
 
 // Set NVIC priority group, but only if not already set
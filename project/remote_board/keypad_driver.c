@@ -1,127 +1,271 @@
 #include "keypad_driver.h"
 
+#include "interrupts_config.h"
+
 void Keypad_GPIO_setup(void);
-void Keypad_Reverse_GPIO(void);
+void Keypad_EXTI_setup(void);
+void Keypad_timer_setup(void);
+void Keypad_idle(void);
+
+// Key characters by index: row * 4 + column
+static const char keys[16] = {
+    '1', '2', '3', 'A',
+    '4', '5', '6', 'B',
+    '7', '8', '9', 'C',
+    '*', '0', '#', 'D'
+};
+
+// Rows in scan order, and column pins in column order
+static const uint16_t rows[4] = {KEYPAD_PIN_5, KEYPAD_PIN_6, KEYPAD_PIN_7, KEYPAD_PIN_8};
+static const uint16_t cols[4] = {KEYPAD_PIN_1, KEYPAD_PIN_2, KEYPAD_PIN_3, KEYPAD_PIN_4};
+
+// MODER bits of all rows, and the bits that make only one row an output (the others inputs)
+static uint32_t rowModeMask = 0;
+static uint32_t rowModes[4];
+
+// Debounced key states (one bit per key) and the number of scans each key has differed from it
+static uint16_t stable = 0;
+static uint8_t count[16];
+
+// Single producer (scan interrupt), single consumer (thread) queue: head is only written
+// by the producer and tail only by the consumer, so neither side needs a lock
+static Keypad_event queue[KEYPAD_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static uint32_t overflows = 0;
+
+static osThreadId keypadThread;
+static int32_t keypadSignal;
+
+void Keypad_configure(osThreadId thread, int32_t signal) {
+    keypadThread = thread;
+    keypadSignal = signal;
 
-void Keypad_configure() {
     Keypad_GPIO_setup();
+    Keypad_timer_setup();
+    Keypad_EXTI_setup();
+    Keypad_idle();
 }
 
 void Keypad_GPIO_setup() {
     GPIO_InitTypeDef Keypad_Row_GPIO_InitStruct, Keypad_Col_GPIO_InitStruct;
-    
+    int row, pin;
+
     RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOD, ENABLE);
-    
+
     Keypad_Col_GPIO_InitStruct.GPIO_Pin = KEYPAD_COL;
     Keypad_Col_GPIO_InitStruct.GPIO_Mode = GPIO_Mode_IN;
     Keypad_Col_GPIO_InitStruct.GPIO_OType = GPIO_OType_PP;
     Keypad_Col_GPIO_InitStruct.GPIO_PuPd = GPIO_PuPd_DOWN;
-    
+
     GPIO_Init(KEYPAD_GPIO_BANK, &Keypad_Col_GPIO_InitStruct);
 
+    // Rows always output high: a scan leaves all but one of them floating as inputs, so two
+    // keys down in one column never short a driven high row to a driven low one
     Keypad_Row_GPIO_InitStruct.GPIO_Pin = KEYPAD_ROW;
     Keypad_Row_GPIO_InitStruct.GPIO_Mode = GPIO_Mode_OUT;
     Keypad_Row_GPIO_InitStruct.GPIO_OType = GPIO_OType_PP;
+    Keypad_Row_GPIO_InitStruct.GPIO_Speed = GPIO_Speed_2MHz;
     Keypad_Row_GPIO_InitStruct.GPIO_PuPd = GPIO_PuPd_NOPULL;
-    
+
     GPIO_Init(KEYPAD_GPIO_BANK, &Keypad_Row_GPIO_InitStruct);
-  
     GPIO_SetBits(KEYPAD_GPIO_BANK, KEYPAD_ROW);
+
+    // Two MODER bits per pin
+    for (row = 0; row < 4; row++) {
+        for (pin = 0; (rows[row] >> pin) != 1; pin++);
+        rowModeMask |= 3u << (pin*2);
+        rowModes[row] = (uint32_t)GPIO_Mode_OUT << (pin*2);
+    }
+}
+
+void Keypad_EXTI_setup() {
+    EXTI_InitTypeDef EXTI_InitStruct;
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+    SYSCFG_EXTILineConfig(EXTI_PortSourceGPIOD, EXTI_PinSource2);
+    SYSCFG_EXTILineConfig(EXTI_PortSourceGPIOD, EXTI_PinSource3);
+    SYSCFG_EXTILineConfig(EXTI_PortSourceGPIOD, EXTI_PinSource6);
+    SYSCFG_EXTILineConfig(EXTI_PortSourceGPIOD, EXTI_PinSource7);
+
+    // A press pulls a column up to the (high) rows -> rising edge
+    EXTI_InitStruct.EXTI_Line = KEYPAD_EXTI_LINES;
+    EXTI_InitStruct.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStruct.EXTI_Trigger = EXTI_Trigger_Rising;
+    EXTI_InitStruct.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStruct);
+
+    // Same priority as the scan timer so a wake never interrupts a scan
+    set_nvic_priority();
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 5;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStruct.NVIC_IRQChannel = EXTI2_IRQn;
+    NVIC_Init(&NVIC_InitStruct);
+    NVIC_InitStruct.NVIC_IRQChannel = EXTI3_IRQn;
+    NVIC_Init(&NVIC_InitStruct);
+    NVIC_InitStruct.NVIC_IRQChannel = EXTI9_5_IRQn;
+    NVIC_Init(&NVIC_InitStruct);
 }
 
-void Keypad_Reverse_GPIO() {
-  GPIO_InitTypeDef Keypad_Row_GPIO_InitStruct, Keypad_Col_GPIO_InitStruct;
-  
-	Keypad_Row_GPIO_InitStruct.GPIO_Pin = KEYPAD_ROW;
-  Keypad_Row_GPIO_InitStruct.GPIO_Mode = GPIO_Mode_IN;
-  Keypad_Row_GPIO_InitStruct.GPIO_OType = GPIO_OType_PP;
-  Keypad_Row_GPIO_InitStruct.GPIO_PuPd = GPIO_PuPd_DOWN;
-  GPIO_Init(KEYPAD_GPIO_BANK, &Keypad_Row_GPIO_InitStruct);
-	
-  Keypad_Col_GPIO_InitStruct.GPIO_Pin = KEYPAD_COL;
-  Keypad_Col_GPIO_InitStruct.GPIO_Mode = GPIO_Mode_OUT;
-  Keypad_Col_GPIO_InitStruct.GPIO_OType = GPIO_OType_PP;
-  Keypad_Col_GPIO_InitStruct.GPIO_PuPd = GPIO_PuPd_NOPULL;
-  GPIO_Init(KEYPAD_GPIO_BANK, &Keypad_Col_GPIO_InitStruct);
-  
-  GPIO_SetBits(KEYPAD_GPIO_BANK, KEYPAD_COL);
-  
-}
-
-
-char Keypad_Get_Character(uint32_t data) {  
-	int col = 0;
-  // Figure out column
-  if ((data & KEYPAD_PIN_1) == KEYPAD_PIN_1) {
-    col = 1;
-  }
-  else if ((data & KEYPAD_PIN_2) == KEYPAD_PIN_2) {
-    col = 2;
-  }
-  else if ((data & KEYPAD_PIN_3) == KEYPAD_PIN_3) {
-    col = 3;
-  }
-  else if ((data & KEYPAD_PIN_4) == KEYPAD_PIN_4) {
-    col = 4;
-  }
-	
-	data = data >> 16;
-	int row = 0;
-  // Figure out row
-  if ((data & KEYPAD_PIN_5) == KEYPAD_PIN_5) {
-    row = 1;
-  }
-  else if ((data & KEYPAD_PIN_6) == KEYPAD_PIN_6) {
-    row = 2;
-  }
-  else if ((data & KEYPAD_PIN_7) == KEYPAD_PIN_7) {
-    row = 3;
-  }
-  else if ((data & KEYPAD_PIN_8) == KEYPAD_PIN_8) {
-    row = 4;
-  }
-
-  char key = 0;
-  
-    if (row == 1) {
-        if (col == 1) key = '1';
-        else if (col == 2) key = '2';
-        else if (col == 3) key = '3';
-        else if (col == 4) key = 'A';
+void Keypad_timer_setup() {
+    RCC_ClocksTypeDef clock_data;
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStruct;
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    RCC_GetClocksFreq(&clock_data);
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
+
+    /* TIM3CLK = 2 * PCLK1, prescaled to a 1 MHz counter clock so the period is in usec.
+     * Counter clock = TIM3CLK / (PSC + 1), see Doc ID 018909 Rev 6 sec 18.4.11 */
+    TIM_TimeBaseInitStruct.TIM_Period         = KEYPAD_SCAN_PERIOD - 1;
+    TIM_TimeBaseInitStruct.TIM_Prescaler      = (uint16_t)((2*clock_data.PCLK1_Frequency)/1000000) - 1;
+    TIM_TimeBaseInitStruct.TIM_ClockDivision  = 0;
+    TIM_TimeBaseInitStruct.TIM_CounterMode    = TIM_CounterMode_Up;
+    TIM_TimeBaseInit(TIM3, &TIM_TimeBaseInitStruct);
+    TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+    TIM_ITConfig(TIM3, TIM_IT_Update, ENABLE);
+
+    set_nvic_priority();
+    NVIC_InitStruct.NVIC_IRQChannel = TIM3_IRQn;
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 5;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStruct);
+
+    // The timer only runs while a key is down
+}
+
+// Private method: make every row an output again, all of them high
+static void Keypad_drive_rows() {
+    uint32_t modes = 0;
+    int row;
+
+    for (row = 0; row < 4; row++) {
+        modes |= rowModes[row];
     }
-    else if (row == 2) {
-        if (col == 1) key = '4';
-        else if (col == 2) key = '5';
-        else if (col == 3) key = '6';
-        else if (col == 4) key = 'B';
+    KEYPAD_GPIO_BANK->MODER = (KEYPAD_GPIO_BANK->MODER & ~rowModeMask) | modes;
+}
+
+// Private method: stop scanning and wait for a column interrupt with all rows high
+void Keypad_idle() {
+    TIM_Cmd(TIM3, DISABLE);
+    Keypad_drive_rows();
+    EXTI_ClearITPendingBit(KEYPAD_EXTI_LINES);
+    EXTI->IMR |= KEYPAD_EXTI_LINES;
+
+    // A press between the last scan and now gave no edge: scan right away
+    if (GPIO_ReadInputData(KEYPAD_GPIO_BANK) & KEYPAD_COL) {
+        EXTI->IMR &= ~KEYPAD_EXTI_LINES;
+        TIM_SetCounter(TIM3, 0);
+        TIM_Cmd(TIM3, ENABLE);
     }
-    else if (row == 3) {
-        if (col == 1) key = '7';
-        else if (col == 2) key = '8';
-        else if (col == 3) key = '9';
-        else if (col == 4) key = 'C';
+}
+
+// Private method: a column went high, mask the column interrupts and start the scan timer
+static void Keypad_wake() {
+    EXTI->IMR &= ~KEYPAD_EXTI_LINES;
+    EXTI_ClearITPendingBit(KEYPAD_EXTI_LINES);
+    TIM_SetCounter(TIM3, 0);
+    TIM_Cmd(TIM3, ENABLE);
+}
+
+// Private method: append an event, dropped if the queue is full
+static void Keypad_put_event(Keypad_event event) {
+    uint8_t next = (head + 1) & (KEYPAD_QUEUE_SIZE - 1);
+
+    if (next == tail) {
+        overflows++;
+        return;
     }
-    else if (row == 4) {
-        if (col == 1) key = '*';
-        else if (col == 2) key = '0';
-        else if (col == 3) key = '#';
-        else if (col == 4) key = 'D';
+    queue[head] = event;
+    head = next;
+}
+
+void Keypad_scan() {
+    uint16_t raw = 0;
+    uint16_t changed;
+    uint32_t columns;
+    int row, col, key;
+    volatile int settle;
+    int queued = 0;
+
+    // Drive one row high at a time with a single MODER write, the others float as inputs;
+    // every key is read on its own, so any number of keys can be down (n-key rollover, except
+    // ghost keys of a diode-less matrix)
+    for (row = 0; row < 4; row++) {
+        KEYPAD_GPIO_BANK->MODER = (KEYPAD_GPIO_BANK->MODER & ~rowModeMask) | rowModes[row];
+        // Let the pull-downs discharge the columns of the previous row
+        for (settle = 0; settle < 20; settle++);
+        columns = GPIO_ReadInputData(KEYPAD_GPIO_BANK);
+        for (col = 0; col < 4; col++) {
+            if (columns & cols[col]) {
+                raw |= 1 << (row*4 + col);
+            }
+        }
     }
-	
-  return key;
-}
-
-uint32_t Keypad_poll(void) {
-	
-	// Get column data
-	uint32_t data = GPIO_ReadInputData(KEYPAD_GPIO_BANK);
-	
-	Keypad_Reverse_GPIO();
-  
-  // Poll rows for source; get whole register since time is of the essense
-  data |= (GPIO_ReadInputData(KEYPAD_GPIO_BANK) << 16);
-  // Reset GPIO
-  Keypad_GPIO_setup();
-  
-  return data;
+
+    // A key changes state only after KEYPAD_DEBOUNCE_SCANS scans that all disagree with it
+    changed = raw ^ stable;
+    for (key = 0; key < 16; key++) {
+        if ((changed & (1 << key)) == 0) {
+            count[key] = 0;
+        }
+        else if (++count[key] >= KEYPAD_DEBOUNCE_SCANS) {
+            count[key] = 0;
+            stable ^= 1 << key;
+            Keypad_put_event(key | ((stable & (1 << key))? KEYPAD_DOWN: 0));
+            queued = 1;
+        }
+    }
+
+    if (queued) {
+        osSignalSet(keypadThread, keypadSignal);
+    }
+
+    // Everything released and settled: no more scanning until the next press
+    if ((stable == 0) && (raw == 0)) {
+        Keypad_idle();
+    }
+    else {
+        Keypad_drive_rows();
+    }
+}
+
+int Keypad_get_event(Keypad_event *event) {
+    if (tail == head) {
+        return 0;
+    }
+    *event = queue[tail];
+    tail = (tail + 1) & (KEYPAD_QUEUE_SIZE - 1);
+    return 1;
+}
+
+char Keypad_Get_Character(Keypad_event event) {
+    return keys[event & KEYPAD_KEY_MASK];
+}
+
+uint32_t Keypad_overflows() {
+    return overflows;
+}
+
+// Column 1 and 2
+void EXTI2_IRQHandler() {
+    Keypad_wake();
+}
+
+void EXTI3_IRQHandler() {
+    Keypad_wake();
+}
+
+// Column 3 and 4 (lines 6 and 7, no other line of 5 to 9 is used)
+void EXTI9_5_IRQHandler() {
+    Keypad_wake();
+}
+
+// Scan timer, only running while a key is down
+void TIM3_IRQHandler() {
+    TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+    Keypad_scan();
 }
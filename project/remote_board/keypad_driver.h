@@ -2,7 +2,7 @@
 #define _KEYPAD_DRIVER_H_
 
 #include "stm32f4xx_conf.h"
-#include "LCD_driver.h"
+#include "cmsis_os.h"
 
 
 /* Keypad pin mapping (GPIO Pins <-> Keypad pins)
@@ -16,7 +16,7 @@
  *   PD3  = Pin 2
  *   PD6  = Pin 3
  *   PD7  = Pin 4
- */ 
+ */
 #define KEYPAD_GPIO_BANK GPIOD
 // Columns
 #define KEYPAD_PIN_1 GPIO_Pin_2
@@ -29,11 +29,37 @@
 #define KEYPAD_PIN_7 GPIO_Pin_10
 #define KEYPAD_PIN_8 GPIO_Pin_11
 
-#define KEYPAD_COL KEYPAD_PIN_1 | KEYPAD_PIN_2 | KEYPAD_PIN_3 | KEYPAD_PIN_4
-#define KEYPAD_ROW KEYPAD_PIN_5 | KEYPAD_PIN_6 | KEYPAD_PIN_7 | KEYPAD_PIN_8
+#define KEYPAD_COL (KEYPAD_PIN_1 | KEYPAD_PIN_2 | KEYPAD_PIN_3 | KEYPAD_PIN_4)
+#define KEYPAD_ROW (KEYPAD_PIN_5 | KEYPAD_PIN_6 | KEYPAD_PIN_7 | KEYPAD_PIN_8)
 
-void Keypad_configure(void);
-uint32_t Keypad_poll(void);
-char Keypad_Get_Character(uint32_t data);
+// Column lines wake the scanner through EXTI; rows are driven high while idle
+#define KEYPAD_EXTI_LINES (EXTI_Line2 | EXTI_Line3 | EXTI_Line6 | EXTI_Line7)
+
+// Scan period while a key is down (TIM3, in usec) and the number of equal scans
+// before a key changes state: 4 * 5 msec = 20 msec of debounce
+#define KEYPAD_SCAN_PERIOD 5000
+#define KEYPAD_DEBOUNCE_SCANS 4
+
+// Size of the event queue between the scan interrupt and the thread, a power of 2
+#define KEYPAD_QUEUE_SIZE 16
+
+// An event is the key index (row * 4 + column) in the low bits and KEYPAD_DOWN for a press
+#define KEYPAD_DOWN 0x80
+#define KEYPAD_KEY_MASK 0x0F
+
+typedef uint8_t Keypad_event;
+
+// Configure the pins, the column interrupts and the scan timer.
+// "signal" is set on "thread" whenever events are queued.
+void Keypad_configure(osThreadId thread, int32_t signal);
+// Take the oldest event. Returns 1 if there was one, 0 if the queue is empty.
+// Only one thread may take events.
+int Keypad_get_event(Keypad_event *event);
+// Character printed on a key ('0'-'9', 'A'-'D', '*', '#')
+char Keypad_Get_Character(Keypad_event event);
+// Number of events lost because the queue was full
+uint32_t Keypad_overflows(void);
+// Scan the matrix once and queue debounced changes. Runs in the TIM3 interrupt.
+void Keypad_scan(void);
 
 #endif
@@ -11,11 +11,40 @@
 #include "filter.h"
 #include "wireless_cc2500.h"
 #include "keypad_driver.h"
+#include "waypoint_program.h"
+#include "waypoint_store.h"
+#include "orientation_capture.h"
 #include "interrupts_config.h"
+#include "slab.h"
+#include "state_broadcast.h"
+#include "orientation_link.h"
+#include "tdma.h"
+#include "hr_timer.h"
+#ifdef BENCHMARK
+#include "benchmark.h"
+#endif
+#if (defined(OS_MONITOR) && (OS_MONITOR != 0)) || (defined(OS_TELEMETRY) && (OS_TELEMETRY != 0))
+#include "thread_monitor.h"
 
+osThreadDef(monitor_thread, osPriorityLow, 1, MONITOR_STACK_SIZE);
+#endif
 
-#define WIRELESS_MESSAGE_QUEUE_SIZE 1000
-#define KEYPAD_QUEUE_SIZE 10
+
+#define WIRELESS_MESSAGE_QUEUE_SIZE 64	/*!< Messages come from the slab allocator, must fit in SLAB_BLOCKS_4 */
+#define WIRELESS_BATCH_SIZE 8	/*!< Messages written to the radio in one burst, fits the base board RX FIFO (8 bytes each) */
+#define WIRELESS_BURST_GAP 10	/*!< ms after a full burst, one base board poll period to empty its RX FIFO */
+#define WIRELESS_KEEPALIVE 500	/*!< ms without a message before a keepalive is sent, so the base board can find a lost profile */
+#define WIRELESS_SWITCH_REPEAT 3	/*!< Copies of a profile switch sent before following it */
+#define WIRELESS_WAKE_GAP 2	/*!< ms after the packet that wakes the base board, while it leaves wake-on-radio */
+#define WIRELESS_QUANTUM 1	/*!< Round-robin ticks of the wireless thread, short so its radio state polling (CC2500_Enter) cannot delay sampling */
+#define KEYPAD_QUANTUM 1	/*!< Round-robin ticks of the keypad thread, short so its LCD busy waits cannot delay sampling (host/quantum_sim.c) */
+#define WIRELESS_TELEMETRY_PERIOD 250	/*!< ms between telemetry requests while sending, idle requests double as keepalives */
+#define WIRELESS_TELEMETRY_WAIT 12	/*!< ms listened for telemetry on top of the base board delay: one base board poll and its SPI reads */
+#define WIRELESS_TDMA_MCSM1 0x3f	/*!< With TDMA the radio returns to RX after sending, for the next beacon */
+
+#ifndef REMOTE_ADDRESS
+#define REMOTE_ADDRESS 1	/*!< Address of this board, 1 to 255, sent in every packet; with TDMA each remote board needs its own */
+#endif
 
 #define ANGLE_FILTER_DEPTH 16	/*!< Filter depth for angle filters */
 #define GRAV_ACC 1000.0f	/*!< Value of g */
@@ -25,7 +54,15 @@
 #define SENSOR_Z_OFFSET -64	/*!< Z offset from calibration (expected 1000)*/
 
 #define ACCELERATON_FLAG	0x01	/*!< Acceleration signaling flag */
-#define KEYPAD_FLAG	0x02
+#define KEYPAD_FLAG	0x02	/*!< Keypad event signaling flag */
+#define MODE_FLAG	0x04	/*!< Mode change signaling flag */
+#define BEACON_FLAG	0x01	/*!< TDMA packet received signaling flag, for the wireless thread */
+#define SLOT_FLAG	0x02	/*!< TDMA slot start signaling flag, for the wireless thread */
+#define RADIO_FLAG	0x04	/*!< TX FIFO room or end of packet signaling flag (GDO2, GDO0), for the wireless thread */
+#define TELEMETRY_FLAG	0x08	/*!< Telemetry received signaling flag, for the keypad thread */
+
+#define SAMPLE_PERIOD 10	/*!< Accelerometer data ready period in msec (100 Hz), one sample per period */
+#define REPLAY_MAX_SPEED 8	/*!< Fastest replay, samples per period; the base board reads at most 8 packets per poll */
 
 static int displayValue = 0;
 static int RXNow = 0;
@@ -36,8 +73,21 @@ typedef enum {
   REALTIME_MODE = 0
 } OPERATION_MODE;
 
-// Mode the board is in; see above
-OPERATION_MODE mode = REALTIME_MODE;
+// Mode the board is in; see above. Read with state_get(&mode), changed by the user button ISR
+State_broadcast mode;
+
+// Recorder of the realtime stream, controlled from the keypad in realtime mode
+typedef enum {
+  RECORDER_IDLE = 0,
+  RECORDER_CAPTURE = 1,
+  RECORDER_REPLAY = 0x10	// or'ed with the speed, 1 to REPLAY_MAX_SPEED
+} RECORDER_MODE;
+
+// Written by the keypad thread, and by the orientation thread when a capture or replay ends
+State_broadcast recorder;
+
+// Radio profile (CC2500_Rate) wanted by the user, applied by the wireless thread after telling the base board
+State_broadcast radioProfile;
 
 typedef struct {                               
 	int8_t rollAngle;
@@ -46,41 +96,56 @@ typedef struct {
 	int8_t realtime;						// is it realtime mode or not
 } Wireless_message;
 
-typedef struct {
-  uint32_t EXTI_Line;
-  uint16_t row_data;
-}Keypad_data;
+// Waypoints typed on the keypad, kept until 'B' sends them
+static Waypoint_program program;
+
+// Transmit policy of the realtime stream, used by the wireless thread only
+static Link_encoder link;
+
+typedef char remote_address_valid[(REMOTE_ADDRESS >= 1 && REMOTE_ADDRESS <= 255)? 1: -1];
+
+#if TDMA_ENABLE != 0
+typedef char tdma_without_wake_on_radio[(CC2500_WOR_PERIOD == 0)? 1: -1];
+
+// Time the last packet ended (hr_timer_now), written by the EXTI15_10 ISR
+static volatile uint32_t packetEnd;
+
+// Start of the slot of this board, from the end of the beacon
+static HR_timer slotTimer;
+#endif
+
+// Not described by this version of core_cm4.h; the cycle counter is started by CC2500_Init
+#define DWT_CYCCNT	(*((volatile uint32_t *)0xE0001004))
+
+// Last state of the base board, shown on the LCD in realtime mode; guarded by displaySemaphore
+static Link_telemetry telemetry;
+
+// Set while the base board falls behind (LINK_BEHIND): only the newest realtime sample of a burst is sent
+static int throttle = 0;
+
+#if CC2500_WOR_PERIOD != 0
+// Cycle count when the last burst left the radio, the base board stays awake CC2500_WOR_AWAKE after it
+static uint32_t lastTransmit;
+#endif
 
 static Filter rollFilter;
 static Filter pitchFilter;
 static Queue rollBuffer;
 static Queue pitchBuffer;
 
-osPoolDef(wireless_pool, WIRELESS_MESSAGE_QUEUE_SIZE, Wireless_message);                    // Define memory pool queue size 16 for now
-osPoolId wireless_pool;
-
 osMessageQDef(wireless_message_box, WIRELESS_MESSAGE_QUEUE_SIZE, Wireless_message);   //queue size 16 arbitrarily for now (queue should theoretically never get full)
 osMessageQId wireless_message_box;
 
-osPoolDef(keypad_pool, KEYPAD_QUEUE_SIZE, Keypad_data);
-osPoolId keypad_pool;
-
-osMessageQDef(keypad_message_box, KEYPAD_QUEUE_SIZE, Keypad_data);
-osMessageQId keypad_message_box;
-
 void orientation_thread(const void* arg);
 void wireless_thread(const void* arg);
 void keypad_thread(const void* arg);
 
 osThreadDef(orientation_thread, osPriorityNormal, 1, 0);
-osThreadDef(wireless_thread, osPriorityNormal, 1, 0);
-osThreadDef(keypad_thread, osPriorityNormal, 1, 0);
+osThreadDefQuantum(wireless_thread, osPriorityNormal, 1, 0, WIRELESS_QUANTUM);
+osThreadDefQuantum(keypad_thread, osPriorityNormal, 1, 0, KEYPAD_QUANTUM);
 
 osThreadId tid_orientation, tid_wireless, tid_keypad;
 
-osSemaphoreId modeSemaphore;   
-osSemaphoreDef(modeSemaphore);
-
 osSemaphoreId displaySemaphore;   
 osSemaphoreDef(displaySemaphore);
 
@@ -119,8 +184,105 @@ int get_angle(int acc);
  */
 void init_angle_filtering(void);
 
+/*!
+ Send a keypad program to the base board. Returns 0 on success, -1 if there is not enough message memory
+ for the whole program, in which case nothing is sent.
+ @param[in] p The program
+ */
+int send_program(const Waypoint_program *p);
+
 void write_wireless_message(Wireless_message *m);
 
+/*!
+ Write one message as a length-prefixed packet. Realtime messages go through the transmit policy
+ (orientation_link.h). Returns the number of bytes written, 0 if the message was held.
+ @param[in] m The message
+ @param[out] frame Receives the packet, at most 2 + sizeof(Wireless_message) bytes
+ */
+int encode_wireless_message(Wireless_message *m, uint8_t *frame);
+
+/*!
+ Write several messages to the radio FIFO with one SPI burst. Realtime messages go through the
+ transmit policy (orientation_link.h): most are held or sent as small deltas. Returns the number of
+ bytes written, 0 if every message was held.
+ @param[in] m The messages
+ @param[in] count The number of messages, at most WIRELESS_BATCH_SIZE
+ */
+int write_wireless_messages(Wireless_message **m, int count);
+
+/*!
+ Write a control packet to the radio FIFO
+ @param[in] command LINK_KEEPALIVE or LINK_SET_PROFILE
+ @param[in] argument The argument of the command
+ */
+void write_wireless_control(uint8_t command, uint8_t argument);
+
+/*!
+ Announce a new radio profile to the base board, wait until the announcement is on the air and switch.
+ Returns 0 on success, -1 if the radio did not go idle to switch; it then stays on the old profile.
+ @param[in] rate The new profile
+ */
+int switch_profile(CC2500_Rate rate);
+
+/*!
+ Wait until the TX FIFO has room
+ @param[in] numBytes The bytes to be written
+ */
+void wait_tx_fifo(int numBytes);
+
+/*!
+ Wait until everything written to the TX FIFO is on the air
+ */
+void wait_tx_done(void);
+
+/*!
+ With wake-on-radio, wake the base board before a burst if it went back to sleep
+ */
+void wake_base(void);
+
+/*!
+ Send the burst written to the TX FIFO; with wake-on-radio the radio idles once it is on the air
+ */
+void end_burst(void);
+
+/*!
+ Ask the base board for its telemetry and listen for the answer. Returns 0 if it came, -1 otherwise.
+ The radio is back to sending on return.
+ */
+int request_telemetry(void);
+
+/*!
+ Show the last telemetry on the LCD
+ */
+void show_telemetry(void);
+
+#if TDMA_ENABLE != 0
+/*!
+ Send in the TDMA slot given by the base board (tdma.h): one packet per superframe, timed from the
+ end of the beacon. Does not return.
+ */
+void wireless_tdma(void);
+
+/*!
+ Called by the slot timer at the start of the slot
+ */
+void slot_timer_callback(void *arg);
+
+#endif
+
+/*!
+ ISR for external 10 to 15: GDO0 at the end of a packet (with TDMA a received one, or one dropped by the
+ address check), GDO2 once the TX FIFO has the room asked for
+ */
+void EXTI15_10_IRQHandler(void);
+
+#ifdef BENCHMARK
+/*!
+ Time the remote board hot functions and print the JSON report. Runs before the kernel threads start.
+ */
+void run_benchmarks(void);
+#endif
+
 /*!
  @brief Program entry point
  */
@@ -128,13 +290,27 @@ int main (void) {
     LED_GPIO_config();
 	Interrupts_configure();
 	LCD_configure();
+	
+#ifdef BENCHMARK
+	run_benchmarks();
+#endif
 		
 	//init semaphores
-	osSemaphoreCreate(osSemaphore(displaySemaphore), 1);
-	osSemaphoreCreate(osSemaphore(modeSemaphore), 1);
+	displaySemaphore = osSemaphoreCreate(osSemaphore(displaySemaphore), 1);
+	state_init(&mode, REALTIME_MODE);
+	state_init(&recorder, RECORDER_IDLE);
+	state_init(&radioProfile, CC2500_PROFILE);
+	
+	//saved keypad programs, may erase a flash sector the first time
+	waypoint_store_init();
+	
+#if TDMA_ENABLE != 0
+	//slot timing
+	hr_timer_init();
+#endif
 	
 	//init message box and mem pool
-	wireless_pool = osPoolCreate(osPool(wireless_pool));                 // create memory pool
+	slab_init();
     wireless_message_box = osMessageCreate(osMessageQ(wireless_message_box), NULL);  // create msg queue
 	
 	//start threads
@@ -142,7 +318,21 @@ int main (void) {
 	tid_wireless = osThreadCreate(osThread(wireless_thread), NULL);
     tid_keypad = osThreadCreate(osThread(keypad_thread), NULL);
 	
-	Keypad_configure();
+	//the orientation thread sleeps until the mode changes back to realtime
+	state_subscribe(&mode, tid_orientation, MODE_FLAG);
+	//the keypad thread only wakes on key events and mode changes
+	state_subscribe(&mode, tid_keypad, MODE_FLAG);
+	
+#if (defined(OS_MONITOR) && (OS_MONITOR != 0)) || (defined(OS_TELEMETRY) && (OS_TELEMETRY != 0))
+	monitor_add(osThreadGetId(), "main");
+	monitor_add(tid_orientation, "orientation");
+	monitor_add(tid_wireless, "wireless");
+	monitor_add(tid_keypad, "keypad");
+	monitor_add_queue(wireless_message_box, "wireless");
+	osThreadCreate(osThread(monitor_thread), NULL);
+#endif
+	
+	Keypad_configure(tid_keypad, KEYPAD_FLAG);
     
 	// The below doesn't really need to be in a loop
 	while(1){
@@ -162,6 +352,13 @@ void orientation_thread(const void* arg)
 	int acc[] = {0, 0, 0};
 	int calibratedAcc[] = {0, 0, 0};
 	
+	Capture_reader reader;
+	uint32_t batch[REPLAY_MAX_SPEED];
+	uint16_t recorderVersion = state_version(&recorder);
+	int recording = RECORDER_IDLE;
+	int8_t replayRoll, replayPitch;
+	int count;
+	
 	init_angle_filtering();
 	mems_init();
 	
@@ -169,11 +366,13 @@ void orientation_thread(const void* arg)
 	
 	while(1)
 	{
-		osSemaphoreWait(modeSemaphore, osWaitForever);
-		samplingMode = (mode == KEYPAD_MODE)? 0: 1;
-		osSemaphoreRelease(modeSemaphore);
+		samplingMode = (state_get(&mode) == KEYPAD_MODE)? 0: 1;
 		
-		if (samplingMode)
+		if (!samplingMode)
+		{
+			osSignalWait(MODE_FLAG, osWaitForever);
+		}
+		else
 		{
 			osSignalWait(ACCELERATON_FLAG, osWaitForever);
 			
@@ -201,12 +400,62 @@ void orientation_thread(const void* arg)
 			filteredRollAngle = rollFilter.avg;
 			filteredPitchAngle = pitchFilter.avg;
 			
-			wireless_m = osPoolAlloc(wireless_pool);                     // Allocate memory for the message
-			wireless_m->rollAngle = (int)filteredRollAngle;
-			wireless_m->pitchAngle = (int)filteredPitchAngle;
-			wireless_m->delta_t = 0;
-			wireless_m->realtime = 1;
-			osMessagePut(wireless_message_box, (uint32_t)wireless_m, osWaitForever);  // Send Message
+			//New recorder command: open the capture for writing or reading, give up if there is none
+			if (state_version(&recorder) != recorderVersion)
+			{
+				recorderVersion = state_version(&recorder);
+				recording = state_get(&recorder);
+				if ((recording == RECORDER_CAPTURE && capture_start(SAMPLE_PERIOD) != 0) ||
+					((recording & RECORDER_REPLAY) && capture_open(&reader) < 0))
+				{
+					recording = RECORDER_IDLE;
+					state_publish(&recorder, RECORDER_IDLE);
+				}
+			}
+			
+			if (recording & RECORDER_REPLAY)
+			{
+				//Replay in place of the live angles, paced by the accelerometer: speed samples per period
+				count = 0;
+				while (count < (recording & 0x0F) && capture_next(&reader, &replayRoll, &replayPitch) == 0)
+				{
+					wireless_m = slab_alloc(sizeof(Wireless_message));
+					if (wireless_m != NULL)
+					{
+						wireless_m->rollAngle = replayRoll;
+						wireless_m->pitchAngle = replayPitch;
+						wireless_m->delta_t = 0;
+						wireless_m->realtime = 1;
+						batch[count++] = (uint32_t)wireless_m;
+					}
+				}
+				if (count < (recording & 0x0F))
+				{
+					recording = RECORDER_IDLE;
+					state_publish(&recorder, RECORDER_IDLE);
+				}
+				osMessagePutN(wireless_message_box, batch, count, osWaitForever);  // Send Messages
+			}
+			else
+			{
+				wireless_m = slab_alloc(sizeof(Wireless_message));                     // Allocate memory for the message
+				if (wireless_m != NULL)
+				{
+					wireless_m->rollAngle = (int)filteredRollAngle;
+					wireless_m->pitchAngle = (int)filteredPitchAngle;
+					wireless_m->delta_t = 0;
+					wireless_m->realtime = 1;
+					osMessagePut(wireless_message_box, (uint32_t)wireless_m, osWaitForever);  // Send Message
+				}
+				
+				//The capture holds exactly what is sent; stop when the sector is full
+				if (recording == RECORDER_CAPTURE &&
+					capture_add((int8_t)filteredRollAngle, (int8_t)filteredPitchAngle) != 0)
+				{
+					recording = RECORDER_IDLE;
+					state_publish(&recorder, RECORDER_IDLE);
+				}
+			}
 		}
 	}
 }
@@ -216,199 +465,224 @@ void wireless_thread(const void* arg)
 {
 	//init wireless
 	CC2500_Init();
-	CC2500_CmdStrobe(STX);
+	link_encoder_init(&link);
+#if TDMA_ENABLE != 0
+	wireless_tdma();
+#endif
+	CC2500_TXGDIOInterrupts_Config();
+#if CC2500_WOR_PERIOD == 0
+	CC2500_Enter(STX);
+#endif
 	
-	Wireless_message  *wireless_m;
-    osEvent event;
-	
-	int8_t numBytesFIFOBuffer;
+	uint32_t batch[WIRELESS_BATCH_SIZE];
+	uint16_t profileVersion = state_version(&radioProfile);
+	uint16_t version;
+	uint32_t lastTelemetry = DWT_CYCCNT;
+	int telemetryDue;
+	int count;
+	int i;
 	
 	while(1)
 	{
-		CC2500_Read_Reg(&numBytesFIFOBuffer, TXBYTES, 1);
-		numBytesFIFOBuffer = numBytesFIFOBuffer & 0x7f;
+		//everything queued, up to one burst: a keypad program goes out in a few bursts
+		count = osMessageGetN(wireless_message_box, batch, WIRELESS_BATCH_SIZE, WIRELESS_KEEPALIVE);
 		
-		//if fifo buffer is not full, send message else yield
-		if (numBytesFIFOBuffer + sizeof(Wireless_message) + 10 <= FIFO_SIZE)
+		//With wake-on-radio only ask while the base board is awake for a burst
+		telemetryDue = (DWT_CYCCNT - lastTelemetry) / (SystemCoreClock / 1000) >= WIRELESS_TELEMETRY_PERIOD &&
+			(count > 0 || CC2500_WOR_PERIOD == 0);
+		
+		if (state_version(&radioProfile) != profileVersion)
 		{
-			//printf("FIFO SIZE: %d\n", numBytesFIFOBuffer);
-			event = osMessageGet(wireless_message_box, osWaitForever);  // wait for message
-			if (event.status == osEventMessage)
+			//A switch the radio did not make is tried again on the next pass
+			version = state_version(&radioProfile);
+			if (switch_profile((CC2500_Rate)state_get(&radioProfile)) == 0)
 			{
-				wireless_m = event.value.p;
-				
-				//send wireless message
-				//printf("Writing message... pitch: %d roll: %d\n", wireless_m->pitchAngle, wireless_m->rollAngle);
-				write_wireless_message(wireless_m);
-				
-				osPoolFree(wireless_pool, wireless_m);                  // free memory allocated for message
+				profileVersion = version;
 			}
 		}
-		else
+		else if (count == 0 && !telemetryDue)
+		{
+			wake_base();
+			write_wireless_control(LINK_KEEPALIVE, LINK_IDLE);
+			end_burst();
+#if CC2500_WOR_PERIOD != 0
+			//The base board goes back to wake-on-radio on LINK_IDLE: the next burst has to wake it
+			lastTransmit = DWT_CYCCNT - CC2500_WOR_AWAKE * (SystemCoreClock / 1000);
+#endif
+		}
+		
+		if (count > 0)
+		{
+			wait_tx_fifo(count * (2 + sizeof(Wireless_message)));
+			if (write_wireless_messages((Wireless_message **)batch, count) > 0)
+			{
+				end_burst();
+			}
+			for (i = 0; i < count; i++)
+			{
+				slab_free((void *)batch[i]);                  // free memory allocated for message
+			}
+		}
+		if (telemetryDue)
 		{
-			osThreadYield();
+			request_telemetry();
+			lastTelemetry = DWT_CYCCNT;
+		}
+		
+		//more may be queued: let the base board read this burst first
+		if (count == WIRELESS_BATCH_SIZE)
+		{
+			osDelay(WIRELESS_BURST_GAP);
 		}
 	}
 }
 
-//Keypad thread: responsible for keypad input
-/*
- Input format:
-	#/* = positive/negative
-	D - space between variables
-	A - Accept sequence
-	C - Cancel (reset keypad)
-	B - Send to baseboard all sequences
-			that have been accepted\
-
-  Ex. Roll -20, Pitch 30, Time 5 sec
-	#20D*30D5A
-
-	Ex. Roll 5, Pich -2, Time 10
-	*05D#02D10A
-	
-	Press B when done (not in middle of typing)
-
-	Cancel works whenever (clears EVERYTHING)
-	
-	Time is max. 2 digits, pitch and roll are limited as well
-*/
+//Keypad thread: responsible for keypad input, see waypoint_program.h for the input format
 void keypad_thread(const void* arg) {
     enableCursor();
     clearLCD();    
     int samplingMode = 0;
-    Wireless_message wireless[32];
-    Wireless_message *wireless_m;
-    int messageIndex = 0;
-  
-    
-    char prevKeypress = 0;
+    int32_t signals;
+    Keypad_event event;
+    Waypoint_parser parser;
+    char name[WAYPOINT_STORE_NAME_SIZE + 1];
+    // A replayed program, kept apart from the one being typed (static: too big for the thread stack)
+    static Waypoint_program replay;
     
-    int counter = 0;
-    int pitch = 0;
-    int roll = 0;
-    int time = 0;
-    char keypadEntry[24];
+    waypoint_parser_reset(&parser);
+    waypoint_program_clear(&program);
     while(1)
         {   
-            osSignalWait(KEYPAD_FLAG, osWaitForever);
+            // Any signal: key events are queued, the mode changed or telemetry came
+            signals = osSignalWait(0, osWaitForever).value.signals;
             
-          	osSemaphoreWait(modeSemaphore, osWaitForever);
-            samplingMode = (mode == KEYPAD_MODE)? 0: 1;
-            osSemaphoreRelease(modeSemaphore);
+            samplingMode = (state_get(&mode) == KEYPAD_MODE)? 0: 1;
 
             if (!samplingMode) { 
                 turnOnGreenLED();
-                uint32_t data= Keypad_poll();
-                char currKeypress = Keypad_Get_Character(data);
+                if (signals & MODE_FLAG) {
+                    clearLCD();
+                }
                 
-                if (currKeypress != prevKeypress) {
-                    prevKeypress = currKeypress;
-                    
-                    if (currKeypress != 0) {
+                // Only key presses matter, releases are dropped
+                while (Keypad_get_event(&event)) {
+                    if (event & KEYPAD_DOWN) {
+                        char currKeypress = Keypad_Get_Character(event);
                         
-                        keypadEntry[counter] = currKeypress;
-                        counter++;
-                        printLCDCharKeypad(currKeypress);
-                        if (currKeypress == 'A') {
-                            counter = 0;
-                            // Parse string
-                            if (keypadEntry[0] == '*') {
-                                keypadEntry[0] = '-';
-                            }
-                            else {
-                                keypadEntry[0] = ' ';
-                            }
-                            char rollString[3];
-                            memcpy(rollString, keypadEntry, 3);
-                            roll = atoi(rollString);
-                            
-                            if (keypadEntry[4] == '*') {
-                                keypadEntry[4] = '-';
-                            }
-                            else {
-                                keypadEntry[4] = ' ';
-                            }
-                            
-                            char pitchString[3];
-                            memcpy(pitchString, keypadEntry + sizeof(char)*4, 3);
-                            pitch = atoi(pitchString);
-                            
-                            char timeString[2];
-                            memcpy(timeString, keypadEntry + sizeof(char)*8, 2);
-                            time = atoi(timeString);
-                            
-                            clearLCD();
-                            resetLCDPosition();
-                              
-                            memset(keypadEntry, 0, sizeof(keypadEntry));
-                            
-                            wireless_m = osPoolAlloc(wireless_pool);                     // Allocate memory for the message
-                            wireless_m->rollAngle = roll;
-                            wireless_m->pitchAngle = pitch;
-                            wireless_m->delta_t = time;
-                            wireless_m->realtime = 0;
-                            wireless[messageIndex] = *wireless_m;
-                            messageIndex++;
-                            //osMessagePut(wireless_message_box, (uint32_t)wireless_m, osWaitForever);  // Send Message
-                        }
-                        else if (currKeypress == 'B')
-                        {
-                          counter = 0;
-                          memset(keypadEntry, 0, sizeof(keypadEntry));
-                          
-                          Wireless_message *message = osPoolAlloc(wireless_pool); 
-                          message->rollAngle = 0;
-                          message->pitchAngle = 0;
-                          message->delta_t = 1;
-                          message->realtime = 0;
-                          osMessagePut(wireless_message_box, (uint32_t)message, osWaitForever);  // Send Message
-                          
-                          osDelay(10);
-                          
-                          int j;
-                          for (j = 0; j < messageIndex; j++)
-                          {
-                            Wireless_message m = wireless[j];
-                            osMessagePut(wireless_message_box, (uint32_t)&m, osWaitForever);  // Send Message
-                            osDelay(10);
-                          }
-                          
-                          message = osPoolAlloc(wireless_pool); 
-                          message->rollAngle = 0;
-                          message->pitchAngle = 0;
-                          message->delta_t = 1;
-                          message->realtime = 0;
-                          osMessagePut(wireless_message_box, (uint32_t)message, osWaitForever);  // Send Message
-                          osDelay(10);
-                          
-                          messageIndex = 0;
-                          clearLCD();
-                          resetLCDPosition();    
-                        }
-                        else if (currKeypress == 'C')
-                        {
-                          counter = 0;
-                          memset(keypadEntry, 0, sizeof(keypadEntry));
-                          int j;
-                          for (j = 0; j < messageIndex; j++)
-                          {
-                            Wireless_message m = wireless[j];
-                            osPoolFree(wireless_pool, wireless_m); // free memory allocated for message
-                          }
-                          messageIndex = 0;
-                          clearLCD();
-                          resetLCDPosition();
+                        switch (waypoint_parser_feed(&parser, &program, currKeypress)) {
+                            case PARSER_KEY:
+                                printLCDCharKeypad(currKeypress);
+                                break;
+                            case PARSER_WAYPOINT:
+                            case PARSER_FULL:
+                            case PARSER_CANCEL:
+                                //stored until 'B', no message memory needed yet
+                                clearLCD();
+                                resetLCDPosition();
+                                break;
+                            case PARSER_SEND:
+                                clearLCD();
+                                resetLCDPosition();
+                                // a program that could not be sent is kept for another 'B'
+                                if (send_program(&program) == 0) {
+                                    waypoint_program_clear(&program);
+                                }
+                                else {
+                                    printLCDString("SEND FAILED", 1);
+                                }
+                                break;
+                            case PARSER_SAVE:
+                                clearLCD();
+                                resetLCDPosition();
+                                sprintf(name, "PROG %d", parser.slot);
+                                printLCDString((waypoint_store_save(parser.slot, name, &program) == 0)? "SAVED": "SAVE FAILED", 1);
+                                break;
+                            case PARSER_REPLAY:
+                                clearLCD();
+                                resetLCDPosition();
+                                // the program being typed is left as it is
+                                if (waypoint_store_load(parser.slot, &replay, name) != 0) {
+                                    printLCDString("EMPTY SLOT", 1);
+                                }
+                                else {
+                                    printLCDString((send_program(&replay) == 0)? name: "SEND FAILED", 1);
+                                }
+                                break;
+                            default:
+                                break;
                         }
                     }
                 }
         }
         else {
             turnOffGreenLED();
+            // In realtime mode the keys control the recorder: '*' starts/stops a capture,
+            // '1'-'8' replays it at that speed, '#' stops. 'C' steps to the next radio profile
+            while (Keypad_get_event(&event)) {
+                if (event & KEYPAD_DOWN) {
+                    char currKeypress = Keypad_Get_Character(event);
+                    
+                    if (currKeypress == '*') {
+                        state_publish(&recorder, (state_get(&recorder) == RECORDER_IDLE)? RECORDER_CAPTURE: RECORDER_IDLE);
+                    }
+                    else if (currKeypress >= '1' && currKeypress < '1' + REPLAY_MAX_SPEED) {
+                        state_publish(&recorder, RECORDER_REPLAY | (currKeypress - '0'));
+                    }
+                    else if (currKeypress == '#') {
+                        state_publish(&recorder, RECORDER_IDLE);
+                    }
+#if TDMA_ENABLE == 0
+                    else if (currKeypress == 'C') {
+                        state_publish(&radioProfile, (state_get(&radioProfile) + 1) % CC2500_PROFILE_COUNT);
+                    }
+#endif
+                }
+            }
+            if (signals & TELEMETRY_FLAG) {
+                show_telemetry();
+            }
         }
     }
 }
 
+//Queue a program for the radio with one call, framed by a zero waypoint on each side
+int send_program(const Waypoint_program *p)
+{
+	static uint32_t batch[WAYPOINT_PROGRAM_SIZE + 2];
+	Wireless_message *message;
+	int count = p->count + 2;
+	int j;
+	
+	//All or nothing: a program with waypoints missing would move the servos to the wrong places
+	for (j = 0; j < count; j++)
+	{
+		batch[j] = (uint32_t)slab_alloc(sizeof(Wireless_message));
+		if (batch[j] == 0) {
+			while (j-- > 0) {
+				slab_free((void *)batch[j]);
+			}
+			return -1;
+		}
+	}
+	for (j = -1; j <= p->count; j++)
+	{
+		message = (Wireless_message *)batch[j + 1];
+		if (j < 0 || j == p->count) {
+			message->rollAngle = 0;
+			message->pitchAngle = 0;
+			message->delta_t = 1;
+		}
+		else {
+			message->rollAngle = p->waypoints[j].rollAngle;
+			message->pitchAngle = p->waypoints[j].pitchAngle;
+			message->delta_t = p->waypoints[j].delta_t;
+		}
+		message->realtime = 0;
+	}
+	osMessagePutN(wireless_message_box, batch, count, osWaitForever);  // Send Messages
+	return 0;
+}
+
 int get_angle(int acc)
 {	
 	//If angle is beyond threshold, return constant value of 90
@@ -434,13 +708,17 @@ void init_angle_filtering()
 	init_filter(&pitchFilter, &pitchBuffer, ANGLE_FILTER_DEPTH);
 }
 
+//Switch between realtime and keypad mode
+static uint16_t toggle_mode(uint16_t m)
+{
+	return (m == REALTIME_MODE)? KEYPAD_MODE: REALTIME_MODE;
+}
+
 void EXTI0_IRQHandler()
 {
 	if(EXTI_GetITStatus(EXTI_Line0) != RESET)
 	{
-		osSemaphoreWait(modeSemaphore, osWaitForever);
-		mode = (mode == REALTIME_MODE)? KEYPAD_MODE: REALTIME_MODE;
-		osSemaphoreRelease(modeSemaphore);
+		state_update(&mode, toggle_mode);
 	}
 	EXTI_ClearITPendingBit(EXTI_Line0);
 }
@@ -455,24 +733,447 @@ void EXTI1_IRQHandler()
 	EXTI_ClearITPendingBit(EXTI_Line1);
 }
 
-void TIM3_IRQHandler() {
-    osSignalSet(tid_keypad, KEYPAD_FLAG);
-    
-    TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
-}
-
 //write wireless message to wireless queue
 void write_wireless_message(Wireless_message *m)
 {	
-	int8_t size = sizeof(Wireless_message);
+	int8_t header[2] = {1 + sizeof(Wireless_message), REMOTE_ADDRESS};
 	
-	CC2500_WriteFIFO(&size, FIFO_WRITE_ADDRESS, 1);
+	CC2500_WriteFIFO(header, FIFO_WRITE_BURST_ADDRESS, 2);
 	//CC2500_CmdStrobe(STX);
 	
 	CC2500_WriteFIFO((int8_t*) m, FIFO_WRITE_BURST_ADDRESS, sizeof(Wireless_message));
 	//CC2500_CmdStrobe(STX);
 }
 
+//length byte, address byte, payload
+int encode_wireless_message(Wireless_message *m, uint8_t *frame)
+{
+	int length;
+	
+	if (m->realtime)
+	{
+		length = link_encode(&link, m->rollAngle, m->pitchAngle, frame + 2);
+		if (length == 0)
+		{
+			return 0;	//held, the base board already has this position
+		}
+	}
+	else
+	{
+		length = sizeof(Wireless_message);
+		memcpy(frame + 2, m, length);
+	}
+	frame[0] = 1 + length;
+	frame[1] = REMOTE_ADDRESS;
+	return 2 + length;
+}
+
+//write a burst of length-prefixed packets, the radio sends them back to back
+int write_wireless_messages(Wireless_message **m, int count)
+{
+	uint8_t frames[WIRELESS_BATCH_SIZE * (2 + sizeof(Wireless_message))];
+	uint8_t *f = frames;
+	int i;
+	
+	for (i = 0; i < count; i++)
+	{
+		if (throttle && m[i]->realtime && i + 1 < count && m[i + 1]->realtime)
+		{
+			continue;	//the base board is behind: a newer position follows
+		}
+		f += encode_wireless_message(m[i], f);
+	}
+	if (f > frames)
+	{
+		wake_base();
+		CC2500_WriteFIFO((int8_t *)frames, FIFO_WRITE_BURST_ADDRESS, f - frames);
+	}
+	return f - frames;
+}
+
+void write_wireless_control(uint8_t command, uint8_t argument)
+{
+	uint8_t frame[2 + LINK_CONTROL_SIZE] = {1 + LINK_CONTROL_SIZE, REMOTE_ADDRESS, LINK_CONTROL, command, argument};
+	
+	wait_tx_fifo(sizeof(frame));
+	CC2500_WriteFIFO((int8_t *)frame, FIFO_WRITE_BURST_ADDRESS, sizeof(frame));
+}
+
+//The base board follows on the first copy it receives, the others cover lost packets
+int switch_profile(CC2500_Rate rate)
+{
+	int result;
+	int i;
+	
+	wake_base();
+	for (i = 0; i < WIRELESS_SWITCH_REPEAT; i++)
+	{
+		write_wireless_control(LINK_SET_PROFILE, rate);
+	}
+	CC2500_Enter(STX);
+	wait_tx_done();
+	
+	result = CC2500_SetProfile(rate);
+#if CC2500_WOR_PERIOD != 0
+	lastTransmit = DWT_CYCCNT;	//the base board follows and stays awake
+#else
+	CC2500_Enter(STX);
+#endif
+	if (result != 0)
+	{
+		return -1;
+	}
+	
+	//The base board drops its state with the flushed FIFO: start again with a full message
+	link_encoder_init(&link);
+	return 0;
+}
+
+//Sleep until GDO2 falls below the threshold set for this write; TXBYTES is only read once per wake-up.
+//The timeout covers a radio that is not sending, which never drains the FIFO
+void wait_tx_fifo(int numBytes)
+{
+	int frameTime = CC2500_Profiles[CC2500_GetProfile()].frameTime / 1000 + 1;
+	int8_t numBytesFIFOBuffer;
+	
+	CC2500_SetTXRoom(numBytes + 10);
+	while (1)
+	{
+		osSignalClear(osThreadGetId(), RADIO_FLAG);
+		CC2500_TXFifoInterruptCmd(ENABLE);
+		CC2500_Read_Reg(&numBytesFIFOBuffer, TXBYTES, 1);
+		numBytesFIFOBuffer = numBytesFIFOBuffer & 0x7f;
+		if (numBytesFIFOBuffer + numBytes + 10 <= FIFO_SIZE)
+		{
+			break;
+		}
+		osSignalWait(RADIO_FLAG, 2 * frameTime);
+	}
+	CC2500_TXFifoInterruptCmd(DISABLE);
+}
+
+//Empty FIFO (or an underflow) with GDO0 low: the last packet, high from its sync word to its CRC, has left
+//the modulator. GDO0 falls at the end of every packet, so the thread wakes once per packet sent
+void wait_tx_done()
+{
+	int frameTime = CC2500_Profiles[CC2500_GetProfile()].frameTime / 1000 + 1;
+	int8_t numBytes;
+	
+	while (1)
+	{
+		osSignalClear(osThreadGetId(), RADIO_FLAG);
+		CC2500_PacketInterruptCmd(ENABLE);
+		CC2500_Read_Reg(&numBytes, TXBYTES, 1);
+		if ((numBytes & 0x80) ||
+			(numBytes == 0 && GPIO_ReadInputDataBit(CC2500_SPI_INT0_GPIO_PORT, CC2500_SPI_INT0_PIN) == Bit_RESET))
+		{
+			break;
+		}
+		osSignalWait(RADIO_FLAG, 2 * frameTime);
+	}
+	CC2500_PacketInterruptCmd(DISABLE);
+}
+
+//A preamble spanning one event period wakes the radio, the first packet the MCU; the pause lets it
+//return to continuous RX before the rest
+void wake_base()
+{
+#if CC2500_WOR_PERIOD != 0
+	if ((DWT_CYCCNT - lastTransmit) / (SystemCoreClock / 1000) < CC2500_WOR_AWAKE / 2)
+	{
+		return;
+	}
+	CC2500_Enter(STX);	//empty FIFO: preamble until the first byte is written
+	osDelay(CC2500_WOR_PERIOD + 1);
+	write_wireless_control(LINK_KEEPALIVE, 0);
+	wait_tx_done();
+	osDelay(WIRELESS_WAKE_GAP);
+#endif
+}
+
+void end_burst()
+{
+#if CC2500_WOR_PERIOD != 0
+	CC2500_Enter(STX);
+	wait_tx_done();
+	CC2500_Enter(SIDLE);
+	lastTransmit = DWT_CYCCNT;
+#endif
+}
+
+//Half duplex: the base board answers LINK_TELEMETRY_DELAY frames after the request, at its next poll
+int request_telemetry()
+{
+	Link_telemetry t;
+	uint8_t packet[1 + 1 + LINK_TELEMETRY_SIZE + 2];
+	int frame = CC2500_Profiles[CC2500_GetProfile()].frameTime / 1000 + 1;
+	int wait = WIRELESS_TELEMETRY_WAIT + (LINK_TELEMETRY_DELAY + 2) * frame;
+	int8_t numBytes = 0;
+	int status = -1;
+	uint32_t start;
+	int elapsed;
+	
+	wake_base();
+	write_wireless_control(LINK_REQUEST_TELEMETRY, 0);
+	CC2500_Enter(STX);
+	wait_tx_done();
+	osSignalClear(osThreadGetId(), RADIO_FLAG);
+	CC2500_PacketInterruptCmd(ENABLE);
+	CC2500_Enter(SRX);
+	
+	//GDO0 falls at the end of each packet received
+	start = DWT_CYCCNT;
+	for (elapsed = 0; elapsed < wait && (numBytes & 0x7f) < sizeof(packet) && !(numBytes & 0x80);
+		elapsed = (DWT_CYCCNT - start) / (SystemCoreClock / 1000))
+	{
+		osSignalWait(RADIO_FLAG, wait - elapsed);
+		CC2500_Read_Reg(&numBytes, RXBYTES, 1);
+	}
+	CC2500_PacketInterruptCmd(DISABLE);
+	//length, address, telemetry, 2 status bytes, CRC OK in bit 7 of the last
+	if ((numBytes & 0xff) == sizeof(packet))
+	{
+		CC2500_ReadFIFO((int8_t *)packet, FIFO_READ_BURST_ADDRESS, sizeof(packet));
+		if (packet[0] == 1 + LINK_TELEMETRY_SIZE && (packet[sizeof(packet) - 1] & 0x80) &&
+			link_telemetry_decode(&t, packet + 2, LINK_TELEMETRY_SIZE) == 0)
+		{
+			osSemaphoreWait(displaySemaphore, osWaitForever);
+			telemetry = t;
+			osSemaphoreRelease(displaySemaphore);
+			throttle = t.motorQueue >= LINK_BEHIND || t.interpolatorQueue >= LINK_BEHIND;
+			osSignalSet(tid_keypad, TELEMETRY_FLAG);
+			status = 0;
+		}
+	}
+	
+	//Anything else received is dropped
+	CC2500_Enter(SIDLE);
+	CC2500_CmdStrobe(SFRX);
+#if CC2500_WOR_PERIOD != 0
+	lastTransmit = DWT_CYCCNT;
+#else
+	CC2500_Enter(STX);
+#endif
+	return status;
+}
+
+//Commanded angles, base board queue depths (motor, interpolator), drops and lost packets
+void show_telemetry()
+{
+	Link_telemetry t;
+	char line[LCD_COLS + 1];
+	
+	osSemaphoreWait(displaySemaphore, osWaitForever);
+	t = telemetry;
+	osSemaphoreRelease(displaySemaphore);
+	
+	sprintf(line, "R%4d P%4d Q%3d/%3d", t.rollAngle, t.pitchAngle, t.motorQueue, t.interpolatorQueue);
+	printLCDString(line, 1);
+	sprintf(line, "DROP%4d/%3d LOST%4d", t.motorDropped, t.interpolatorDropped, t.lost);
+	printLCDString(line, 2);
+}
+
+#if TDMA_ENABLE != 0
+void wireless_tdma()
+{
+	Tdma_beacon beacon;
+	Wireless_message *wireless_m;
+	Wireless_message *held = NULL;
+	osEvent event;
+	uint8_t packet[1 + 1 + TDMA_BEACON_SIZE + 2];
+	uint8_t frame[2 + sizeof(Wireless_message)];
+	uint32_t beaconEnd;
+	uint32_t slotStart;
+	uint32_t lastSent = hr_timer_now();
+	int8_t mcsm1 = WIRELESS_TDMA_MCSM1;
+	int8_t numBytes;
+	int length;
+	int slot;
+	
+	//Only beacons (address 0) get through; the end of every packet raises EXTI
+	CC2500_SetAddress(REMOTE_ADDRESS, CC2500_ADR_CHK_BROADCAST);
+	CC2500_Write_Reg(&mcsm1, MCSM1_WRITE_SINGLE, 1);
+	hr_timer_create(&slotTimer, slot_timer_callback, NULL);
+	CC2500_PacketInterrupt_Config();
+	CC2500_Enter(SRX);
+	
+	//The slot is a few hundred usec long: run as soon as the beacon or the slot timer signals
+	osThreadSetPriority(osThreadGetId(), osPriorityHigh);
+	
+	while(1)
+	{
+		osSignalWait(BEACON_FLAG, osWaitForever);
+		beaconEnd = packetEnd;
+		
+		CC2500_Read_Reg(&numBytes, RXBYTES, 1);
+		if (numBytes & 0x80)
+		{
+			CC2500_CmdStrobe(SFRX);
+			CC2500_Enter(SRX);
+			continue;
+		}
+		if ((numBytes & 0x7f) < sizeof(packet))
+		{
+			continue;	//our own packet, or one for another board
+		}
+		
+		//length, address, beacon, 2 status bytes; anything else means the FIFO is out of step
+		CC2500_ReadFIFO((int8_t *)packet, FIFO_READ_BURST_ADDRESS, sizeof(packet));
+		if (packet[0] != 1 + TDMA_BEACON_SIZE || (numBytes & 0x7f) != sizeof(packet))
+		{
+			CC2500_CmdStrobe(SIDLE);
+			CC2500_CmdStrobe(SFRX);
+			CC2500_Enter(SRX);
+			continue;
+		}
+		if (!(packet[sizeof(packet) - 1] & 0x80) || tdma_beacon_decode(&beacon, packet + 2, TDMA_BEACON_SIZE) != 0)
+		{
+			continue;	//failed its CRC
+		}
+		
+		slot = tdma_slot_of(&beacon, REMOTE_ADDRESS);
+		if (slot < 0 && !tdma_may_join(&beacon, REMOTE_ADDRESS))
+		{
+			continue;
+		}
+		slotStart = beaconEnd + tdma_slot_start(&beacon, (slot < 0)? TDMA_SLOTS: slot);
+		if ((int32_t)(slotStart - hr_timer_now()) < TDMA_GUARD)
+		{
+			continue;	//too late to write the packet before the slot starts
+		}
+		
+		length = 0;
+		if (slot < 0)
+		{
+			uint8_t join[2 + LINK_CONTROL_SIZE] = {1 + LINK_CONTROL_SIZE, REMOTE_ADDRESS, LINK_CONTROL, LINK_JOIN, 0};
+			
+			memcpy(frame, join, sizeof(join));
+			length = sizeof(join);
+			//The base board drops the stream of a new owner: start again with a full message
+			link_encoder_init(&link);
+		}
+		else
+		{
+			//One message per superframe. Below 250 kBaud a superframe is longer than the 10 msec sample
+			//period, so realtime samples queue up: only the newest is sent. A keypad message found behind
+			//them is held for the next slot
+			wireless_m = held;
+			held = NULL;
+			if (wireless_m == NULL)
+			{
+				event = osMessageGet(wireless_message_box, 0);
+				wireless_m = (event.status == osEventMessage)? event.value.p: NULL;
+			}
+			while (wireless_m != NULL && wireless_m->realtime)
+			{
+				event = osMessageGet(wireless_message_box, 0);
+				if (event.status != osEventMessage)
+				{
+					break;
+				}
+				if (!((Wireless_message *)event.value.p)->realtime)
+				{
+					held = event.value.p;
+					break;
+				}
+				slab_free(wireless_m);                  // a newer sample follows
+				wireless_m = event.value.p;
+			}
+			if (wireless_m != NULL)
+			{
+				length = encode_wireless_message(wireless_m, frame);
+				slab_free(wireless_m);                  // free memory allocated for message
+			}
+			if (length == 0 && hr_timer_now() - lastSent >= WIRELESS_KEEPALIVE * 1000)
+			{
+				uint8_t keepalive[2 + LINK_CONTROL_SIZE] = {1 + LINK_CONTROL_SIZE, REMOTE_ADDRESS, LINK_CONTROL, LINK_KEEPALIVE, 0};
+				
+				memcpy(frame, keepalive, sizeof(keepalive));
+				length = sizeof(keepalive);
+			}
+		}
+		if (length == 0)
+		{
+			continue;	//held: the slot stays empty
+		}
+		
+		//The TX FIFO is empty between slots, the packet is written whole before STX so it cannot underflow
+		CC2500_WriteFIFO((int8_t *)frame, FIFO_WRITE_BURST_ADDRESS, length);
+		osSignalClear(osThreadGetId(), SLOT_FLAG);
+		length = slotStart - hr_timer_now();
+		hr_timer_start(&slotTimer, (length > 0)? length: 0, 0);
+		osSignalWait(SLOT_FLAG, osWaitForever);
+		CC2500_CmdStrobe(STX);
+		lastSent = hr_timer_now();
+	}
+}
+
+// Runs in the TIM5 interrupt (hr_timer.c)
+void slot_timer_callback(void *arg)
+{
+	osSignalSet(tid_wireless, SLOT_FLAG);
+}
+
+#endif
+
+void EXTI15_10_IRQHandler()
+{
+	if (EXTI_GetITStatus(CC2500_SPI_INT0_EXTI_LINE) != RESET)
+	{
+#if TDMA_ENABLE != 0
+		packetEnd = hr_timer_now();
+		osSignalSet(tid_wireless, BEACON_FLAG);
+#else
+		osSignalSet(tid_wireless, RADIO_FLAG);
+#endif
+	}
+	if (EXTI_GetITStatus(CC2500_SPI_INT2_EXTI_LINE) != RESET)
+	{
+		osSignalSet(tid_wireless, RADIO_FLAG);
+	}
+	EXTI_ClearITPendingBit(CC2500_SPI_INT0_EXTI_LINE | CC2500_SPI_INT2_EXTI_LINE);
+}
+
+#ifdef BENCHMARK
+void run_benchmarks()
+{
+	static Benchmark_report report;
+	static const Keypad_event keys[] = {KEYPAD_DOWN | 0, KEYPAD_DOWN | 5, KEYPAD_DOWN | 10, 15, 3};
+	volatile int angle;
+	volatile char key;
+	Wireless_message m = {-45, 30, 5, 0};
+	Link_encoder encoder;
+	uint8_t packet[LINK_FULL_SIZE];
+	volatile int length;
+	int8_t roll = 0;
+	int acc = -NINETY_DEG_THRESH;
+	int k = 0;
+	
+	benchmark_init(&report, "remote_board");
+	benchmark_run_common(&report);
+	benchmark_run_scheduler(&report, 32);
+	
+	BENCHMARK_RUN(&report, "get_angle", acc = (acc >= NINETY_DEG_THRESH)? -NINETY_DEG_THRESH: acc + 3, angle = get_angle(acc));
+	BENCHMARK_RUN(&report, "Keypad_Get_Character", k = (k + 1) % 5, key = Keypad_Get_Character(keys[k]));
+	
+	//Frame encode is the SPI FIFO write; flush so the FIFO never overflows
+	CC2500_Init();
+	BENCHMARK_RUN(&report, "write_wireless_message", CC2500_CmdStrobe(SFTX), write_wireless_message(&m));
+	CC2500_CmdStrobe(SFTX);
+	
+	//Build the packet of a sample three degrees from the last one: a delta, a full message every heartbeat
+	link_encoder_init(&encoder);
+	BENCHMARK_RUN(&report, "link_encode", roll = 3 - roll, length = link_encode(&encoder, roll, 0, packet));
+	
+	LCD_benchmark(&report);
+	
+	benchmark_print_json(&report);
+	(void)angle;
+	(void)key;
+	(void)length;
+}
+#endif
+
 void LED_GPIO_config() {
     
     RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOD, ENABLE);
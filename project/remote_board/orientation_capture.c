@@ -0,0 +1,144 @@
+#include "orientation_capture.h"
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_flash.h"
+
+#define CAPTURE_ADDRESS 0x080A0000
+#define CAPTURE_SIZE 0x20000
+#define CAPTURE_SECTOR FLASH_Sector_9
+#define CAPTURE_MAGIC 0x5043524F	//"ORCP"
+#define CAPTURE_FLASH_FLAGS (FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR)
+
+//Header: the magic word, then the period; the last half word stays erased
+#define CAPTURE_PERIOD (*(const uint16_t *)(CAPTURE_ADDRESS + 4))
+#define CAPTURE_DATA (CAPTURE_ADDRESS + 8)
+#define CAPTURE_LIMIT (CAPTURE_ADDRESS + CAPTURE_SIZE)
+
+static uint32_t write = 0;	//next free byte, 0 when no capture is being written
+static int8_t lastRoll;
+static int8_t lastPitch;
+
+//Lock flash and drop data cache lines of the old contents
+static void flash_end()
+{
+	FLASH_Lock();
+	FLASH_DataCacheCmd(DISABLE);
+	FLASH_DataCacheReset();
+	FLASH_DataCacheCmd(ENABLE);
+}
+
+int capture_start(uint16_t period)
+{
+	int result = 0;
+
+	write = 0;
+	FLASH_Unlock();
+	FLASH_ClearFlag(CAPTURE_FLASH_FLAGS);
+	if (FLASH_EraseSector(CAPTURE_SECTOR, VoltageRange_3) != FLASH_COMPLETE ||
+		FLASH_ProgramHalfWord(CAPTURE_ADDRESS + 4, period) != FLASH_COMPLETE ||
+		FLASH_ProgramWord(CAPTURE_ADDRESS, CAPTURE_MAGIC) != FLASH_COMPLETE)
+	{
+		result = -1;
+	}
+	flash_end();
+
+	if (result == 0)
+	{
+		write = CAPTURE_DATA;
+		lastRoll = 0;
+		lastPitch = 0;
+	}
+	return result;
+}
+
+int capture_add(int8_t rollAngle, int8_t pitchAngle)
+{
+	int rollDelta = rollAngle - lastRoll;
+	int pitchDelta = pitchAngle - lastPitch;
+	FLASH_Status status;
+
+	//Room for an absolute sample
+	if (write == 0 || write + 3 > CAPTURE_LIMIT)
+	{
+		return -1;
+	}
+
+	FLASH_Unlock();
+	if (rollDelta >= -CAPTURE_MAX_DELTA && rollDelta <= CAPTURE_MAX_DELTA &&
+		pitchDelta >= -CAPTURE_MAX_DELTA && pitchDelta <= CAPTURE_MAX_DELTA)
+	{
+		status = FLASH_ProgramByte(write++, ((rollDelta + CAPTURE_MAX_DELTA) << 4) | (pitchDelta + CAPTURE_MAX_DELTA));
+	}
+	else
+	{
+		//The escape byte goes last: until it is written the sample reads as erased flash, the end of the
+		//stream. An angle of -1 is 0xFF, so the angle bytes alone cannot tell a cut sample from a whole one
+		status = FLASH_ProgramByte(write + 1, (uint8_t)rollAngle);
+		if (status == FLASH_COMPLETE)
+		{
+			status = FLASH_ProgramByte(write + 2, (uint8_t)pitchAngle);
+		}
+		if (status == FLASH_COMPLETE)
+		{
+			status = FLASH_ProgramByte(write, CAPTURE_ABSOLUTE);
+		}
+		write += 3;
+	}
+	flash_end();
+
+	if (status != FLASH_COMPLETE)
+	{
+		write = 0;
+		return -1;
+	}
+	lastRoll = rollAngle;
+	lastPitch = pitchAngle;
+	return 0;
+}
+
+int capture_open(Capture_reader *r)
+{
+	if (*(const uint32_t *)CAPTURE_ADDRESS != CAPTURE_MAGIC)
+	{
+		return -1;
+	}
+	r->next = (const uint8_t *)CAPTURE_DATA;
+	r->rollAngle = 0;
+	r->pitchAngle = 0;
+	return CAPTURE_PERIOD;
+}
+
+int capture_next(Capture_reader *r, int8_t *rollAngle, int8_t *pitchAngle)
+{
+	const uint8_t *limit = (const uint8_t *)CAPTURE_LIMIT;
+	uint8_t b;
+
+	//Erased flash (CAPTURE_END) or a change of 8, which is never written, ends the stream
+	if (r->next >= limit || (*r->next >= 0xF0 && *r->next != CAPTURE_ABSOLUTE))
+	{
+		return -1;
+	}
+
+	b = *r->next++;
+	if (b == CAPTURE_ABSOLUTE)
+	{
+		//Only a damaged image ends in the middle of an absolute sample
+		if (r->next + 2 > limit)
+		{
+			r->next = limit;
+			return -1;
+		}
+		r->rollAngle = (int8_t)r->next[0];
+		r->pitchAngle = (int8_t)r->next[1];
+		r->next += 2;
+	}
+	else
+	{
+		r->rollAngle += (b >> 4) - CAPTURE_MAX_DELTA;
+		r->pitchAngle += (b & 0x0F) - CAPTURE_MAX_DELTA;
+	}
+
+	*rollAngle = r->rollAngle;
+	*pitchAngle = r->pitchAngle;
+	return 0;
+}
@@ -0,0 +1,72 @@
+/*!
+ @file orientation_capture.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a recorder for the filtered roll/pitch stream, so a motion profile can be replayed exactly.
+ A capture lives in flash sector 9 (0x080A0000 - 0x080BFFFF), so it survives a reset and can be read or
+ written by the debugger (e.g. st-flash read capture.bin 0x080A0000 0x20000); project/tools converts
+ such images to and from CSV. The linker may only use the flash below this sector.
+
+ Format: an 8 byte header (magic, sample period in msec), then one byte per sample holding the roll and
+ pitch changes as two nibbles, each change + 7. A change outside -7..7 is written as 0xF0 followed by
+ the absolute roll and pitch bytes; the 0xF0 is written after them. The stream ends at the first erased
+ (0xFF) byte, so a capture cut short by a reset is still valid up to its last whole sample.
+
+ Starting a capture erases the sector, which stalls the CPU for 1 to 2 seconds.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _ORIENTATION_CAPTURE_H
+#define _ORIENTATION_CAPTURE_H
+
+#include <stdint.h>
+
+#define CAPTURE_MAX_DELTA 7	/*!< Largest change stored in one nibble */
+#define CAPTURE_ABSOLUTE 0xF0	/*!< Escape byte, the absolute roll and pitch follow */
+#define CAPTURE_END 0xFF	/*!< Erased flash, end of the stream */
+
+/**
+* A structure to represent a position in a capture being replayed
+*/
+typedef struct {
+	const uint8_t *next;	/**< the next byte to decode */
+	int8_t rollAngle;	/**< the last decoded roll */
+	int8_t pitchAngle;	/**< the last decoded pitch */
+} Capture_reader;
+
+/*!
+ Erase the capture and start a new one. Returns 0 on success, -1 if flash could not be written.
+ @param[in] period The sample period in msec, kept for the host tools
+ */
+int capture_start(uint16_t period);
+
+/*!
+ Append a sample to the capture. Returns 0 on success, -1 if the capture is full or flash failed.
+ @param[in] rollAngle The roll angle in degrees
+ @param[in] pitchAngle The pitch angle in degrees
+ */
+int capture_add(int8_t rollAngle, int8_t pitchAngle);
+
+/*!
+ Start reading the capture from its first sample. Returns the sample period in msec, or -1 if flash
+ holds no capture.
+ @param[out] r A pointer to the reader struct
+ */
+int capture_open(Capture_reader *r);
+
+/*!
+ Decode the next sample. Returns 0 on success, -1 at the end of the capture.
+ @param[in,out] r A pointer to the reader struct
+ @param[out] rollAngle The roll angle in degrees
+ @param[out] pitchAngle The pitch angle in degrees
+ */
+int capture_next(Capture_reader *r, int8_t *rollAngle, int8_t *pitchAngle);
+
+#endif
+
+//! @}
@@ -0,0 +1,145 @@
+#include "waypoint_program.h"
+
+void waypoint_program_clear(Waypoint_program *p)
+{
+	p->count = 0;
+}
+
+int waypoint_program_add(Waypoint_program *p, const Waypoint *w)
+{
+	if (p->count >= WAYPOINT_PROGRAM_SIZE)
+	{
+		return -1;
+	}
+	p->waypoints[p->count] = *w;
+	p->count++;
+	return 0;
+}
+
+//Start the next field with no sign and no digits
+static void start_field(Waypoint_parser *parser, Parser_field field)
+{
+	parser->field = field;
+	parser->sign = 1;
+	parser->hasSign = 0;
+	parser->digits = 0;
+	parser->value = 0;
+}
+
+void waypoint_parser_reset(Waypoint_parser *parser)
+{
+	start_field(parser, PARSER_ROLL);
+	parser->rollAngle = 0;
+	parser->pitchAngle = 0;
+}
+
+//Slot commands: one digit, then 'A' or 'B'
+static Parser_result feed_slot(Waypoint_parser *parser, Waypoint_program *p, char key)
+{
+	if (key >= '0' && key <= '9' && parser->digits == 0)
+	{
+		parser->value = key - '0';
+		parser->digits = 1;
+		return PARSER_KEY;
+	}
+	if ((key == 'A' || key == 'B') && parser->digits == 1)
+	{
+		waypoint_parser_reset(parser);
+		parser->slot = parser->value;
+		return (key == 'A')? PARSER_SAVE: PARSER_REPLAY;
+	}
+	if (key == 'C')
+	{
+		waypoint_parser_reset(parser);
+		waypoint_program_clear(p);
+		return PARSER_CANCEL;
+	}
+	return PARSER_REJECTED;
+}
+
+int waypoint_parser_busy(const Waypoint_parser *parser)
+{
+	return parser->field != PARSER_ROLL || parser->hasSign || parser->digits > 0;
+}
+
+Parser_result waypoint_parser_feed(Waypoint_parser *parser, Waypoint_program *p, char key)
+{
+	Waypoint w;
+	int maxValue = (parser->field == PARSER_TIME)? WAYPOINT_MAX_TIME: WAYPOINT_MAX_ANGLE;
+
+	if (parser->field == PARSER_SLOT)
+	{
+		return feed_slot(parser, p, key);
+	}
+
+	if (key >= '0' && key <= '9')
+	{
+		//Reject a digit that would leave the range, so the field is always valid
+		if (parser->digits >= 2 || parser->value * 10 + (key - '0') > maxValue)
+		{
+			return PARSER_REJECTED;
+		}
+		parser->value = parser->value * 10 + (key - '0');
+		parser->digits++;
+		return PARSER_KEY;
+	}
+
+	switch (key)
+	{
+		case '#':
+		case '*':
+			//Angles only, once, before the digits
+			if (parser->field == PARSER_TIME || parser->hasSign || parser->digits > 0)
+			{
+				return PARSER_REJECTED;
+			}
+			parser->sign = (key == '*')? -1: 1;
+			parser->hasSign = 1;
+			return PARSER_KEY;
+
+		case 'D':
+			//Between waypoints 'D' starts a slot command
+			if (!waypoint_parser_busy(parser))
+			{
+				start_field(parser, PARSER_SLOT);
+				return PARSER_KEY;
+			}
+			if (parser->field == PARSER_TIME || parser->digits == 0)
+			{
+				return PARSER_REJECTED;
+			}
+			if (parser->field == PARSER_ROLL)
+			{
+				parser->rollAngle = parser->sign * parser->value;
+				start_field(parser, PARSER_PITCH);
+			}
+			else
+			{
+				parser->pitchAngle = parser->sign * parser->value;
+				start_field(parser, PARSER_TIME);
+			}
+			return PARSER_KEY;
+
+		case 'A':
+			if (parser->field != PARSER_TIME || parser->value < WAYPOINT_MIN_TIME)
+			{
+				return PARSER_REJECTED;
+			}
+			w.rollAngle = parser->rollAngle;
+			w.pitchAngle = parser->pitchAngle;
+			w.delta_t = parser->value;
+			waypoint_parser_reset(parser);
+			return (waypoint_program_add(p, &w) == 0)? PARSER_WAYPOINT: PARSER_FULL;
+
+		case 'B':
+			return waypoint_parser_busy(parser)? PARSER_REJECTED: PARSER_SEND;
+
+		case 'C':
+			waypoint_parser_reset(parser);
+			waypoint_program_clear(p);
+			return PARSER_CANCEL;
+
+		default:
+			return PARSER_REJECTED;
+	}
+}
@@ -0,0 +1,130 @@
+/*!
+ @file waypoint_program.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a bounded store for the waypoints typed on the keypad and the parser that builds them.
+ The parser is a state machine fed one key at a time: fields are built digit by digit and every key is
+ checked against the ranges as it arrives, so a waypoint is complete and valid as soon as 'A' is accepted.
+
+ Input format, one waypoint at a time:
+	'#' / '*' = positive/negative (optional, before the digits)
+	D - space between variables
+	A - Accept waypoint
+	B - Send the program (not in the middle of a waypoint)
+	C - Cancel, clears the waypoint being typed and the program
+
+	Ex. Roll -20, Pitch 30, Time 5 sec
+	*20D#30D5A
+
+ Slot commands, only between waypoints (see waypoint_store.h):
+	D<digit>A - Save the program to slot <digit>
+	D<digit>B - Load the program in slot <digit> and send it, the program being typed is kept
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _WAYPOINT_PROGRAM_H
+#define _WAYPOINT_PROGRAM_H
+
+#include <stdint.h>
+
+#define WAYPOINT_PROGRAM_SIZE 32	/*!< Maximum number of waypoints in a program */
+#define WAYPOINT_MAX_ANGLE 90	/*!< Roll and pitch are limited to +/- this many degrees */
+#define WAYPOINT_MIN_TIME 1	/*!< Shortest move to a waypoint in seconds */
+#define WAYPOINT_MAX_TIME 99	/*!< Longest move to a waypoint in seconds */
+
+/**
+* A structure to represent a waypoint
+*/
+typedef struct {
+	int8_t rollAngle;	/**< the roll angle in degrees */
+	int8_t pitchAngle;	/**< the pitch angle in degrees */
+	int8_t delta_t;	/**< the time to reach the angles in seconds */
+} Waypoint;
+
+/**
+* A structure to represent a program, the waypoints in the order they are visited
+*/
+typedef struct {
+	Waypoint waypoints[WAYPOINT_PROGRAM_SIZE];	/**< the waypoints */
+	int count;	/**< the number of waypoints */
+} Waypoint_program;
+
+/**
+* The field the parser is building
+*/
+typedef enum {
+	PARSER_ROLL = 0,
+	PARSER_PITCH,
+	PARSER_TIME,
+	PARSER_SLOT
+} Parser_field;
+
+/**
+* What a key did, see waypoint_parser_feed
+*/
+typedef enum {
+	PARSER_REJECTED = 0,	/*!< The key is not valid here and was ignored */
+	PARSER_KEY,	/*!< The key was added to the waypoint being typed */
+	PARSER_WAYPOINT,	/*!< 'A' completed a waypoint, it was added to the program */
+	PARSER_FULL,	/*!< 'A' completed a waypoint but the program is full, it was dropped */
+	PARSER_SEND,	/*!< 'B', the program should be sent */
+	PARSER_CANCEL,	/*!< 'C', the waypoint being typed and the program were cleared */
+	PARSER_SAVE,	/*!< 'A' after a slot, the program should be saved to the slot */
+	PARSER_REPLAY	/*!< 'B' after a slot, the program in the slot should be loaded and sent */
+} Parser_result;
+
+/**
+* A structure to represent the parser state
+*/
+typedef struct {
+	Parser_field field;	/**< the field being typed */
+	int8_t sign;	/**< the sign of the field, 1 or -1 */
+	uint8_t hasSign;	/**< whether a sign key was pressed for the field */
+	uint8_t digits;	/**< the number of digits typed in the field */
+	int value;	/**< the magnitude of the field so far */
+	int8_t rollAngle;	/**< the completed roll field */
+	int8_t pitchAngle;	/**< the completed pitch field */
+	uint8_t slot;	/**< the slot of the last PARSER_SAVE or PARSER_REPLAY */
+} Waypoint_parser;
+
+/*!
+ Empty a program.
+ @param[out] p A pointer to the program struct
+ */
+void waypoint_program_clear(Waypoint_program *p);
+
+/*!
+ Append a waypoint. Returns 0 on success, -1 if the program already holds WAYPOINT_PROGRAM_SIZE waypoints.
+ @param[in,out] p A pointer to the program struct
+ @param[in] w The waypoint to append
+ */
+int waypoint_program_add(Waypoint_program *p, const Waypoint *w);
+
+/*!
+ Start a new waypoint, forgetting any partial one.
+ @param[out] parser A pointer to the parser struct
+ */
+void waypoint_parser_reset(Waypoint_parser *parser);
+
+/*!
+ Whether a waypoint is partly typed, i.e. 'B' would be rejected.
+ @param[in] parser A pointer to the parser struct
+ */
+int waypoint_parser_busy(const Waypoint_parser *parser);
+
+/*!
+ Feed one key to the parser. Constant time: no strings are kept or copied.
+ @param[in,out] parser A pointer to the parser struct
+ @param[in,out] p The program completed waypoints are appended to, cleared on 'C'
+ @param[in] key The key character ('0'-'9', 'A'-'D', '*', '#'), any other value is rejected
+ */
+Parser_result waypoint_parser_feed(Waypoint_parser *parser, Waypoint_program *p, char key);
+
+#endif
+
+//! @}
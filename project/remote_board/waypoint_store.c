@@ -0,0 +1,295 @@
+#include "waypoint_store.h"
+
+#include <string.h>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_flash.h"
+#include "stm32f4xx_crc.h"
+#include "stm32f4xx_rcc.h"
+
+#define STORE_SECTOR_SIZE 0x20000
+#define STORE_SECTOR_MAGIC 0x54535057	//"WPST"
+#define STORE_RECORD_MAGIC 0x5057	//"WP"
+#define STORE_ERASED 0xFFFFFFFF
+#define STORE_FLASH_FLAGS (FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR)
+
+//Words of packed waypoint data, 3 bytes per waypoint
+#define DATA_WORDS(count) ((3 * (count) + 3) / 4)
+
+//Sector layout: the magic word, the generation word, then the records.
+//The magic is written last, so a sector is only used once it is complete.
+#define SECTOR_GENERATION(a) (*(const uint32_t *)((a) + 4))
+#define SECTOR_RECORDS(a) ((a) + 8)
+
+/* Record layout: the header, then the packed waypoints padded to a word.
+ * The first word is written first, so the length of a torn record is still known,
+ * and the CRC (of the rest of the header and the waypoints) is written last. */
+typedef struct {
+	uint16_t magic;
+	uint8_t slot;
+	uint8_t count;
+	char name[WAYPOINT_STORE_NAME_SIZE];
+	uint32_t crc;
+} Store_record;
+
+#define HEADER_WORDS (sizeof(Store_record) / 4)
+#define MAX_RECORD_WORDS (HEADER_WORDS + DATA_WORDS(WAYPOINT_PROGRAM_SIZE))
+
+typedef struct {
+	uint32_t address;
+	uint16_t sector;	//FLASH_Sector_x
+} Store_sector;
+
+static const Store_sector sectors[2] = {
+	{0x080C0000, FLASH_Sector_10},
+	{0x080E0000, FLASH_Sector_11}
+};
+
+static int active = -1;	//index of the active sector
+static uint32_t end;	//address of the first free word in the active sector
+
+//Record being saved, built in RAM so the CRC unit can read it as words
+static uint32_t buffer[MAX_RECORD_WORDS];
+
+static uint32_t record_words(const Store_record *r)
+{
+	return HEADER_WORDS + DATA_WORDS(r->count);
+}
+
+static uint32_t record_crc(const uint32_t *words)
+{
+	const Store_record *r = (const Store_record *)words;
+
+	//Every word but the CRC itself
+	CRC_ResetDR();
+	CRC_CalcBlockCRC((uint32_t *)words, HEADER_WORDS - 1);
+	return CRC_CalcBlockCRC((uint32_t *)words + HEADER_WORDS, DATA_WORDS(r->count));
+}
+
+static int sector_valid(int s)
+{
+	return *(const uint32_t *)sectors[s].address == STORE_SECTOR_MAGIC;
+}
+
+//Find the first free word of the active sector
+static void scan()
+{
+	uint32_t limit = sectors[active].address + STORE_SECTOR_SIZE;
+	const Store_record *r;
+
+	end = SECTOR_RECORDS(sectors[active].address);
+	while (end < limit && *(const uint32_t *)end != STORE_ERASED)
+	{
+		r = (const Store_record *)end;
+		if (r->magic != STORE_RECORD_MAGIC || r->count > WAYPOINT_PROGRAM_SIZE)
+		{
+			//Not a record start: nothing after it can be trusted, treat the sector as full
+			end = limit;
+			return;
+		}
+		end += record_words(r) * 4;
+	}
+	if (end > limit)
+	{
+		end = limit;
+	}
+}
+
+//Newest valid record of a slot in the active sector, NULL if there is none
+static const Store_record *find(int slot)
+{
+	uint32_t address = SECTOR_RECORDS(sectors[active].address);
+	const Store_record *r;
+	const Store_record *found = NULL;
+
+	while (address < end)
+	{
+		r = (const Store_record *)address;
+		if (r->slot == slot && r->crc == record_crc((const uint32_t *)r))
+		{
+			found = r;
+		}
+		address += record_words(r) * 4;
+	}
+	return found;
+}
+
+static void flash_begin()
+{
+	FLASH_Unlock();
+	FLASH_ClearFlag(STORE_FLASH_FLAGS);
+}
+
+//Lock flash and drop data cache lines of the old contents
+static void flash_end()
+{
+	FLASH_Lock();
+	FLASH_DataCacheCmd(DISABLE);
+	FLASH_DataCacheReset();
+	FLASH_DataCacheCmd(ENABLE);
+}
+
+static int program(uint32_t address, const uint32_t *words, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (FLASH_ProgramWord(address + 4 * i, words[i]) != FLASH_COMPLETE)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+//Erase sector s and copy the newest record of every slot into it, then make it active
+static int compact(int s, uint32_t generation)
+{
+	uint32_t address = SECTOR_RECORDS(sectors[s].address);
+	uint32_t magic = STORE_SECTOR_MAGIC;
+	const Store_record *r;
+	int slot;
+	int result = 0;
+
+	flash_begin();
+	if (FLASH_EraseSector(sectors[s].sector, VoltageRange_3) != FLASH_COMPLETE)
+	{
+		result = -1;
+	}
+	for (slot = 0; result == 0 && active >= 0 && slot < WAYPOINT_STORE_SLOTS; slot++)
+	{
+		r = find(slot);
+		if (r != NULL)
+		{
+			result = program(address, (const uint32_t *)r, record_words(r));
+			address += record_words(r) * 4;
+		}
+	}
+	if (result == 0)
+	{
+		result = program(sectors[s].address + 4, &generation, 1);
+	}
+	if (result == 0)
+	{
+		result = program(sectors[s].address, &magic, 1);
+	}
+	flash_end();
+
+	if (result == 0)
+	{
+		active = s;
+		end = address;
+	}
+	return result;
+}
+
+int waypoint_store_init()
+{
+	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_CRC, ENABLE);
+
+	if (sector_valid(0) && sector_valid(1))
+	{
+		active = (SECTOR_GENERATION(sectors[1].address) > SECTOR_GENERATION(sectors[0].address))? 1: 0;
+	}
+	else if (sector_valid(0) || sector_valid(1))
+	{
+		active = sector_valid(1)? 1: 0;
+	}
+	else
+	{
+		//Blank store
+		active = -1;
+		return compact(0, 0);
+	}
+	scan();
+	return 0;
+}
+
+int waypoint_store_save(int slot, const char *name, const Waypoint_program *p)
+{
+	Store_record *r = (Store_record *)buffer;
+	uint8_t *data = (uint8_t *)(buffer + HEADER_WORDS);
+	uint32_t words;
+	int i;
+	int result;
+
+	if (active < 0 || slot < 0 || slot >= WAYPOINT_STORE_SLOTS)
+	{
+		return -1;
+	}
+
+	memset(buffer, 0, sizeof(buffer));
+	r->magic = STORE_RECORD_MAGIC;
+	r->slot = slot;
+	r->count = p->count;
+	strncpy(r->name, name, WAYPOINT_STORE_NAME_SIZE);
+	for (i = 0; i < p->count; i++)
+	{
+		*data++ = p->waypoints[i].rollAngle;
+		*data++ = p->waypoints[i].pitchAngle;
+		*data++ = p->waypoints[i].delta_t;
+	}
+	r->crc = record_crc(buffer);
+	words = record_words(r);
+
+	//Full: move the live records to the other sector, the new record must fit after them
+	if (end + words * 4 > sectors[active].address + STORE_SECTOR_SIZE)
+	{
+		if (compact(1 - active, SECTOR_GENERATION(sectors[active].address) + 1) != 0 ||
+			end + words * 4 > sectors[active].address + STORE_SECTOR_SIZE)
+		{
+			return -1;
+		}
+	}
+
+	//Length word first, CRC last
+	flash_begin();
+	result = program(end, buffer, HEADER_WORDS - 1);
+	if (result == 0)
+	{
+		result = program(end + HEADER_WORDS * 4, buffer + HEADER_WORDS, words - HEADER_WORDS);
+	}
+	if (result == 0)
+	{
+		result = program(end + (HEADER_WORDS - 1) * 4, &r->crc, 1);
+	}
+	flash_end();
+
+	//After a failure the first free word is unknown: compact on the next save
+	end = (result == 0)? end + words * 4: sectors[active].address + STORE_SECTOR_SIZE;
+	return result;
+}
+
+int waypoint_store_load(int slot, Waypoint_program *p, char *name)
+{
+	const Store_record *r;
+	const uint8_t *data;
+	int i;
+
+	if (active < 0 || slot < 0 || slot >= WAYPOINT_STORE_SLOTS)
+	{
+		return -1;
+	}
+	r = find(slot);
+	if (r == NULL)
+	{
+		return -1;
+	}
+
+	data = (const uint8_t *)r + sizeof(Store_record);
+	for (i = 0; i < r->count; i++)
+	{
+		p->waypoints[i].rollAngle = *data++;
+		p->waypoints[i].pitchAngle = *data++;
+		p->waypoints[i].delta_t = *data++;
+	}
+	p->count = r->count;
+
+	if (name != NULL)
+	{
+		memcpy(name, r->name, WAYPOINT_STORE_NAME_SIZE);
+		name[WAYPOINT_STORE_NAME_SIZE] = '\0';
+	}
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*!
+ @file waypoint_store.h
+ @author Nicholas Destounis
+ @author Nikolaos Bukas
+ @author Michael Smith
+ @author Kevin Dam
+ @brief This is a store for waypoint programs in flash, so programs survive a reset.
+ Programs are saved in numbered slots with a short name. Every save appends a record to the active flash
+ sector and the last valid record of a slot wins, so a sector is only erased once it is full. Two sectors
+ are used in turn: when the active one is full the newest record of every slot is copied to the other one,
+ which only becomes active once the copy is complete. Every record carries a CRC (hardware CRC unit), so
+ a record torn by a reset is ignored and the previous version of the slot is loaded instead.
+
+ Sectors 10 and 11 (0x080C0000 - 0x080FFFFF) are reserved: the linker may only use the flash below them.
+ Erasing a sector stalls the CPU, interrupts included, for 1 to 2 seconds; this happens once every few
+ thousand saves.
+ */
+
+/*! @addtogroup Microp Project Group 1
+ *  @{
+ */
+
+#ifndef _WAYPOINT_STORE_H
+#define _WAYPOINT_STORE_H
+
+#include <stdint.h>
+#include "waypoint_program.h"
+
+#define WAYPOINT_STORE_SLOTS 10	/*!< Number of slots, selected with one keypad digit */
+#define WAYPOINT_STORE_NAME_SIZE 8	/*!< Maximum length of a slot name, not counting the terminator */
+
+/*!
+ Find the active sector, or format the store if flash holds none. Call once before the other functions.
+ Returns 0 on success, -1 if flash could not be written.
+ */
+int waypoint_store_init(void);
+
+/*!
+ Save a program to a slot, replacing the program saved there. Returns 0 on success, -1 on error.
+ @param[in] slot The slot, 0 to WAYPOINT_STORE_SLOTS - 1
+ @param[in] name The name, truncated to WAYPOINT_STORE_NAME_SIZE characters
+ @param[in] p The program
+ */
+int waypoint_store_save(int slot, const char *name, const Waypoint_program *p);
+
+/*!
+ Load the program saved in a slot. Returns 0 on success, -1 if the slot is empty.
+ @param[in] slot The slot, 0 to WAYPOINT_STORE_SLOTS - 1
+ @param[out] p The program
+ @param[out] name Receives the name, WAYPOINT_STORE_NAME_SIZE + 1 bytes; may be NULL
+ */
+int waypoint_store_load(int slot, Waypoint_program *p, char *name);
+
+#endif
+
+//! @}
@@ -0,0 +1,50 @@
+function samples = capture2csv(binFile, csvFile)
+%CAPTURE2CSV Convert a remote board orientation capture to CSV
+%   samples = capture2csv('capture.bin', 'capture.txt') decodes a flash image of
+%   the capture sector (st-flash read capture.bin 0x080A0000 0x20000, format in
+%   remote_board/orientation_capture.h) and writes one "roll,pitch" line per
+%   sample, like the raw files in Lab3/Calibration Data. Returns the samples as
+%   an N x 2 matrix.
+
+fid = fopen(binFile, 'r');
+data = fread(fid, Inf, 'uint8=>double')';
+fclose(fid);
+
+if numel(data) < 8 || data(1:4) * [1; 256; 65536; 16777216] ~= hex2dec('5043524F')
+    error('capture2csv:format', '%s is not an orientation capture', binFile);
+end
+period = data(5) + 256*data(6);
+
+samples = zeros(numel(data), 2);
+n = 0;
+roll = 0;
+pitch = 0;
+i = 9;
+while i <= numel(data)
+    b = data(i);
+    if b == hex2dec('F0')
+        % Absolute sample
+        if i + 2 > numel(data)
+            break;
+        end
+        roll = data(i+1) - 256*(data(i+1) > 127);
+        pitch = data(i+2) - 256*(data(i+2) > 127);
+        i = i + 3;
+    elseif b > hex2dec('F0')
+        % Erased flash, end of the capture
+        break;
+    else
+        % Two changes, each + 7
+        roll = roll + floor(b/16) - 7;
+        pitch = pitch + mod(b, 16) - 7;
+        i = i + 1;
+    end
+    n = n + 1;
+    samples(n, :) = [roll pitch];
+end
+samples = samples(1:n, :);
+
+dlmwrite(csvFile, samples);
+fprintf('%d samples, %d ms period (%.1f s)\n', n, period, n*period/1000);
+
+end
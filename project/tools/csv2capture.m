@@ -0,0 +1,52 @@
+function csv2capture(csvFile, binFile, period)
+%CSV2CAPTURE Convert CSV angles to a remote board orientation capture
+%   csv2capture('capture.txt', 'capture.bin') encodes one "roll,pitch" line
+%   per sample. A file with a single column or row (e.g.
+%   Lab3/Calibration Data/calibrated_but_unfiltered_roll.txt) is taken as roll
+%   with zero pitch. Angles are rounded and limited to +/-90 degrees.
+%   csv2capture(csvFile, binFile, period) sets the sample period in ms
+%   (default 10, the accelerometer rate). Load the image on the remote board
+%   with st-flash write capture.bin 0x080A0000, then replay it from the keypad.
+
+if nargin < 3
+    period = 10;
+end
+
+angles = dlmread(csvFile);
+if size(angles, 1) == 1
+    angles = angles';
+end
+if size(angles, 2) == 1
+    angles(:, 2) = 0;
+end
+angles = max(min(round(angles(:, 1:2)), 90), -90);
+
+% Worst case 3 bytes per sample, after the 8 byte header
+out = zeros(1, 8 + 3*size(angles, 1));
+out(1:4) = [hex2dec('4F') hex2dec('52') hex2dec('43') hex2dec('50')];
+out(5:6) = [mod(period, 256) floor(period/256)];
+out(7:8) = 255;
+n = 8;
+last = [0 0];
+for k = 1:size(angles, 1)
+    d = angles(k, :) - last;
+    if all(abs(d) <= 7)
+        n = n + 1;
+        out(n) = (d(1) + 7)*16 + d(2) + 7;
+    else
+        out(n+1:n+3) = [hex2dec('F0') mod(angles(k, :), 256)];
+        n = n + 3;
+    end
+    last = angles(k, :);
+end
+
+if n > hex2dec('20000')
+    error('csv2capture:size', 'Capture does not fit in the 128 KB sector');
+end
+
+fid = fopen(binFile, 'w');
+fwrite(fid, out(1:n), 'uint8');
+fclose(fid);
+fprintf('%d samples, %d bytes\n', size(angles, 1), n);
+
+end